@@ -0,0 +1,129 @@
+/*
+    Benchmark of the lookups in the global lists of Smb4K
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kglobal.h"
+#include "smb4khost.h"
+#include "smb4kshare.h"
+#include "smb4kworkgroup.h"
+
+// Qt includes
+#include <QTest>
+#include <QUrl>
+
+#define WORKGROUP_COUNT 10
+#define HOSTS_PER_WORKGROUP 100
+#define SHARES_PER_HOST 100
+#define LOOKUPS_PER_ITERATION 1000
+
+using namespace Smb4KGlobal;
+
+class Smb4KGlobalBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkFindShare();
+    void benchmarkFindHost();
+    void benchmarkSharedResources();
+    void benchmarkWorkgroupMembers();
+
+private:
+    QList<WorkgroupPtr> m_workgroups;
+    QList<HostPtr> m_hosts;
+    QList<SharePtr> m_shares;
+};
+
+void Smb4KGlobalBenchmark::initTestCase()
+{
+    //
+    // Fill the global lists with 100,000 shares on 1,000 hosts
+    //
+    for (int i = 0; i < WORKGROUP_COUNT; i++) {
+        WorkgroupPtr workgroup = WorkgroupPtr(new Smb4KWorkgroup(QStringLiteral("WORKGROUP%1").arg(i)));
+        QVERIFY(addWorkgroup(workgroup));
+        m_workgroups << workgroup;
+
+        for (int j = 0; j < HOSTS_PER_WORKGROUP; j++) {
+            HostPtr host = HostPtr(new Smb4KHost());
+            host->setHostName(QStringLiteral("HOST%1-%2").arg(i).arg(j));
+            host->setWorkgroupName(workgroup->workgroupName());
+            QVERIFY(addHost(host));
+            m_hosts << host;
+
+            for (int k = 0; k < SHARES_PER_HOST; k++) {
+                SharePtr share = SharePtr(new Smb4KShare());
+                share->setHostName(host->hostName());
+                share->setShareName(QStringLiteral("share%1").arg(k));
+                share->setWorkgroupName(workgroup->workgroupName());
+                QVERIFY(addShare(share));
+                m_shares << share;
+            }
+        }
+    }
+
+    QCOMPARE(sharesList().size(), WORKGROUP_COUNT * HOSTS_PER_WORKGROUP * SHARES_PER_HOST);
+}
+
+void Smb4KGlobalBenchmark::cleanupTestCase()
+{
+    clearSharesList();
+    clearHostsList();
+    clearWorkgroupsList();
+}
+
+void Smb4KGlobalBenchmark::benchmarkFindShare()
+{
+    //
+    // Spread the lookups over the whole list
+    //
+    QList<SharePtr> samples;
+    qsizetype step = m_shares.size() / LOOKUPS_PER_ITERATION;
+
+    for (qsizetype i = 0; i < m_shares.size(); i += step) {
+        samples << m_shares.at(i);
+    }
+
+    QBENCHMARK {
+        for (const SharePtr &share : std::as_const(samples)) {
+            QVERIFY(findShare(share->url(), share->workgroupName()));
+        }
+    }
+}
+
+void Smb4KGlobalBenchmark::benchmarkFindHost()
+{
+    QBENCHMARK {
+        for (const HostPtr &host : std::as_const(m_hosts)) {
+            QVERIFY(findHost(host->hostName(), host->workgroupName()));
+        }
+    }
+}
+
+void Smb4KGlobalBenchmark::benchmarkSharedResources()
+{
+    QBENCHMARK {
+        for (const HostPtr &host : std::as_const(m_hosts)) {
+            QCOMPARE(sharedResources(host).size(), SHARES_PER_HOST);
+        }
+    }
+}
+
+void Smb4KGlobalBenchmark::benchmarkWorkgroupMembers()
+{
+    QBENCHMARK {
+        for (const WorkgroupPtr &workgroup : std::as_const(m_workgroups)) {
+            QCOMPARE(workgroupMembers(workgroup).size(), HOSTS_PER_WORKGROUP);
+        }
+    }
+}
+
+QTEST_MAIN(Smb4KGlobalBenchmark)
+
+#include "smb4kglobalbenchmark.moc"
@@ -0,0 +1,93 @@
+/*
+    Benchmark of the memory used by the network items of Smb4K
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kglobal.h"
+#include "smb4khost.h"
+#include "smb4kshare.h"
+
+// Qt includes
+#include <QTest>
+
+// system includes
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#define HOST_COUNT 1000
+#define SHARES_PER_HOST 100
+
+using namespace Smb4KGlobal;
+
+class Smb4KNetworkItemMemoryBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkShares();
+
+private:
+    static qint64 allocatedBytes();
+};
+
+qint64 Smb4KNetworkItemMemoryBenchmark::allocatedBytes()
+{
+#if defined(__GLIBC__)
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<qint64>(info.uordblks + info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+void Smb4KNetworkItemMemoryBenchmark::benchmarkShares()
+{
+    if (allocatedBytes() < 0) {
+        QSKIP("The heap usage cannot be determined on this system");
+    }
+
+    QList<SharePtr> shares;
+    shares.reserve(HOST_COUNT * SHARES_PER_HOST);
+
+    //
+    // Create 100,000 shares the way the client does when it browses the
+    // network neighborhood. The icons are not included.
+    //
+    qint64 before = allocatedBytes();
+
+    for (int i = 0; i < HOST_COUNT; i++) {
+        QString hostName = QStringLiteral("HOST%1").arg(i);
+        QString ipAddress = QStringLiteral("192.168.%1.%2").arg(i / 250).arg(i % 250 + 1);
+
+        for (int j = 0; j < SHARES_PER_HOST; j++) {
+            SharePtr share = SharePtr(new Smb4KShare());
+            share->setHostName(hostName);
+            share->setShareName(QStringLiteral("share%1").arg(j));
+            share->setWorkgroupName(QStringLiteral("WORKGROUP"));
+            share->setHostIpAddress(ipAddress);
+            share->setComment(QStringLiteral("Share %1 on %2").arg(j).arg(hostName));
+            share->setShareType(FileShare);
+            shares << share;
+        }
+    }
+
+    //
+    // Compute the derived properties as the views would do
+    //
+    for (const SharePtr &share : std::as_const(shares)) {
+        Q_UNUSED(share->displayString());
+        Q_UNUSED(share->isHidden());
+    }
+
+    qint64 after = allocatedBytes();
+
+    QTest::setBenchmarkResult(static_cast<qreal>(after - before), QTest::BytesAllocated);
+}
+
+QTEST_MAIN(Smb4KNetworkItemMemoryBenchmark)
+
+#include "smb4knetworkitemmemorybenchmark.moc"
@@ -2,7 +2,7 @@
     This class provides the basic network item for the core library of
     Smb4K.
 
-    SPDX-FileCopyrightText: 2009-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2009-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -11,28 +11,62 @@
 
 // Qt includes
 #include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
 #include <QtGlobal>
 
+// KDE includes
+#include <KIconLoader>
+
 using namespace Smb4KGlobal;
 
+#define STRING_POOL_PRUNE_THRESHOLD 64
+
 class Smb4KBasicNetworkItemPrivate
 {
 public:
-    NetworkItem type;
-    QIcon icon;
     QUrl url;
-    bool dnsDiscovered;
+    QIcon icon;
     QString comment;
+    mutable QString key;
+    mutable size_t keyHash;
+    NetworkItem type;
+    bool dnsDiscovered : 1;
+    bool stale : 1;
+    mutable bool keyValid;
+};
+
+class Smb4KIconCache
+{
+public:
+    QHash<QString, QIcon> icons;
+    QMutex mutex;
 };
 
+Q_GLOBAL_STATIC(Smb4KIconCache, iconCache);
+
+class Smb4KStringPool
+{
+public:
+    QSet<QString> strings;
+    qsizetype pruneThreshold = STRING_POOL_PRUNE_THRESHOLD;
+    QMutex mutex;
+};
+
+Q_GLOBAL_STATIC(Smb4KStringPool, stringPool);
+
 Smb4KBasicNetworkItem::Smb4KBasicNetworkItem(NetworkItem type)
     : d(new Smb4KBasicNetworkItemPrivate)
 {
     d->type = type;
     d->dnsDiscovered = false;
+    d->stale = false;
+    d->keyHash = 0;
+    d->keyValid = false;
 
     pUrl = &d->url;
-    pIcon = &d->icon;
     pComment = &d->comment;
     pType = &d->type;
 }
@@ -43,7 +77,6 @@ Smb4KBasicNetworkItem::Smb4KBasicNetworkItem(const Smb4KBasicNetworkItem &item)
     *d = *item.d;
 
     pUrl = &d->url;
-    pIcon = &d->icon;
     pComment = &d->comment;
     pType = &d->type;
 }
@@ -72,6 +105,60 @@ QIcon Smb4KBasicNetworkItem::icon() const
     return d->icon;
 }
 
+QIcon Smb4KBasicNetworkItem::cachedIcon(const QString &name, const QStringList &overlays)
+{
+    QString key = overlays.isEmpty() ? name : name + QStringLiteral("|") + overlays.join(QStringLiteral("|"));
+
+    QMutexLocker locker(&iconCache->mutex);
+
+    auto it = iconCache->icons.constFind(key);
+
+    if (it != iconCache->icons.constEnd()) {
+        return *it;
+    }
+
+    //
+    // The icon engine of KDE::icon() follows changes of the icon theme,
+    // so the cached icons do not need to be reloaded.
+    //
+    QIcon icon = KDE::icon(name, overlays);
+    iconCache->icons.insert(key, icon);
+
+    return icon;
+}
+
+QString Smb4KBasicNetworkItem::internedString(const QString &string)
+{
+    if (string.isEmpty()) {
+        return QString();
+    }
+
+    QMutexLocker locker(&stringPool->mutex);
+
+    auto it = stringPool->strings.constFind(string);
+
+    if (it != stringPool->strings.constEnd()) {
+        return *it;
+    }
+
+    //
+    // Drop the strings that are not used by any item anymore before the
+    // pool grows. The threshold is doubled with the remaining size, so
+    // that the pool is only swept after it grew considerably.
+    //
+    if (stringPool->strings.size() >= stringPool->pruneThreshold) {
+        stringPool->strings.removeIf([](const QString &pooled) {
+            return !pooled.data_ptr().isShared();
+        });
+
+        stringPool->pruneThreshold = qMax<qsizetype>(STRING_POOL_PRUNE_THRESHOLD, 2 * stringPool->strings.size());
+    }
+
+    stringPool->strings.insert(string);
+
+    return string;
+}
+
 void Smb4KBasicNetworkItem::setUrl(const QUrl &url) const
 {
     //
@@ -116,6 +203,8 @@ void Smb4KBasicNetworkItem::setUrl(const QUrl &url) const
 
     d->url = url;
     d->url.setScheme(QStringLiteral("smb"));
+
+    invalidateKey();
 }
 
 QUrl Smb4KBasicNetworkItem::url() const
@@ -148,6 +237,57 @@ bool Smb4KBasicNetworkItem::hasUserInfo() const
     return !d->url.userInfo().isEmpty();
 }
 
+void Smb4KBasicNetworkItem::setStale(bool stale) const
+{
+    d->stale = stale;
+}
+
+bool Smb4KBasicNetworkItem::isStale() const
+{
+    return d->stale;
+}
+
+QString Smb4KBasicNetworkItem::key() const
+{
+    if (!d->keyValid) {
+        d->key = keyForUrl(d->url);
+        d->keyHash = qHash(d->key);
+        d->keyValid = true;
+    }
+
+    return d->key;
+}
+
+size_t Smb4KBasicNetworkItem::keyHash() const
+{
+    if (!d->keyValid) {
+        (void)key();
+    }
+
+    return d->keyHash;
+}
+
+bool Smb4KBasicNetworkItem::hasSameUrl(const Smb4KBasicNetworkItem *item) const
+{
+    Q_ASSERT(item);
+    return keyHash() == item->keyHash() && key() == item->key();
+}
+
+bool Smb4KBasicNetworkItem::hasSameUrl(const QUrl &url) const
+{
+    return key() == keyForUrl(url);
+}
+
+QString Smb4KBasicNetworkItem::keyForUrl(const QUrl &url)
+{
+    return url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort).toCaseFolded();
+}
+
+void Smb4KBasicNetworkItem::invalidateKey() const
+{
+    d->keyValid = false;
+}
+
 Smb4KBasicNetworkItem &Smb4KBasicNetworkItem::operator=(const Smb4KBasicNetworkItem &other)
 {
     *d = *other.d;
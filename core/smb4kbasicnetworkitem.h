@@ -2,7 +2,7 @@
     This class provides the basic network item for the core library of
     Smb4K.
 
-    SPDX-FileCopyrightText: 2009-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2009-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -18,6 +18,7 @@
 #include <QMetaType>
 #include <QScopedPointer>
 #include <QString>
+#include <QStringList>
 #include <QUrl>
 
 // forward declarations
@@ -65,20 +66,22 @@ public:
     Smb4KGlobal::NetworkItem type() const;
 
     /**
-     * This function sets the icon of the network item.
+     * This function sets the icon of the network item. It overrides the
+     * icon that is derived from the state of the item.
      *
      * @param icon          The icon
      */
     void setIcon(const QIcon &icon) const;
 
     /**
-     * This function returns the icon of the network item. By default, it
-     * is the null icon. You must set the appropriate icon either in
-     * a class that inherits this one or from somewhere else.
+     * This function returns the icon of the network item. Classes that
+     * inherit this one derive the icon from their state and take it from
+     * a process-wide cache, so that items with the same state share one
+     * icon. Here, the icon set with setIcon() or the null icon is returned.
      *
      * @returns the network item's icon.
      */
-    QIcon icon() const;
+    virtual QIcon icon() const;
 
     /**
      * Set the URL for this network item.
@@ -130,6 +133,69 @@ public:
      */
     bool hasUserInfo() const;
 
+    /**
+     * Mark this network item as stale. A network item is stale, if it was
+     * loaded from the browse cache and not confirmed by a scan yet.
+     *
+     * @param stale         Set this to TRUE if the network item is stale
+     */
+    void setStale(bool stale) const;
+
+    /**
+     * Return TRUE if the network item is stale and FALSE otherwise.
+     *
+     * @returns TRUE if the network item is stale
+     */
+    bool isStale() const;
+
+    /**
+     * Return the canonical key of this network item. It is the case folded
+     * URL without user info and port, so that two network items with the same
+     * key represent the same workgroup, host or share. The key is cached and
+     * only recomputed after the URL changed.
+     *
+     * @returns the canonical key
+     */
+    QString key() const;
+
+    /**
+     * Return the hash of the canonical key. It is cached like the key itself.
+     *
+     * @returns the hash of the canonical key
+     */
+    size_t keyHash() const;
+
+    /**
+     * Returns TRUE if @p item has the same canonical key as this network item.
+     * This is the cheap replacement for the case insensitive comparison of the
+     * URLs without user info and port.
+     *
+     * @param item          The other network item
+     *
+     * @returns TRUE if both network items have the same key
+     */
+    bool hasSameUrl(const Smb4KBasicNetworkItem *item) const;
+
+    /**
+     * Returns TRUE if the canonical key of @p url equals the key of this
+     * network item.
+     *
+     * @param url           The URL
+     *
+     * @returns TRUE if the URL matches
+     */
+    bool hasSameUrl(const QUrl &url) const;
+
+    /**
+     * Return the canonical key for the URL @p url. Use this function to
+     * compare URLs that do not belong to a network item.
+     *
+     * @param url           The URL
+     *
+     * @returns the canonical key
+     */
+    static QString keyForUrl(const QUrl &url);
+
     /**
      * Copy assignment operator
      */
@@ -141,11 +207,6 @@ protected:
      */
     QUrl *pUrl;
 
-    /**
-     * Expose a pointer to the private icon variable.
-     */
-    QIcon *pIcon;
-
     /**
      * Expose a pointer to the private comment variable.
      */
@@ -156,6 +217,38 @@ protected:
      */
     Smb4KGlobal::NetworkItem *pType;
 
+    /**
+     * Invalidate the cached canonical key. This function must be called
+     * after the URL was changed through the pUrl pointer. Reimplement it
+     * to also drop other values that are derived from the URL.
+     */
+    virtual void invalidateKey() const;
+
+    /**
+     * Return the icon @p name with the overlays @p overlays from the
+     * process-wide icon cache. The icon is only loaded the first time it
+     * is requested. This function is thread-safe.
+     *
+     * @param name          The name of the icon
+     * @param overlays      The overlays
+     *
+     * @returns the icon.
+     */
+    static QIcon cachedIcon(const QString &name, const QStringList &overlays = QStringList());
+
+    /**
+     * Return a copy of @p string that shares its data with all other
+     * strings of the same content that were passed to this function.
+     * Use it for values like workgroup names that are repeated across
+     * many network items. Strings that are not used anymore are dropped
+     * from the pool when it grows. This function is thread-safe.
+     *
+     * @param string        The string
+     *
+     * @returns the shared copy of the string.
+     */
+    static QString internedString(const QString &string);
+
 private:
     const QScopedPointer<Smb4KBasicNetworkItemPrivate> d;
 };
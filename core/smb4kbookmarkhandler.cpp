@@ -131,14 +131,13 @@ BookmarkPtr Smb4KBookmarkHandler::findBookmarkByUrl(const QUrl &url)
     QList<BookmarkPtr> temporalBookmarkList = bookmarkList();
 
     if (!url.isEmpty() && url.isValid() && !temporalBookmarkList.isEmpty()) {
+        QString urlKey = Smb4KBasicNetworkItem::keyForUrl(url);
+
         for (const BookmarkPtr &b : std::as_const(temporalBookmarkList)) {
             // NOTE: Since also user provided URLs can be bookmarked, we cannot use
             // QUrl::matches() here, because it does not allow for case insensitive
             // comparison.
-            if (QString::compare(url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 b->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                == 0) {
+            if (Smb4KBasicNetworkItem::keyForUrl(b->url()) == urlKey) {
                 bookmark = b;
                 break;
             }
@@ -244,15 +243,13 @@ bool Smb4KBookmarkHandler::remove(const BookmarkPtr &bookmark)
 {
     bool removedBookmark = false;
     QMutableListIterator<BookmarkPtr> it(d->bookmarks);
+    QString bookmarkKey = Smb4KBasicNetworkItem::keyForUrl(bookmark->url());
 
     while (it.hasNext()) {
         BookmarkPtr b = it.next();
 
         if ((!Smb4KSettings::useProfiles() || b->profile() == Smb4KProfileManager::self()->activeProfile())
-            && QString::compare(bookmark->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                b->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                Qt::CaseInsensitive)
-                == 0
+            && Smb4KBasicNetworkItem::keyForUrl(b->url()) == bookmarkKey
             && bookmark->categoryName() == b->categoryName()) {
             it.remove();
             removedBookmark = true;
@@ -0,0 +1,226 @@
+/*
+    Batched change notifications for the network neighborhood and the
+    mounted shares
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kchangenotifier.h"
+#include "smb4kbasicnetworkitem.h"
+#include "smb4kshare.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+
+// std includes
+#include <algorithm>
+
+struct Smb4KChangeNotifierBatch {
+    QSet<NetworkItemPtr> added;
+    QSet<NetworkItemPtr> removed;
+    QHash<NetworkItemPtr, int> changed;
+};
+
+class Smb4KChangeNotifierPrivate
+{
+public:
+    Smb4KChangeNotifierBatch batches[2];
+    bool flushScheduled;
+    QMutex mutex;
+};
+
+class Smb4KChangeNotifierStatic
+{
+public:
+    Smb4KChangeNotifier instance;
+};
+
+Q_GLOBAL_STATIC(Smb4KChangeNotifierStatic, p);
+
+//
+// Sort the items, so that workgroups come before hosts and hosts
+// before shares (or the other way round).
+//
+static QList<NetworkItemPtr> sortedItems(const QSet<NetworkItemPtr> &items, bool parentsFirst)
+{
+    QList<NetworkItemPtr> list(items.begin(), items.end());
+
+    std::stable_sort(list.begin(), list.end(), [parentsFirst](const NetworkItemPtr &a, const NetworkItemPtr &b) {
+        return parentsFirst ? a->type() < b->type() : a->type() > b->type();
+    });
+
+    return list;
+}
+
+static QList<SharePtr> sharesFromItems(const QSet<NetworkItemPtr> &items)
+{
+    QList<SharePtr> shares;
+    shares.reserve(items.size());
+
+    for (const NetworkItemPtr &item : items) {
+        shares << item.staticCast<Smb4KShare>();
+    }
+
+    return shares;
+}
+
+Smb4KChangeNotifier::Smb4KChangeNotifier(QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KChangeNotifierPrivate)
+{
+    d->flushScheduled = false;
+
+    //
+    // The batches are always emitted in the main thread, regardless of
+    // the thread that created this object first.
+    //
+    if (QCoreApplication::instance() && thread() != QCoreApplication::instance()->thread()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+Smb4KChangeNotifier::~Smb4KChangeNotifier()
+{
+}
+
+Smb4KChangeNotifier *Smb4KChangeNotifier::self()
+{
+    return &p->instance;
+}
+
+void Smb4KChangeNotifier::postAdded(List list, const NetworkItemPtr &item)
+{
+    if (!item) {
+        return;
+    }
+
+    QMutexLocker locker(&d->mutex);
+
+    Smb4KChangeNotifierBatch &batch = d->batches[list];
+
+    //
+    // An item that was removed and added again within the same batch
+    // is reported as changed.
+    //
+    if (batch.removed.remove(item)) {
+        batch.changed[item] |= Smb4KGlobal::AllFields;
+    } else {
+        batch.added << item;
+    }
+
+    scheduleFlush();
+}
+
+void Smb4KChangeNotifier::postRemoved(List list, const NetworkItemPtr &item)
+{
+    if (!item) {
+        return;
+    }
+
+    QMutexLocker locker(&d->mutex);
+
+    Smb4KChangeNotifierBatch &batch = d->batches[list];
+
+    batch.changed.remove(item);
+
+    //
+    // An item that was added and removed again within the same batch
+    // is not reported at all.
+    //
+    if (!batch.added.remove(item)) {
+        batch.removed << item;
+    }
+
+    scheduleFlush();
+}
+
+void Smb4KChangeNotifier::postChanged(List list, const NetworkItemPtr &item, int fields)
+{
+    if (!item || fields == Smb4KGlobal::NoField) {
+        return;
+    }
+
+    QMutexLocker locker(&d->mutex);
+
+    Smb4KChangeNotifierBatch &batch = d->batches[list];
+
+    if (!batch.added.contains(item) && !batch.removed.contains(item)) {
+        batch.changed[item] |= fields;
+        scheduleFlush();
+    }
+}
+
+void Smb4KChangeNotifier::scheduleFlush()
+{
+    //
+    // The caller holds the mutex
+    //
+    if (!d->flushScheduled) {
+        d->flushScheduled = true;
+        QMetaObject::invokeMethod(this, &Smb4KChangeNotifier::flush, Qt::QueuedConnection);
+    }
+}
+
+void Smb4KChangeNotifier::flush()
+{
+    Smb4KChangeNotifierBatch networkNeighborhood, mountedShares;
+
+    {
+        QMutexLocker locker(&d->mutex);
+        std::swap(networkNeighborhood, d->batches[NetworkNeighborhood]);
+        std::swap(mountedShares, d->batches[MountedShares]);
+        d->flushScheduled = false;
+    }
+
+    //
+    // Report the removals first, so that views do not end up with
+    // duplicates when an item was replaced.
+    //
+    if (!networkNeighborhood.removed.isEmpty()) {
+        Q_EMIT itemsRemoved(sortedItems(networkNeighborhood.removed, false));
+    }
+
+    if (!networkNeighborhood.added.isEmpty()) {
+        Q_EMIT itemsAdded(sortedItems(networkNeighborhood.added, true));
+    }
+
+    if (!networkNeighborhood.changed.isEmpty()) {
+        QMap<int, QList<NetworkItemPtr>> changedItems;
+
+        for (auto it = networkNeighborhood.changed.cbegin(); it != networkNeighborhood.changed.cend(); ++it) {
+            changedItems[it.value()] << it.key();
+        }
+
+        for (auto it = changedItems.cbegin(); it != changedItems.cend(); ++it) {
+            Q_EMIT itemsChanged(it.value(), it.key());
+        }
+    }
+
+    if (!mountedShares.removed.isEmpty()) {
+        Q_EMIT mountedSharesRemoved(sharesFromItems(mountedShares.removed));
+    }
+
+    if (!mountedShares.added.isEmpty()) {
+        Q_EMIT mountedSharesAdded(sharesFromItems(mountedShares.added));
+    }
+
+    if (!mountedShares.changed.isEmpty()) {
+        QMap<int, QList<SharePtr>> changedShares;
+
+        for (auto it = mountedShares.changed.cbegin(); it != mountedShares.changed.cend(); ++it) {
+            changedShares[it.value()] << it.key().staticCast<Smb4KShare>();
+        }
+
+        for (auto it = changedShares.cbegin(); it != changedShares.cend(); ++it) {
+            Q_EMIT mountedSharesChanged(it.value(), it.key());
+        }
+    }
+}
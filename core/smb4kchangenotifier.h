@@ -0,0 +1,165 @@
+/*
+    Batched change notifications for the network neighborhood and the
+    mounted shares
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KCHANGENOTIFIER_H
+#define SMB4KCHANGENOTIFIER_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+#include "smb4kglobal.h"
+
+// Qt includes
+#include <QList>
+#include <QObject>
+#include <QScopedPointer>
+
+class Smb4KChangeNotifierPrivate;
+
+/**
+ * This class reports the changes made to the lists kept in Smb4KGlobal.
+ * The functions that modify the lists post the changes here. They are
+ * collected and emitted in batches once per iteration of the event loop,
+ * so that views only need to apply the difference instead of rebuilding
+ * themselves from the whole list.
+ *
+ * Changes to the same item within one batch are merged: An item that was
+ * added and changed is only reported as added, an item that was added and
+ * removed again is not reported at all.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.0.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KChangeNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The lists changes are reported for
+     *
+     * @enum NetworkNeighborhood    The workgroups, hosts and shares
+     * @enum MountedShares          The mounted shares
+     */
+    enum List { NetworkNeighborhood, MountedShares };
+
+    /**
+     * The constructor
+     */
+    explicit Smb4KChangeNotifier(QObject *parent = nullptr);
+
+    /**
+     * The destructor
+     */
+    ~Smb4KChangeNotifier();
+
+    /**
+     * The static pointer to this class.
+     * @returns a static pointer to this class
+     */
+    static Smb4KChangeNotifier *self();
+
+    /**
+     * Post that @p item was added to the list @p list.
+     *
+     * This function is thread-safe.
+     *
+     * @param list          The list
+     * @param item          The network item
+     */
+    void postAdded(List list, const NetworkItemPtr &item);
+
+    /**
+     * Post that @p item was removed from the list @p list.
+     *
+     * This function is thread-safe.
+     *
+     * @param list          The list
+     * @param item          The network item
+     */
+    void postRemoved(List list, const NetworkItemPtr &item);
+
+    /**
+     * Post that the properties @p fields of @p item changed. If @p fields
+     * is Smb4KGlobal::NoField, nothing is posted.
+     *
+     * This function is thread-safe.
+     *
+     * @param list          The list
+     * @param item          The network item
+     * @param fields        The changed properties (see Smb4KGlobal::ChangedField)
+     */
+    void postChanged(List list, const NetworkItemPtr &item, int fields);
+
+    /**
+     * Report the posted changes right away instead of in the next iteration
+     * of the event loop. Use this, if the receivers have to be up to date
+     * before a signal that depends on the changes is processed.
+     *
+     * This function must only be called from the main thread.
+     */
+    void flush();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when workgroups, hosts or shares were added
+     * to the network neighborhood. Workgroups are reported before their
+     * members and hosts before their shares.
+     *
+     * @param items         The added network items
+     */
+    void itemsAdded(const QList<NetworkItemPtr> &items);
+
+    /**
+     * This signal is emitted when workgroups, hosts or shares were removed
+     * from the network neighborhood. Shares are reported before their hosts
+     * and hosts before their workgroups.
+     *
+     * @param items         The removed network items
+     */
+    void itemsRemoved(const QList<NetworkItemPtr> &items);
+
+    /**
+     * This signal is emitted when workgroups, hosts or shares in the network
+     * neighborhood changed. Items that share the same set of changed properties
+     * are reported together.
+     *
+     * @param items         The changed network items
+     * @param fields        The changed properties (see Smb4KGlobal::ChangedField)
+     */
+    void itemsChanged(const QList<NetworkItemPtr> &items, int fields);
+
+    /**
+     * This signal is emitted when shares were added to the list of mounted shares.
+     *
+     * @param shares        The added shares
+     */
+    void mountedSharesAdded(const QList<SharePtr> &shares);
+
+    /**
+     * This signal is emitted when shares were removed from the list of mounted shares.
+     *
+     * @param shares        The removed shares
+     */
+    void mountedSharesRemoved(const QList<SharePtr> &shares);
+
+    /**
+     * This signal is emitted when mounted shares changed. Shares that share
+     * the same set of changed properties are reported together.
+     *
+     * @param shares        The changed shares
+     * @param fields        The changed properties (see Smb4KGlobal::ChangedField)
+     */
+    void mountedSharesChanged(const QList<SharePtr> &shares, int fields);
+
+private:
+    void scheduleFlush();
+    const QScopedPointer<Smb4KChangeNotifierPrivate> d;
+};
+
+#endif
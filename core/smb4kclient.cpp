@@ -14,15 +14,23 @@
 #include "smb4kcustomsettingsmanager.h"
 #include "smb4khardwareinterface.h"
 #include "smb4khomesshareshandler.h"
+#include "smb4khostresolver.h"
 #include "smb4knotification.h"
 #include "smb4ksettings.h"
+#include "smb4kwakeonlan.h"
 
 // Qt includes
 #include <QApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
 #include <QHostAddress>
 #include <QPointer>
 #include <QTimer>
-#include <QUdpSocket>
+
+#define BROWSE_CACHE_MAGIC 0x534D4243
+#define BROWSE_CACHE_VERSION 2
 
 using namespace Smb4KGlobal;
 
@@ -32,8 +40,19 @@ Smb4KClient::Smb4KClient(QObject *parent)
     : KCompositeJob(parent)
     , d(new Smb4KClientPrivate)
 {
+    d->searchRunning = false;
+    d->browseCacheLoaded = false;
+
     connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Smb4KClient::slotAboutToQuit);
     connect(Smb4KCredentialsManager::self(), &Smb4KCredentialsManager::credentialsUpdated, this, &Smb4KClient::slotCredentialsUpdated);
+
+    //
+    // Make sure the host resolver lives in the main thread. It is also
+    // used by the lookups running in the thread pool.
+    //
+    (void)Smb4KHostResolver::self();
+
+    connect(Smb4KWakeOnLan::self(), &Smb4KWakeOnLan::hostWokenUp, this, &Smb4KClient::slotHostWokenUp);
 }
 
 Smb4KClient::~Smb4KClient()
@@ -52,6 +71,32 @@ void Smb4KClient::start()
     //
     connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::onlineStateChanged, this, &Smb4KClient::slotOnlineStateChanged, Qt::UniqueConnection);
 
+    //
+    // Show the network neighborhood known from the last session right
+    // away. It is marked stale until the scan confirms it.
+    //
+    if (Smb4KSettings::useBrowseCache() && !d->browseCacheLoaded) {
+        d->browseCacheLoaded = true;
+
+        if (workgroupsList().isEmpty() && readBrowseCache()) {
+            Q_EMIT workgroups();
+
+            const QList<WorkgroupPtr> knownWorkgroups = workgroupsList();
+
+            for (const WorkgroupPtr &workgroup : knownWorkgroups) {
+                Q_EMIT hosts(workgroup);
+            }
+
+            const QList<HostPtr> knownHosts = hostsList();
+
+            for (const HostPtr &host : knownHosts) {
+                if (!sharedResources(host).isEmpty()) {
+                    Q_EMIT shares(host);
+                }
+            }
+        }
+    }
+
     //
     // Start the scanning
     //
@@ -67,6 +112,30 @@ bool Smb4KClient::isRunning()
 
 void Smb4KClient::abort()
 {
+    //
+    // Stop a running search
+    //
+    if (d->searchRunning) {
+        d->searchQueue.clear();
+        d->queuedSearchHosts.clear();
+        d->searchHosts.clear();
+        d->searchRunning = false;
+
+        Q_EMIT finished(d->searchNetworkItem, NetworkSearch);
+        d->searchNetworkItem.clear();
+    }
+
+    //
+    // Do not start the domain lookups when the hosts that are being
+    // woken up answer
+    //
+    if (!d->wakeUpKeys.isEmpty()) {
+        d->wakeUpKeys.clear();
+
+        Q_EMIT finished(d->wakeUpItem, WakeUp);
+        d->wakeUpItem.clear();
+    }
+
     QListIterator<KJob *> it(subjobs());
 
     while (it.hasNext()) {
@@ -77,64 +146,51 @@ void Smb4KClient::abort()
 void Smb4KClient::lookupDomains()
 {
     //
-    // Send Wakeup-On-LAN packets
+    // Do not start a second lookup while the hosts are being woken up.
+    // The domains will be looked up when this is finished.
+    //
+    if (!d->wakeUpKeys.isEmpty()) {
+        return;
+    }
+
+    //
+    // Send Wakeup-On-LAN packets to all hosts at once. The lookup
+    // starts when all of them answered or the waiting time passed.
     //
     if (Smb4KSettings::enableWakeOnLAN()) {
         QList<CustomSettingsPtr> wakeOnLanEntries = Smb4KCustomSettingsManager::self()->wakeOnLanEntries();
+        QList<QPair<QString, QHostAddress>> wakeUpTargets;
 
-        if (!wakeOnLanEntries.isEmpty()) {
-            NetworkItemPtr item = NetworkItemPtr(new Smb4KBasicNetworkItem());
-            Q_EMIT aboutToStart(item, WakeUp);
-
-            QUdpSocket *socket = new QUdpSocket(this);
-
-            for (int i = 0; i < wakeOnLanEntries.size(); ++i) {
-                if (wakeOnLanEntries.at(i)->wakeOnLanSendBeforeNetworkScan()) {
-                    QHostAddress addr;
-
-                    if (wakeOnLanEntries.at(i)->hasIpAddress()) {
-                        addr.setAddress(wakeOnLanEntries.at(i)->ipAddress());
-                    } else {
-                        addr.setAddress(QStringLiteral("255.255.255.255"));
-                    }
-
-                    // Construct magic sequence
-                    QByteArray sequence;
-
-                    // 6 times 0xFF
-                    for (int j = 0; j < 6; ++j) {
-                        sequence.append(QChar(0xFF).toLatin1());
-                    }
-
-                    // 16 times the MAC address
-                    QStringList parts = wakeOnLanEntries.at(i)->macAddress().split(QStringLiteral(":"), Qt::SkipEmptyParts);
-
-                    for (int j = 0; j < 16; ++j) {
-                        for (int k = 0; k < parts.size(); ++k) {
-                            QString item = QStringLiteral("0x") + parts.at(k);
-                            sequence.append(QChar(item.toInt(nullptr, 16)).toLatin1());
-                        }
-                    }
+        for (const CustomSettingsPtr &entry : std::as_const(wakeOnLanEntries)) {
+            if (entry->wakeOnLanSendBeforeNetworkScan()) {
+                QHostAddress addr;
 
-                    socket->writeDatagram(sequence, addr, 9);
+                if (entry->hasIpAddress()) {
+                    addr.setAddress(entry->ipAddress());
                 }
-            }
 
-            delete socket;
+                wakeUpTargets << qMakePair(entry->macAddress(), addr);
+                d->wakeUpKeys << Smb4KWakeOnLan::wakeUpKey(entry->macAddress(), addr);
+            }
+        }
 
-            // Wait the defined time
-            int stop = 1000 * Smb4KSettings::wakeOnLANWaitingTime() / 250;
-            int i = 0;
+        if (!wakeUpTargets.isEmpty()) {
+            d->wakeUpItem = NetworkItemPtr(new Smb4KBasicNetworkItem());
+            Q_EMIT aboutToStart(d->wakeUpItem, WakeUp);
 
-            while (i++ < stop) {
-                wait(250);
+            for (const QPair<QString, QHostAddress> &target : std::as_const(wakeUpTargets)) {
+                Smb4KWakeOnLan::self()->wakeUp(target.first, target.second);
             }
 
-            Q_EMIT finished(item, WakeUp);
-            item.clear();
+            return;
         }
     }
 
+    startDomainLookups();
+}
+
+void Smb4KClient::startDomainLookups()
+{
     //
     // Emit the aboutToStart() signal
     //
@@ -333,6 +389,8 @@ void Smb4KClient::lookupFiles(const NetworkItemPtr &item)
         job->setNetworkItem(item);
         job->setProcess(LookupFiles);
 
+        connect(job, &Smb4KClientJob::filesReceived, this, &Smb4KClient::slotFilesReceived);
+
         if (!hasSubjobs()) {
             QApplication::setOverrideCursor(Qt::BusyCursor);
         }
@@ -387,61 +445,30 @@ void Smb4KClient::printFile(const SharePtr &share, const KFileItem &fileItem, in
 void Smb4KClient::search(const QString &item)
 {
     //
-    // Create empty basic network item
-    //
-    NetworkItemPtr networkItem = NetworkItemPtr(new Smb4KBasicNetworkItem());
-
-    //
-    // Emit the aboutToStart() signal
+    // Cancel a search that is still running
     //
-    Q_EMIT aboutToStart(networkItem, NetworkSearch);
-
-    //
-    // Before doing the search, lookup all domains, servers and shares in the
-    // network neighborhood.
-    //
-    lookupDomains();
-
-    while (isRunning()) {
-        wait(50);
-    }
-
-    for (const WorkgroupPtr &workgroup : workgroupsList()) {
-        lookupDomainMembers(workgroup);
-
-        while (isRunning()) {
-            wait(50);
-        }
+    if (d->searchRunning) {
+        abort();
     }
 
-    for (const HostPtr &host : hostsList()) {
-        lookupShares(host);
-
-        while (isRunning()) {
-            wait(50);
-        }
-    }
+    d->searchRunning = true;
+    d->searchItem = item;
 
     //
-    // Do the actual search
+    // Create empty basic network item
     //
-    QList<SharePtr> results;
-
-    for (const SharePtr &share : sharesList()) {
-        if (share->shareName().contains(item, Qt::CaseInsensitive)) {
-            results << share;
-        }
-    }
+    d->searchNetworkItem = NetworkItemPtr(new Smb4KBasicNetworkItem());
 
     //
-    // Emit the search results
+    // Emit the aboutToStart() signal
     //
-    Q_EMIT searchResults(results);
+    Q_EMIT aboutToStart(d->searchNetworkItem, NetworkSearch);
 
     //
-    // Emit the finished() signal
+    // Before doing the search, lookup all domains in the network neighborhood.
+    // Everything else is done in processSearch() when the jobs finished.
     //
-    Q_EMIT finished(networkItem, NetworkSearch);
+    lookupDomains();
 }
 
 void Smb4KClient::processErrors(Smb4KClientBaseJob *job)
@@ -499,6 +526,12 @@ void Smb4KClient::processErrors(Smb4KClientBaseJob *job)
 
         break;
     }
+    case KJob::KilledJobError: {
+        //
+        // The job was aborted by the user or because the network went down
+        //
+        break;
+    }
     default: {
         Smb4KNotification::networkCommunicationFailed(job->errorText());
         break;
@@ -511,13 +544,13 @@ void Smb4KClient::processWorkgroups(Smb4KClientBaseJob *job)
     //
     // Collect the workgroups found while scanning
     //
-    QList<WorkgroupPtr> discoveredWorkgroups = job->workgroups();
+    const QList<Smb4KWorkgroupRecord> discoveredWorkgroups = job->workgroups();
 
-    for (const WorkgroupPtr &newWorkgroup : std::as_const(discoveredWorkgroups)) {
+    for (const Smb4KWorkgroupRecord &newWorkgroup : discoveredWorkgroups) {
         bool foundWorkgroup = false;
 
-        for (const WorkgroupPtr &workgroup : std::as_const(d->tempWorkgroupList)) {
-            if (workgroup->workgroupName() == newWorkgroup->workgroupName()) {
+        for (const Smb4KWorkgroupRecord &workgroup : std::as_const(d->tempWorkgroupList)) {
+            if (QString::compare(workgroup.workgroupName, newWorkgroup.workgroupName, Qt::CaseInsensitive) == 0) {
                 foundWorkgroup = true;
                 break;
             }
@@ -531,72 +564,123 @@ void Smb4KClient::processWorkgroups(Smb4KClientBaseJob *job)
     //
     // When scanning finished, process the workgroups
     //
-    if (!isRunning()) {
-        // Remove obsolete workgroups and their members
-        QListIterator<WorkgroupPtr> it(workgroupsList());
-
-        while (it.hasNext()) {
-            WorkgroupPtr workgroup = it.next();
+    if (!hasRunningJobs(LookupDomains)) {
+        // Remove obsolete workgroups and their members. The names are compared
+        // case insensitively, because the workgroup names are upper case.
+        QSet<QString> workgroupNames;
 
-            bool foundWorkgroup = false;
-
-            for (const WorkgroupPtr &w : std::as_const(d->tempWorkgroupList)) {
-                if (w->workgroupName() == workgroup->workgroupName()) {
-                    foundWorkgroup = true;
-                    break;
-                }
-            }
-
-            if (!foundWorkgroup) {
-                QList<HostPtr> obsoleteHosts = workgroupMembers(workgroup);
+        for (const Smb4KWorkgroupRecord &record : std::as_const(d->tempWorkgroupList)) {
+            workgroupNames << record.workgroupName.toCaseFolded();
+        }
 
-                while (!obsoleteHosts.isEmpty()) {
-                    removeHost(obsoleteHosts.takeFirst());
-                }
+        const QList<WorkgroupPtr> workgroups = workgroupsList();
 
+        for (const WorkgroupPtr &workgroup : workgroups) {
+            if (!workgroupNames.contains(workgroup->workgroupName().toCaseFolded())) {
+                removeWorkgroupMembers(workgroup);
                 removeWorkgroup(workgroup);
             }
         }
 
-        // Add new workgroups and update existing ones
-        for (const WorkgroupPtr &workgroup : std::as_const(d->tempWorkgroupList)) {
-            if (!findWorkgroup(workgroup->workgroupName())) {
+        // Add new workgroups and update existing ones in place
+        for (const Smb4KWorkgroupRecord &record : std::as_const(d->tempWorkgroupList)) {
+            WorkgroupPtr workgroup = findWorkgroup(record.workgroupName);
+
+            if (!workgroup) {
+                workgroup = WorkgroupPtr(new Smb4KWorkgroup());
+                workgroup->setWorkgroupName(record.workgroupName);
+                workgroup->setMasterBrowserName(record.masterBrowserName);
+                workgroup->setMasterBrowserIpAddress(record.masterBrowserIpAddress);
+                workgroup->setDnsDiscovered(record.dnsDiscovered);
+
                 addWorkgroup(workgroup);
 
                 // Since this is a new workgroup, no master browser is present.
                 HostPtr masterBrowser = HostPtr(new Smb4KHost());
-                masterBrowser->setWorkgroupName(workgroup->workgroupName());
-                masterBrowser->setHostName(workgroup->masterBrowserName());
-                masterBrowser->setIpAddress(workgroup->masterBrowserIpAddress());
+                masterBrowser->setWorkgroupName(record.workgroupName);
+                masterBrowser->setHostName(record.masterBrowserName);
+                masterBrowser->setIpAddress(record.masterBrowserIpAddress);
                 masterBrowser->setIsMasterBrowser(true);
 
                 addHost(masterBrowser);
             } else {
-                updateWorkgroup(workgroup);
+                modifyWorkgroup(workgroup, [&record](Smb4KWorkgroup *w) {
+                    int fields = NoField;
+
+                    if (QString::compare(w->masterBrowserName(), record.masterBrowserName, Qt::CaseInsensitive) != 0) {
+                        w->setMasterBrowserName(record.masterBrowserName);
+                        fields |= MasterBrowserField;
+                    }
+
+                    if (w->masterBrowserIpAddress() != record.masterBrowserIpAddress.toString()) {
+                        w->setMasterBrowserIpAddress(record.masterBrowserIpAddress.toString());
+                        fields |= MasterBrowserField;
+                    }
+
+                    if (w->isStale()) {
+                        w->setStale(false);
+                        fields |= StaleField;
+                    }
+
+                    //
+                    // The flag might have been loaded from the browse cache. It
+                    // is not shown, so the change is not reported.
+                    //
+                    if (w->dnsDiscovered() != record.dnsDiscovered) {
+                        w->setDnsDiscovered(record.dnsDiscovered);
+                    }
+
+                    return fields;
+                });
 
                 // Check if the master browser changed
-                QList<HostPtr> members = workgroupMembers(workgroup);
+                const QList<HostPtr> members = workgroupMembers(workgroup);
 
-                for (const HostPtr &host : std::as_const(members)) {
-                    if (workgroup->masterBrowserName() == host->hostName()) {
-                        host->setIsMasterBrowser(true);
+                for (const HostPtr &host : members) {
+                    bool isMasterBrowser = (QString::compare(record.masterBrowserName, host->hostName(), Qt::CaseInsensitive) == 0);
 
-                        if (!host->hasIpAddress() && workgroup->hasMasterBrowserIpAddress()) {
-                            host->setIpAddress(workgroup->masterBrowserIpAddress());
+                    modifyHost(host, [&record, isMasterBrowser](Smb4KHost *h) {
+                        int fields = NoField;
+
+                        if (h->isMasterBrowser() != isMasterBrowser) {
+                            h->setIsMasterBrowser(isMasterBrowser);
+                            fields |= MasterBrowserField;
                         }
-                    } else {
-                        host->setIsMasterBrowser(false);
-                    }
+
+                        if (isMasterBrowser && !h->hasIpAddress() && !record.masterBrowserIpAddress.isNull()) {
+                            h->setIpAddress(record.masterBrowserIpAddress);
+                            fields |= IpAddressField;
+                        }
+
+                        return fields;
+                    });
                 }
             }
         }
 
         // Clear the temporary workgroup list
-        while (!d->tempWorkgroupList.isEmpty()) {
-            d->tempWorkgroupList.takeFirst().clear();
-        }
+        d->tempWorkgroupList.clear();
 
         Q_EMIT workgroups();
+
+        // Confirm the members of the workgroups that were loaded from the browse cache
+        const QList<WorkgroupPtr> knownWorkgroups = workgroupsList();
+
+        for (const WorkgroupPtr &workgroup : knownWorkgroups) {
+            // The search might already have started a lookup of the members
+            if (hasRunningJobs(LookupDomainMembers, workgroup)) {
+                continue;
+            }
+
+            QList<HostPtr> members = workgroupMembers(workgroup);
+
+            for (const HostPtr &host : std::as_const(members)) {
+                if (host->isStale()) {
+                    lookupDomainMembers(workgroup);
+                    break;
+                }
+            }
+        }
     }
 }
 
@@ -607,20 +691,25 @@ void Smb4KClient::processHosts(Smb4KClientBaseJob *job)
     // insertion of hosts with a real workgroup/domain over
     // the ones with the DNS-SD domain (e.g. LOCAL).
     //
-    QList<HostPtr> discoveredHosts = job->hosts();
+    // Several workgroups might be scanned at the same time, so the hosts
+    // are collected per workgroup.
+    //
+    const QList<Smb4KHostRecord> discoveredHosts = job->hosts();
+    QString workgroupKey = job->networkItem()->url().host().toUpper();
+    QList<Smb4KHostRecord> &tempHostList = d->tempHostLists[workgroupKey];
 
-    for (const HostPtr &newHost : std::as_const(discoveredHosts)) {
+    for (const Smb4KHostRecord &newHost : discoveredHosts) {
         bool foundHost = false;
 
-        QMutableListIterator<HostPtr> it(d->tempHostList);
+        QMutableListIterator<Smb4KHostRecord> it(tempHostList);
 
         while (it.hasNext()) {
-            HostPtr host = static_cast<HostPtr>(it.next());
+            const Smb4KHostRecord &host = it.next();
 
-            if (newHost->url().matches(host->url(), QUrl::RemoveUserInfo | QUrl::RemovePort)) {
-                if (newHost->workgroupName() == host->workgroupName()) {
+            if (QString::compare(newHost.hostName, host.hostName, Qt::CaseInsensitive) == 0) {
+                if (QString::compare(newHost.workgroupName, host.workgroupName, Qt::CaseInsensitive) == 0) {
                     foundHost = true;
-                } else if (host->dnsDiscovered()) {
+                } else if (host.dnsDiscovered) {
                     it.remove();
                 }
 
@@ -629,66 +718,98 @@ void Smb4KClient::processHosts(Smb4KClientBaseJob *job)
         }
 
         if (!foundHost) {
-            d->tempHostList << newHost;
+            tempHostList << newHost;
         }
     }
 
     //
-    // When scanning finished, process the hosts
+    // When scanning this workgroup finished, process the hosts
     //
-    if (!isRunning()) {
-        // Get the workgroup pointer. Although several scans might have been
-        // running, the workgroup should have been always the same.
+    if (!hasRunningJobs(LookupDomainMembers, job->networkItem())) {
+        // Get the workgroup pointer
         WorkgroupPtr workgroup = job->networkItem().staticCast<Smb4KWorkgroup>();
 
-        // Remove obsolete workgroup/domain members
-        QList<HostPtr> members = workgroupMembers(workgroup);
-        QListIterator<HostPtr> it(members);
-
-        while (it.hasNext()) {
-            HostPtr host = it.next();
+        // Remove obsolete workgroup/domain members. The names are compared
+        // case insensitively, because the host and workgroup names are upper
+        // case.
+        QSet<QString> hostKeys;
 
-            bool foundHost = false;
-
-            for (const HostPtr &h : std::as_const(d->tempHostList)) {
-                if (h->workgroupName() == host->workgroupName() && h->hostName() == host->hostName()) {
-                    foundHost = true;
-                    break;
-                }
-            }
+        for (const Smb4KHostRecord &record : std::as_const(tempHostList)) {
+            hostKeys << (record.workgroupName + QStringLiteral("/") + record.hostName).toCaseFolded();
+        }
 
-            if (!foundHost) {
-                QList<SharePtr> obsoleteShares = sharedResources(host);
-
-                while (!obsoleteShares.isEmpty()) {
-                    removeShare(obsoleteShares.takeFirst());
-                }
+        const QList<HostPtr> members = workgroupMembers(workgroup);
 
+        for (const HostPtr &host : members) {
+            if (!hostKeys.contains((host->workgroupName() + QStringLiteral("/") + host->hostName()).toCaseFolded())) {
+                removeSharedResources(host);
                 removeHost(host);
             }
         }
 
-        // Add new hosts and update existing ones
-        for (const HostPtr &host : std::as_const(d->tempHostList)) {
-            if (host->hostName() == workgroup->masterBrowserName()) {
-                host->setIsMasterBrowser(true);
-            } else {
-                host->setIsMasterBrowser(false);
-            }
+        // Add new hosts and update existing ones in place
+        for (const Smb4KHostRecord &record : std::as_const(tempHostList)) {
+            bool isMasterBrowser = (QString::compare(record.hostName, workgroup->masterBrowserName(), Qt::CaseInsensitive) == 0);
+            HostPtr host = findHost(record.hostName, record.workgroupName);
+
+            if (!host) {
+                host = HostPtr(new Smb4KHost());
+                host->setWorkgroupName(record.workgroupName);
+                host->setHostName(record.hostName);
+                host->setComment(record.comment);
+                host->setIpAddress(record.ipAddress);
+                host->setIsMasterBrowser(isMasterBrowser);
+                host->setDnsDiscovered(record.dnsDiscovered);
 
-            if (!findHost(host->hostName(), host->workgroupName())) {
                 addHost(host);
             } else {
-                updateHost(host);
+                modifyHost(host, [&record, isMasterBrowser](Smb4KHost *h) {
+                    int fields = NoField;
+
+                    if (h->comment() != record.comment) {
+                        h->setComment(record.comment);
+                        fields |= CommentField;
+                    }
+
+                    if (h->isMasterBrowser() != isMasterBrowser) {
+                        h->setIsMasterBrowser(isMasterBrowser);
+                        fields |= MasterBrowserField;
+                    }
+
+                    if (h->isStale()) {
+                        h->setStale(false);
+                        fields |= StaleField;
+                    }
+
+                    // Do not kill the already discovered IP address
+                    if (!h->hasIpAddress() && !record.ipAddress.isNull()) {
+                        h->setIpAddress(record.ipAddress);
+                        fields |= IpAddressField;
+                    }
+
+                    return fields;
+                });
             }
         }
 
         // Clear the temporary host list
-        while (!d->tempHostList.isEmpty()) {
-            d->tempHostList.takeFirst().clear();
-        }
+        d->tempHostLists.remove(workgroupKey);
 
         Q_EMIT hosts(workgroup);
+
+        // Confirm the shares of the hosts that were loaded from the browse cache
+        QList<HostPtr> confirmedMembers = workgroupMembers(workgroup);
+
+        for (const HostPtr &host : std::as_const(confirmedMembers)) {
+            QList<SharePtr> shares = sharedResources(host);
+
+            for (const SharePtr &share : std::as_const(shares)) {
+                if (share->isStale()) {
+                    lookupShares(host);
+                    break;
+                }
+            }
+        }
     }
 }
 
@@ -704,71 +825,377 @@ void Smb4KClient::processShares(Smb4KClientBaseJob *job)
     HostPtr host = job->networkItem().staticCast<Smb4KHost>();
 
     //
-    // Copy the list of discovered shares
+    // Copy the list of discovered shares and filter out those
+    // that the user does not want to see
     //
-    QList<SharePtr> discoveredShares = job->shares();
+    QList<Smb4KShareRecord> discoveredShares = job->shares();
+
+    discoveredShares.removeIf([](const Smb4KShareRecord &record) {
+        return (record.url.path().endsWith(QStringLiteral("$")) && !Smb4KSettings::detectHiddenShares())
+            || (record.shareType == PrinterShare && !Smb4KSettings::detectPrinterShares());
+    });
 
     //
     // Remove obsolete shares
     //
-    QList<SharePtr> sharedRes = sharedResources(host);
-    QListIterator<SharePtr> it(sharedRes);
+    QSet<QString> shareKeys;
 
-    while (it.hasNext()) {
-        SharePtr share = it.next();
+    for (const Smb4KShareRecord &record : std::as_const(discoveredShares)) {
+        shareKeys << Smb4KBasicNetworkItem::keyForUrl(record.url);
+    }
 
-        bool foundShare = false;
+    const QList<SharePtr> sharedRes = sharedResources(host);
 
-        for (const SharePtr &s : std::as_const(discoveredShares)) {
-            if (s->workgroupName() == share->workgroupName() && s->url().matches(share->url(), QUrl::RemoveUserInfo | QUrl::RemovePort)) {
-                foundShare = true;
-                break;
+    for (const SharePtr &share : sharedRes) {
+        if (!shareKeys.contains(share->key())) {
+            removeShare(share);
+        }
+    }
+
+    //
+    // Add new shares and update existing ones in place
+    //
+    for (const Smb4KShareRecord &record : std::as_const(discoveredShares)) {
+        SharePtr share = findShare(record.url, record.workgroupName);
+
+        if (!share) {
+            share = SharePtr(new Smb4KShare(record.url));
+            share->setWorkgroupName(record.workgroupName);
+            share->setComment(record.comment);
+            share->setShareType(record.shareType);
+            share->setHostIpAddress(record.hostIpAddress);
+
+            addShare(share);
+        } else {
+            modifyShare(share, [&record](Smb4KShare *s) {
+                int fields = NoField;
+
+                if (s->url().userName() != record.url.userName() || s->url().password() != record.url.password()) {
+                    s->setUserName(record.url.userName());
+                    s->setPassword(record.url.password());
+                    fields |= UrlField;
+                }
+
+                if (s->comment() != record.comment) {
+                    s->setComment(record.comment);
+                    fields |= CommentField;
+                }
+
+                if (s->shareType() != record.shareType) {
+                    s->setShareType(record.shareType);
+                    fields |= ShareTypeField;
+                }
+
+                if (s->hostIpAddress() != record.hostIpAddress.toString()) {
+                    s->setHostIpAddress(record.hostIpAddress);
+                    fields |= IpAddressField;
+                }
+
+                if (s->isStale()) {
+                    s->setStale(false);
+                    fields |= StaleField;
+                }
+
+                return fields;
+            });
+        }
+    }
+
+    Q_EMIT shares(host);
+}
+
+void Smb4KClient::processSearch(Smb4KClientBaseJob *job)
+{
+    if (!d->searchRunning) {
+        return;
+    }
+
+    switch (job->process()) {
+    case LookupDomains: {
+        //
+        // When the domains are known, look up the members of all of
+        // them at once
+        //
+        if (!hasRunningJobs(LookupDomains)) {
+            const QList<WorkgroupPtr> workgroups = workgroupsList();
+
+            for (const WorkgroupPtr &workgroup : workgroups) {
+                // Skip the workgroups whose members are already looked up
+                if (!hasRunningJobs(LookupDomainMembers, workgroup)) {
+                    lookupDomainMembers(workgroup);
+                }
+            }
+        }
+        break;
+    }
+    case LookupDomainMembers: {
+        //
+        // When all jobs for a domain finished, queue its members
+        //
+        if (!hasRunningJobs(LookupDomainMembers, job->networkItem())) {
+            const QList<HostPtr> members = workgroupMembers(job->networkItem().staticCast<Smb4KWorkgroup>());
+
+            for (const HostPtr &host : members) {
+                if (!d->queuedSearchHosts.contains(host) && !d->searchHosts.contains(host)) {
+                    d->searchQueue << host;
+                    d->queuedSearchHosts << host;
+                }
             }
         }
+        break;
+    }
+    case LookupShares: {
+        //
+        // Report the matching shares of the host right away
+        //
+        HostPtr host = job->networkItem().staticCast<Smb4KHost>();
+
+        if (d->searchHosts.remove(host)) {
+            QList<SharePtr> results;
+            const QList<SharePtr> shares = sharedResources(host);
+
+            for (const SharePtr &share : shares) {
+                if (share->shareName().contains(d->searchItem, Qt::CaseInsensitive)) {
+                    results << share;
+                }
+            }
 
-        if (!foundShare || (share->isHidden() && !Smb4KSettings::detectHiddenShares()) || (share->isPrinter() && !Smb4KSettings::detectPrinterShares())) {
-            removeShare(share);
+            if (!results.isEmpty()) {
+                Q_EMIT searchResults(results);
+            }
+        }
+        break;
+    }
+    default: {
+        break;
+    }
+    }
+
+    //
+    // Start the next share lookups, but do not exceed the configured
+    // number of parallel lookups
+    //
+    while (!d->searchQueue.isEmpty() && d->searchHosts.size() < Smb4KSettings::maximumParallelLookups()) {
+        HostPtr host = d->searchQueue.takeFirst();
+        d->queuedSearchHosts.remove(host);
+        d->searchHosts << host;
+        lookupShares(host);
+    }
+
+    //
+    // The search finished when there is nothing left to do
+    //
+    if (d->searchQueue.isEmpty() && d->searchHosts.isEmpty() && !hasRunningJobs(LookupDomains) && !hasRunningJobs(LookupDomainMembers)) {
+        d->searchRunning = false;
+
+        Q_EMIT finished(d->searchNetworkItem, NetworkSearch);
+        d->searchNetworkItem.clear();
+    }
+}
+
+bool Smb4KClient::hasRunningJobs(Smb4KGlobal::Process process, const NetworkItemPtr &networkItem)
+{
+    const QList<KJob *> jobs = subjobs();
+
+    for (KJob *job : jobs) {
+        Smb4KClientBaseJob *clientBaseJob = qobject_cast<Smb4KClientBaseJob *>(job);
+
+        if (clientBaseJob && clientBaseJob->process() == process) {
+            if (!networkItem || clientBaseJob->networkItem()->hasSameUrl(networkItem.data())) {
+                return true;
+            }
         }
     }
 
+    return false;
+}
+
+//
+// The key under which the time stamp of a network item is stored
+//
+static QString browseCacheKey(const NetworkItemPtr &networkItem)
+{
+    return QString::number(networkItem->type()) + networkItem->key();
+}
+
+bool Smb4KClient::readBrowseCache()
+{
+    QFile cacheFile(dataLocation() + QDir::separator() + QStringLiteral("browse_cache"));
+
+    if (!cacheFile.open(QIODevice::ReadOnly)) {
+        if (cacheFile.exists()) {
+            Smb4KNotification::openingFileFailed(cacheFile);
+        }
+
+        return false;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+
+    //
+    // Silently ignore caches written by other versions
+    //
+    if (magic != BROWSE_CACHE_MAGIC || version != BROWSE_CACHE_VERSION) {
+        return false;
+    }
+
+    QDateTime oldestAllowed = QDateTime::currentDateTimeUtc().addSecs(-3600 * qint64(Smb4KSettings::browseCacheMaximumAge()));
+    quint32 count = 0;
+
     //
-    // Add new shares and update existing ones
+    // Read the workgroups
     //
-    for (const SharePtr &share : std::as_const(discoveredShares)) {
-        // Process only those shares that the user wants to see
-        if (share->isHidden() && !Smb4KSettings::detectHiddenShares()) {
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString workgroupName, masterBrowserName, masterBrowserIpAddress;
+        bool dnsDiscovered = false;
+        QDateTime lastSeen;
+
+        stream >> workgroupName >> masterBrowserName >> masterBrowserIpAddress >> dnsDiscovered >> lastSeen;
+
+        if (stream.status() != QDataStream::Ok || lastSeen < oldestAllowed || findWorkgroup(workgroupName)) {
             continue;
         }
 
-        if (share->isPrinter() && !Smb4KSettings::detectPrinterShares()) {
+        WorkgroupPtr workgroup = WorkgroupPtr(new Smb4KWorkgroup());
+        workgroup->setWorkgroupName(workgroupName);
+        workgroup->setMasterBrowserName(masterBrowserName);
+        workgroup->setMasterBrowserIpAddress(masterBrowserIpAddress);
+        workgroup->setDnsDiscovered(dnsDiscovered);
+        workgroup->setStale(true);
+
+        if (addWorkgroup(workgroup)) {
+            d->browseCacheTimestamps.insert(browseCacheKey(workgroup), lastSeen);
+        }
+    }
+
+    //
+    // Read the hosts. Only add them, if their workgroup is known.
+    //
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString workgroupName, hostName, comment, ipAddress;
+        bool isMasterBrowser = false, dnsDiscovered = false;
+        QDateTime lastSeen;
+
+        stream >> workgroupName >> hostName >> comment >> ipAddress >> isMasterBrowser >> dnsDiscovered >> lastSeen;
+
+        if (stream.status() != QDataStream::Ok || lastSeen < oldestAllowed || !findWorkgroup(workgroupName) || findHost(hostName, workgroupName)) {
             continue;
         }
 
-        // Add or update the shares
-        if (!findShare(share->url(), share->workgroupName())) {
-            addShare(share);
-        } else {
-            updateShare(share);
+        HostPtr host = HostPtr(new Smb4KHost());
+        host->setWorkgroupName(workgroupName);
+        host->setHostName(hostName);
+        host->setComment(comment);
+        host->setIpAddress(ipAddress);
+        host->setIsMasterBrowser(isMasterBrowser);
+        host->setDnsDiscovered(dnsDiscovered);
+        host->setStale(true);
+
+        if (addHost(host)) {
+            d->browseCacheTimestamps.insert(browseCacheKey(host), lastSeen);
         }
     }
 
-    Q_EMIT shares(host);
-}
+    //
+    // Read the shares. Only add them, if their host is known.
+    //
+    stream >> count;
 
-void Smb4KClient::processFiles(Smb4KClientBaseJob *job)
-{
-    QList<FilePtr> discoveredFiles = job->files();
-    QList<FilePtr> list;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString workgroupName, hostName, shareName, comment, hostIpAddress;
+        qint32 shareType = 0;
+        QDateTime lastSeen;
 
-    for (const FilePtr &file : std::as_const(discoveredFiles)) {
-        if (file->isHidden() && !Smb4KSettings::previewHiddenItems()) {
+        stream >> workgroupName >> hostName >> shareName >> comment >> shareType >> hostIpAddress >> lastSeen;
+
+        if (stream.status() != QDataStream::Ok || lastSeen < oldestAllowed || !findHost(hostName, workgroupName)) {
             continue;
         }
 
-        list << file;
+        SharePtr share = SharePtr(new Smb4KShare());
+        share->setWorkgroupName(workgroupName);
+        share->setHostName(hostName);
+        share->setShareName(shareName);
+        share->setComment(comment);
+        share->setShareType(static_cast<Smb4KGlobal::ShareType>(shareType));
+        share->setHostIpAddress(hostIpAddress);
+        share->setStale(true);
+
+        if (!findShare(share->url(), workgroupName) && addShare(share)) {
+            d->browseCacheTimestamps.insert(browseCacheKey(share), lastSeen);
+        }
+    }
+
+    cacheFile.close();
+
+    return !workgroupsList().isEmpty();
+}
+
+void Smb4KClient::writeBrowseCache()
+{
+    QFile cacheFile(dataLocation() + QDir::separator() + QStringLiteral("browse_cache"));
+
+    if (!Smb4KSettings::useBrowseCache() || workgroupsList().isEmpty()) {
+        cacheFile.remove();
+        return;
+    }
+
+    if (!cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        Smb4KNotification::openingFileFailed(cacheFile);
+        return;
+    }
+
+    //
+    // Items that were confirmed by a scan were seen just now. Stale items
+    // keep the time stamp they were loaded with.
+    //
+    QDateTime now = QDateTime::currentDateTimeUtc();
+
+    auto lastSeen = [this, &now](const NetworkItemPtr &networkItem) {
+        return networkItem->isStale() ? d->browseCacheTimestamps.value(browseCacheKey(networkItem), now) : now;
+    };
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    stream << quint32(BROWSE_CACHE_MAGIC) << quint32(BROWSE_CACHE_VERSION);
+
+    const QList<WorkgroupPtr> knownWorkgroups = workgroupsList();
+
+    stream << quint32(knownWorkgroups.size());
+
+    for (const WorkgroupPtr &workgroup : knownWorkgroups) {
+        stream << workgroup->workgroupName() << workgroup->masterBrowserName() << workgroup->masterBrowserIpAddress() << workgroup->dnsDiscovered()
+               << lastSeen(workgroup);
     }
 
-    Q_EMIT files(list);
+    const QList<HostPtr> knownHosts = hostsList();
+
+    stream << quint32(knownHosts.size());
+
+    for (const HostPtr &host : knownHosts) {
+        stream << host->workgroupName() << host->hostName() << host->comment() << host->ipAddress() << host->isMasterBrowser() << host->dnsDiscovered()
+               << lastSeen(host);
+    }
+
+    const QList<SharePtr> knownShares = sharesList();
+
+    stream << quint32(knownShares.size());
+
+    for (const SharePtr &share : knownShares) {
+        stream << share->workgroupName() << share->hostName() << share->shareName() << share->comment() << qint32(share->shareType())
+               << share->hostIpAddress() << lastSeen(share);
+    }
+
+    cacheFile.close();
 }
 
 void Smb4KClient::slotStartJobs()
@@ -824,14 +1251,10 @@ void Smb4KClient::slotResult(KJob *job)
             processShares(clientBaseJob);
             break;
         }
-        case Share: {
-            processFiles(clientBaseJob);
-            break;
-        }
+        case Share:
         case FileOrDirectory: {
-            if (networkItem.staticCast<Smb4KFile>()->isDirectory()) {
-                processFiles(clientBaseJob);
-            }
+            // The files and directories were already passed on while
+            // they were received (see slotFilesReceived())
             break;
         }
         default: {
@@ -842,11 +1265,21 @@ void Smb4KClient::slotResult(KJob *job)
         processErrors(clientBaseJob);
     }
 
+    //
+    // Continue a running search
+    //
+    processSearch(clientBaseJob);
+
     //
     // Emit the finished signal when all subjobs finished
     //
     if (!hasSubjobs()) {
         Q_EMIT finished(networkItem, process);
+
+        // Remember the network neighborhood for the next start
+        if (process == LookupDomains || process == LookupDomainMembers || process == LookupShares) {
+            writeBrowseCache();
+        }
     }
 
     //
@@ -865,6 +1298,18 @@ void Smb4KClient::slotResult(KJob *job)
 void Smb4KClient::slotAboutToQuit()
 {
     abort();
+
+    //
+    // Remember the network neighborhood for the next start
+    //
+    writeBrowseCache();
+
+#ifdef USE_WS_DISCOVERY
+    //
+    // Remember the metadata of the WS-Discovery devices
+    //
+    Smb4KWsDiscoveryCache::self()->save();
+#endif
 }
 
 void Smb4KClient::slotAbort()
@@ -876,21 +1321,14 @@ void Smb4KClient::slotCredentialsUpdated(const QUrl &url)
 {
     if (!url.isEmpty() && !d->queue.isEmpty()) {
         QMutableListIterator<Smb4KClientPrivate::QueueContainer> it(d->queue);
+        QString urlKey = Smb4KBasicNetworkItem::keyForUrl(url);
 
         while (it.hasNext()) {
             Smb4KClientPrivate::QueueContainer container = it.next();
 
-            QUrl networkItemUrl = container.networkItem->url();
             QUrl parentNetworkItemUrl = container.networkItem->url().resolved(QUrl(QStringLiteral(".."))).adjusted(QUrl::StripTrailingSlash);
 
-            if (QString::compare(networkItemUrl.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                    == 0
-                || QString::compare(parentNetworkItemUrl.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                    url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                    Qt::CaseInsensitive)
-                    == 0) {
+            if (container.networkItem->key() == urlKey || Smb4KBasicNetworkItem::keyForUrl(parentNetworkItemUrl) == urlKey) {
                 switch (container.networkItem->type()) {
                 case Host: {
                     HostPtr host = container.networkItem.staticCast<Smb4KHost>();
@@ -927,3 +1365,46 @@ void Smb4KClient::slotCredentialsUpdated(const QUrl &url)
         }
     }
 }
+
+void Smb4KClient::slotFilesReceived(const QList<FilePtr> &files)
+{
+    Smb4KClientJob *job = qobject_cast<Smb4KClientJob *>(sender());
+
+    if (!job) {
+        return;
+    }
+
+    QList<FilePtr> list;
+
+    for (const FilePtr &file : files) {
+        if (file->isHidden() && !Smb4KSettings::previewHiddenItems()) {
+            continue;
+        }
+
+        list << file;
+    }
+
+    if (!list.isEmpty()) {
+        Q_EMIT this->files(job->networkItem(), list);
+    }
+}
+
+void Smb4KClient::slotHostWokenUp(const QString &key, bool awake)
+{
+    Q_UNUSED(awake);
+
+    if (!d->wakeUpKeys.remove(key)) {
+        return;
+    }
+
+    //
+    // Start the lookup as soon as the last host answered. Hosts that did
+    // not wake up in time are simply not found.
+    //
+    if (d->wakeUpKeys.isEmpty()) {
+        Q_EMIT finished(d->wakeUpItem, WakeUp);
+        d->wakeUpItem.clear();
+
+        startDomainLookups();
+    }
+}
@@ -87,7 +87,8 @@ public:
     /**
      * This function looks up all files and directories present at the location
      * @p item points to. The network item must be of type Smb4KGlobal::Share or
-     * Smb4KGlobal::Directory.
+     * Smb4KGlobal::Directory. The result is reported in portions with the files()
+     * signal while the listing is transferred.
      *
      * @param item            The network item object
      */
@@ -106,7 +107,11 @@ public:
     void printFile(const SharePtr &share, const KFileItem &fileItem, int copies);
 
     /**
-     * Perform a search on the entire network neighborhood
+     * Perform a search on the entire network neighborhood. The shares of
+     * the discovered hosts are looked up concurrently. The number of parallel
+     * lookups is limited by Smb4KSettings::maximumParallelLookups(). The
+     * results are reported with the searchResults() signal as soon as a
+     * host was processed. The search can be cancelled with abort().
      *
      * @param item            The search item
      */
@@ -149,14 +154,19 @@ Q_SIGNALS:
     void shares(const HostPtr &host);
 
     /**
-     * Emitted when the requested list of files and directories was acquired
+     * Emitted when files and directories were acquired. For large listings
+     * this signal is emitted several times, every time with the next portion
+     * of files and directories.
      *
+     * @param item          The network item that was queried
      * @param list          The list of files and directories
      */
-    void files(const QList<FilePtr> &list);
+    void files(const NetworkItemPtr &item, const QList<FilePtr> &list);
 
     /**
-     * Emitted when a search was done
+     * Emitted when matching shares were found while searching. This signal
+     * is emitted several times during a search, every time with the results
+     * of the hosts that were processed last.
      *
      * @param list          The list of search results
      */
@@ -201,7 +211,23 @@ protected Q_SLOTS:
      */
     void slotCredentialsUpdated(const QUrl &url);
 
+    /**
+     * Called when a portion of files and directories was received
+     */
+    void slotFilesReceived(const QList<FilePtr> &files);
+
+    /**
+     * Called when a host that was sent a Wake-On-LAN packet woke up
+     * or the waiting time passed
+     */
+    void slotHostWokenUp(const QString &key, bool awake);
+
 private:
+    /**
+     * Start the lookup of the domains and workgroups
+     */
+    void startDomainLookups();
+
     /**
      * Process errors
      */
@@ -229,11 +255,34 @@ private:
     void processShares(Smb4KClientBaseJob *job);
 
     /**
-     * Process the files and directories
+     * Continue a running network search after a job finished
      *
      * @param job             The client job
      */
-    void processFiles(Smb4KClientBaseJob *job);
+    void processSearch(Smb4KClientBaseJob *job);
+
+    /**
+     * Read the network neighborhood that was saved to the browse cache
+     * and add the items that are not too old as stale items.
+     *
+     * @returns TRUE if network items were loaded
+     */
+    bool readBrowseCache();
+
+    /**
+     * Save the network neighborhood to the browse cache
+     */
+    void writeBrowseCache();
+
+    /**
+     * Returns TRUE if a subjob for the process @p process is running. If
+     * @p networkItem is given, only jobs for this network item are considered.
+     *
+     * @param process         The process
+     *
+     * @param networkItem     The network item
+     */
+    bool hasRunningJobs(Smb4KGlobal::Process process, const NetworkItemPtr &networkItem = NetworkItemPtr());
 
     /**
      * Pointer to the Smb4KClientPrivate class
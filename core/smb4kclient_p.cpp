@@ -10,6 +10,7 @@
 #include "smb4kcredentialsmanager.h"
 #include "smb4kcustomsettings.h"
 #include "smb4kcustomsettingsmanager.h"
+#include "smb4khostresolver.h"
 #include "smb4knotification.h"
 #include "smb4ksettings.h"
 
@@ -18,14 +19,17 @@
 #include <sys/stat.h>
 
 // Qt includes
-#include <QAbstractSocket>
+#include <QCoreApplication>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
-#include <QHostInfo>
-#include <QNetworkInterface>
+#include <QFile>
+#include <QMutexLocker>
 #include <QPrinter>
+#include <QScopeGuard>
 #include <QTemporaryDir>
 #include <QTextDocument>
+#include <QThreadPool>
 #include <QUuid>
 
 // KDE includes
@@ -41,9 +45,33 @@
 #endif
 
 #define SMBC_DEBUG 0
+#define MAX_IDLE_CONTEXTS 8
+#define CONTEXT_IDLE_TIMEOUT 60000
+#define FILE_BATCH_SIZE 200
+#define MAX_PENDING_BATCHES 4
+#define WSD_CACHE_TIMEOUT 86400
+#define WSD_CACHE_MAGIC 0x57534443
+#define WSD_CACHE_VERSION 1
 
 using namespace Smb4KGlobal;
 
+//
+// The thread pool the lookups are run in
+//
+Q_GLOBAL_STATIC(QThreadPool, clientThreadPool);
+
+//
+// The pool of idle client contexts
+//
+Q_GLOBAL_STATIC(Smb4KClientContextPool, clientContextPool);
+
+#ifdef USE_WS_DISCOVERY
+//
+// The metadata of the WS-Discovery devices
+//
+Q_GLOBAL_STATIC(Smb4KWsDiscoveryCache, wsDiscoveryCache);
+#endif
+
 //
 // Client base job
 //
@@ -57,26 +85,10 @@ Smb4KClientBaseJob::Smb4KClientBaseJob(QObject *parent)
     pWorkgroups = &m_workgroups;
     pHosts = &m_hosts;
     pShares = &m_shares;
-    pFiles = &m_files;
 }
 
 Smb4KClientBaseJob::~Smb4KClientBaseJob()
 {
-    while (!m_workgroups.isEmpty()) {
-        m_workgroups.takeFirst().clear();
-    }
-
-    while (!m_hosts.isEmpty()) {
-        m_hosts.takeFirst().clear();
-    }
-
-    while (!m_shares.isEmpty()) {
-        m_shares.takeFirst().clear();
-    }
-
-    while (!m_files.isEmpty()) {
-        m_files.takeFirst().clear();
-    }
 }
 
 void Smb4KClientBaseJob::setProcess(Smb4KGlobal::Process process)
@@ -99,82 +111,176 @@ NetworkItemPtr Smb4KClientBaseJob::networkItem() const
     return m_networkItem;
 }
 
-QList<WorkgroupPtr> Smb4KClientBaseJob::workgroups()
+QList<Smb4KWorkgroupRecord> Smb4KClientBaseJob::workgroups()
 {
     return m_workgroups;
 }
 
-QList<HostPtr> Smb4KClientBaseJob::hosts()
+QList<Smb4KHostRecord> Smb4KClientBaseJob::hosts()
 {
     return m_hosts;
 }
 
-QList<SharePtr> Smb4KClientBaseJob::shares()
+QList<Smb4KShareRecord> Smb4KClientBaseJob::shares()
 {
     return m_shares;
 }
 
-QList<FilePtr> Smb4KClientBaseJob::files()
+void Smb4KClientBaseJob::emitResultWhenResolved()
 {
-    return m_files;
+    //
+    // Collect the names of the hosts without IP address
+    //
+    for (const Smb4KHostRecord &host : std::as_const(m_hosts)) {
+        if (host.ipAddress.isNull() && !m_pendingLookups.contains(host.hostName, Qt::CaseInsensitive)) {
+            m_pendingLookups << host.hostName;
+        }
+    }
+
+    //
+    // Emit the result right away, if there is nothing to look up. Otherwise,
+    // look up all addresses at once and wait for the results.
+    //
+    if (m_pendingLookups.isEmpty()) {
+        emitResult();
+    } else {
+        connect(Smb4KHostResolver::self(), &Smb4KHostResolver::addressResolved, this, &Smb4KClientBaseJob::slotAddressResolved, Qt::UniqueConnection);
+        Smb4KHostResolver::self()->lookup(m_pendingLookups);
+    }
 }
 
-QHostAddress Smb4KClientBaseJob::lookupIpAddress(const QString &name)
+void Smb4KClientBaseJob::slotAddressResolved(const QString &name, const QHostAddress &address)
 {
+    if (!m_pendingLookups.contains(name, Qt::CaseInsensitive)) {
+        return;
+    }
+
     //
-    // The IP address object
+    // Process the IP address.
     //
-    QHostAddress ipAddress;
+    if (!address.isNull()) {
+        for (Smb4KHostRecord &host : m_hosts) {
+            if (QString::compare(host.hostName, name, Qt::CaseInsensitive) == 0) {
+                host.ipAddress = address;
+            }
+        }
+    }
+
+    m_pendingLookups.removeIf([&name](const QString &pendingName) {
+        return QString::compare(pendingName, name, Qt::CaseInsensitive) == 0;
+    });
+
+    if (m_pendingLookups.isEmpty()) {
+        disconnect(Smb4KHostResolver::self(), &Smb4KHostResolver::addressResolved, this, &Smb4KClientBaseJob::slotAddressResolved);
+        emitResult();
+    }
+}
+
+//
+// Client context pool
+//
+Smb4KClientContextPool::Smb4KClientContextPool(QObject *parent)
+    : QObject(parent)
+    , m_timerId(0)
+    , m_shutDown(false)
+{
+    connect(Smb4KCredentialsManager::self(), &Smb4KCredentialsManager::credentialsUpdated, this, &Smb4KClientContextPool::slotCredentialsUpdated);
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Smb4KClientContextPool::slotAboutToQuit);
+}
+
+Smb4KClientContextPool::~Smb4KClientContextPool()
+{
+    clear();
+}
+
+Smb4KClientContextPool *Smb4KClientContextPool::self()
+{
+    return clientContextPool;
+}
 
+SMBCCTX *Smb4KClientContextPool::acquire(const QString &key)
+{
+    //
+    // Prefer the most recently used context
     //
-    // Get the IP address
+    for (int i = m_idleContexts.size() - 1; i >= 0; --i) {
+        if (m_idleContexts.at(i).key == key) {
+            return m_idleContexts.takeAt(i).context;
+        }
+    }
+
+    return nullptr;
+}
+
+void Smb4KClientContextPool::release(const QString &key, SMBCCTX *context, bool reusable)
+{
+    if (!reusable || m_shutDown) {
+        smbc_free_context(context, 1);
+        return;
+    }
+
     //
-    // If the IP address is not to be determined for the local machine, we can use QHostInfo to
-    // determine it. Otherwise we need to use QNetworkInterface for it.
+    // The job the user data points to is about to be deleted
     //
-    if (name.toUpper() == QHostInfo::localHostName().toUpper() || name.toUpper() == machineNetbiosName().toUpper()) {
-        // FIXME: Do we need to honor 'interfaces' here?
-        QList<QHostAddress> addresses = QNetworkInterface::allAddresses();
+    smbc_setOptionUserData(context, nullptr);
 
-        // Get the IP address for the host. For the time being, prefer the
-        // IPv4 address over the IPv6 address.
-        for (const QHostAddress &addr : std::as_const(addresses)) {
-            // We only use global addresses.
-            if (addr.isGlobal()) {
-                if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
-                    ipAddress = addr;
-                    break;
-                } else if (addr.protocol() == QAbstractSocket::IPv6Protocol) {
-                    // FIXME: Use the right address here.
-                    ipAddress = addr;
-                }
-            }
-        }
-    } else {
-        // Get the IP address
-        QHostInfo hostInfo = QHostInfo::fromName(name);
-
-        if (hostInfo.error() == QHostInfo::NoError) {
-            QList<QHostAddress> addresses = hostInfo.addresses();
-
-            // Get the IP address for the host. For the time being, prefer the
-            // IPv4 address over the IPv6 address.
-            for (const QHostAddress &addr : std::as_const(addresses)) {
-                // We only use global addresses.
-                if (addr.isGlobal()) {
-                    if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
-                        ipAddress = addr;
-                        break;
-                    } else if (addr.protocol() == QAbstractSocket::IPv6Protocol) {
-                        // FIXME: Use the right address here.
-                        ipAddress = addr;
-                    }
-                }
-            }
-        }
+    IdleContext idleContext;
+    idleContext.key = key;
+    idleContext.context = context;
+    idleContext.expiry.setRemainingTime(CONTEXT_IDLE_TIMEOUT);
+
+    m_idleContexts << idleContext;
+
+    //
+    // Free the least recently used contexts, if there are too many
+    //
+    while (m_idleContexts.size() > MAX_IDLE_CONTEXTS) {
+        smbc_free_context(m_idleContexts.takeFirst().context, 1);
+    }
+
+    if (m_timerId == 0) {
+        m_timerId = startTimer(CONTEXT_IDLE_TIMEOUT / 4);
+    }
+}
+
+void Smb4KClientContextPool::clear()
+{
+    while (!m_idleContexts.isEmpty()) {
+        smbc_free_context(m_idleContexts.takeFirst().context, 1);
+    }
+
+    if (m_timerId != 0) {
+        killTimer(m_timerId);
+        m_timerId = 0;
     }
+}
+
+void Smb4KClientContextPool::slotCredentialsUpdated()
+{
+    clear();
+}
+
+void Smb4KClientContextPool::slotAboutToQuit()
+{
+    m_shutDown = true;
+    clear();
+}
 
-    return ipAddress;
+void Smb4KClientContextPool::timerEvent(QTimerEvent * /*event*/)
+{
+    m_idleContexts.removeIf([](const IdleContext &idleContext) {
+        if (idleContext.expiry.hasExpired()) {
+            smbc_free_context(idleContext.context, 1);
+            return true;
+        }
+
+        return false;
+    });
+
+    if (m_idleContexts.isEmpty()) {
+        killTimer(m_timerId);
+        m_timerId = 0;
+    }
 }
 
 //
@@ -190,12 +296,61 @@ static void get_auth_data_with_context_fn(SMBCCTX *context,
                                           char *password,
                                           int maxLenPassword)
 {
-    if (context != nullptr) {
-        Smb4KClientJob *job = static_cast<Smb4KClientJob *>(smbc_getOptionUserData(context));
+    Q_UNUSED(share);
+    Q_UNUSED(maxLenWorkgroup);
 
-        if (job) {
-            job->get_auth_data_fn(server, share, workgroup, maxLenWorkgroup, username, maxLenUsername, password, maxLenPassword);
-        }
+    if (context == nullptr) {
+        return;
+    }
+
+    //
+    // This function is called from the worker thread. The credentials were
+    // already read by readLoginCredentials() in the main thread.
+    //
+    Smb4KClientLookup *lookup = static_cast<Smb4KClientLookup *>(smbc_getOptionUserData(context));
+
+    if (!lookup) {
+        return;
+    }
+
+    //
+    // For workgroups, only the master browser gets authentication data.
+    //
+    if (lookup->networkItemType == Workgroup && QString::fromUtf8(server, -1).toUpper() == QString::fromUtf8(workgroup, -1).toUpper()) {
+        return;
+    }
+
+    //
+    // Copy the authentication data
+    //
+    if (!lookup->userName.isEmpty() || !lookup->password.isEmpty()) {
+        qstrncpy(username, lookup->userName.toUtf8().data(), maxLenUsername);
+        qstrncpy(password, lookup->password.toUtf8().data(), maxLenPassword);
+    }
+}
+
+//
+// Lookup state
+//
+Smb4KClientLookup::Smb4KClientLookup()
+    : context(nullptr)
+    , ownsContext(false)
+    , networkItemType(UnknownNetworkItem)
+    , dnsDiscovered(false)
+    , abort(false)
+    , error(0)
+    , pendingBatches(MAX_PENDING_BATCHES)
+    , job(nullptr)
+{
+}
+
+Smb4KClientLookup::~Smb4KClientLookup()
+{
+    //
+    // The job was destroyed while the lookup was running
+    //
+    if (ownsContext && context != nullptr) {
+        smbc_free_context(context, 1);
     }
 }
 
@@ -204,11 +359,32 @@ static void get_auth_data_with_context_fn(SMBCCTX *context,
 //
 Smb4KClientJob::Smb4KClientJob(QObject *parent)
     : Smb4KClientBaseJob(parent)
+    , m_context(nullptr)
+    , m_copies(0)
+    , m_lookupRunning(false)
+    , m_lookup(new Smb4KClientLookup())
 {
+    m_lookup->job = this;
 }
 
 Smb4KClientJob::~Smb4KClientJob()
 {
+    //
+    // A lookup might still be running in the thread pool, if the job is
+    // destroyed together with its parent. Do not wait for it, but tell it
+    // to stop and hand the context over. It is freed when the worker is done.
+    //
+    if (m_lookupRunning) {
+        QMutexLocker locker(&m_lookup->jobMutex);
+        m_lookup->abort = true;
+        m_lookup->job = nullptr;
+        m_lookup->ownsContext = true;
+        locker.unlock();
+
+        Smb4KHostResolver::self()->cancelWaits();
+    } else if (m_context != nullptr) {
+        smbc_free_context(m_context, 1);
+    }
 }
 
 void Smb4KClientJob::start()
@@ -237,18 +413,15 @@ int Smb4KClientJob::printCopies() const
     return m_copies;
 }
 
-void Smb4KClientJob::get_auth_data_fn(const char *server,
-                                      const char * /*share*/,
-                                      char *workgroup,
-                                      int /*maxLenWorkgroup*/,
-                                      char *username,
-                                      int maxLenUsername,
-                                      char *password,
-                                      int maxLenPassword)
+void Smb4KClientJob::readLoginCredentials()
 {
     //
-    // Authentication
+    // Read the authentication data. The credentials manager must only be used
+    // from the main thread, so this has to be done before the lookup is moved
+    // to the thread pool.
     //
+    NetworkItemPtr item;
+
     switch ((*pNetworkItem)->type()) {
     case Network: {
         //
@@ -261,28 +434,17 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
         // Only request authentication data, if the master browsers require
         // authentication data.
         //
-        if (Smb4KSettings::masterBrowsersRequireAuth()) {
-            if (QString::fromUtf8(server, -1).toUpper() != QString::fromUtf8(workgroup, -1).toUpper()) {
-                //
-                // This is the master browser. Create a host object for it.
-                //
-                HostPtr masterBrowser = HostPtr(new Smb4KHost());
-                masterBrowser->setWorkgroupName(QString::fromUtf8(workgroup, -1));
-                masterBrowser->setHostName(QString::fromUtf8(server, -1));
+        WorkgroupPtr workgroup = (*pNetworkItem).staticCast<Smb4KWorkgroup>();
 
-                //
-                // Get the authentication data
-                //
-                Smb4KCredentialsManager::self()->readLoginCredentials(masterBrowser);
+        if (Smb4KSettings::masterBrowsersRequireAuth() && workgroup->hasMasterBrowser()) {
+            //
+            // Create a host object for the master browser.
+            //
+            HostPtr masterBrowser = HostPtr(new Smb4KHost());
+            masterBrowser->setWorkgroupName(workgroup->workgroupName());
+            masterBrowser->setHostName(workgroup->masterBrowserName());
 
-                //
-                // Copy the authentication data
-                //
-                if (masterBrowser->hasUserInfo()) {
-                    qstrncpy(username, masterBrowser->userName().toUtf8().data(), maxLenUsername);
-                    qstrncpy(password, masterBrowser->password().toUtf8().data(), maxLenPassword);
-                }
-            }
+            item = masterBrowser;
         }
 
         break;
@@ -291,42 +453,14 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
         //
         // The host object
         //
-        HostPtr host = (*pNetworkItem).staticCast<Smb4KHost>();
-
-        //
-        // Get the authentication data
-        //
-        Smb4KCredentialsManager::self()->readLoginCredentials(host);
-
-        //
-        // Copy the authentication data
-        //
-        if (host->hasUserInfo()) {
-            qstrncpy(username, host->userName().toUtf8().data(), maxLenUsername);
-            qstrncpy(password, host->password().toUtf8().data(), maxLenPassword);
-        }
-
+        item = *pNetworkItem;
         break;
     }
     case Share: {
         //
         // The share object
         //
-        SharePtr share = (*pNetworkItem).staticCast<Smb4KShare>();
-
-        //
-        // Get the authentication data
-        //
-        Smb4KCredentialsManager::self()->readLoginCredentials(share);
-
-        //
-        // Copy the authentication data
-        //
-        if (share->hasUserInfo()) {
-            qstrncpy(username, share->userName().toUtf8().data(), maxLenUsername);
-            qstrncpy(password, share->password().toUtf8().data(), maxLenPassword);
-        }
-
+        item = *pNetworkItem;
         break;
     }
     case FileOrDirectory: {
@@ -343,18 +477,7 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
             share->setUserName(file->userName());
             share->setPassword(file->password());
 
-            //
-            // Get the authentication data
-            //
-            Smb4KCredentialsManager::self()->readLoginCredentials(share);
-
-            //
-            // Copy the authentication data
-            //
-            if (share->hasUserInfo()) {
-                qstrncpy(username, share->userName().toUtf8().data(), maxLenUsername);
-                qstrncpy(password, share->password().toUtf8().data(), maxLenPassword);
-            }
+            item = share;
         }
 
         break;
@@ -363,52 +486,32 @@ void Smb4KClientJob::get_auth_data_fn(const char *server,
         break;
     }
     }
-}
-
-void Smb4KClientJob::initClientLibrary()
-{
-    //
-    // Get new context
-    //
-    m_context = smbc_new_context();
-
-    if (!m_context) {
-        int errorCode = errno;
-
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
-
-        emitResult();
-        return;
-    }
 
     //
-    // Init the context
+    // Get the authentication data
     //
-    m_context = smbc_init_context(m_context);
-
-    if (!m_context) {
-        int errorCode = errno;
+    if (item) {
+        Smb4KCredentialsManager::self()->readLoginCredentials(item);
 
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
-        emitResult();
-        return;
+        if (item->hasUserInfo()) {
+            m_lookup->userName = item->url().userName();
+            m_lookup->password = item->url().password();
+        }
     }
+}
 
+void Smb4KClientJob::initClientLibrary()
+{
     //
     // Get the custom options
     //
     CustomSettingsPtr options = Smb4KCustomSettingsManager::self()->findCustomSettings(*pNetworkItem);
 
     //
-    // Set debug level
+    // Determine the NetBIOS name and the workgroup to make connections
     //
-    smbc_setDebug(m_context, SMBC_DEBUG);
+    QString netbiosName, workgroupName;
 
-    //
-    // Set the NetBIOS name and the workgroup to make connections
-    //
     switch ((*pNetworkItem)->type()) {
     case Network: {
         //
@@ -424,7 +527,7 @@ void Smb4KClientJob::initClientLibrary()
         // Only set the NetBIOS name, if the workgroup entry has a master browser
         //
         if (workgroup->hasMasterBrowser()) {
-            smbc_setNetbiosName(m_context, workgroup->masterBrowserName().toUtf8().data());
+            netbiosName = workgroup->masterBrowserName();
         }
 
         //
@@ -433,7 +536,7 @@ void Smb4KClientJob::initClientLibrary()
         // the workgroup if no DNS-SD discovery was used.
         //
         if (!workgroup->dnsDiscovered()) {
-            smbc_setWorkgroup(m_context, workgroup->workgroupName().toUtf8().data());
+            workgroupName = workgroup->workgroupName();
         }
 
         break;
@@ -448,13 +551,13 @@ void Smb4KClientJob::initClientLibrary()
         WorkgroupPtr workgroup = findWorkgroup(host->workgroupName());
 
         if (workgroup && !workgroup->dnsDiscovered()) {
-            smbc_setWorkgroup(m_context, host->workgroupName().toUtf8().data());
+            workgroupName = host->workgroupName();
         }
 
         //
         // Set the NetBIOS name
         //
-        smbc_setNetbiosName(m_context, host->hostName().toUtf8().data());
+        netbiosName = host->hostName();
 
         break;
     }
@@ -468,13 +571,13 @@ void Smb4KClientJob::initClientLibrary()
         WorkgroupPtr workgroup = findWorkgroup(share->workgroupName());
 
         if (workgroup && !workgroup->dnsDiscovered()) {
-            smbc_setWorkgroup(m_context, share->workgroupName().toUtf8().data());
+            workgroupName = share->workgroupName();
         }
 
         //
         // Set the NetBIOS name
         //
-        smbc_setNetbiosName(m_context, share->hostName().toUtf8().data());
+        netbiosName = share->hostName();
 
         break;
     }
@@ -490,13 +593,13 @@ void Smb4KClientJob::initClientLibrary()
             WorkgroupPtr workgroup = findWorkgroup(file->workgroupName());
 
             if (workgroup && !workgroup->dnsDiscovered()) {
-                smbc_setWorkgroup(m_context, file->workgroupName().toUtf8().data());
+                workgroupName = file->workgroupName();
             }
 
             //
             // Set the NetBIOS name
             //
-            smbc_setNetbiosName(m_context, file->hostName().toUtf8().data());
+            netbiosName = file->hostName();
         }
 
         break;
@@ -513,43 +616,27 @@ void Smb4KClientJob::initClientLibrary()
     // of shared resources, use the 'guest' user here, if the URL
     // does not provide a user name.
     //
+    QString userName = QStringLiteral("guest");
+
     if (!(*pNetworkItem)->url().userName().isEmpty()) {
-        smbc_setUser(m_context, (*pNetworkItem)->url().userName().toUtf8().data());
-    } else {
-        smbc_setUser(m_context, "guest");
+        userName = (*pNetworkItem)->url().userName();
     }
 
     //
     // Set the port
     //
+    int port = 0 /* use the default */;
+
     if (options) {
         if (options->useSmbPort()) {
-            smbc_setPort(m_context, options->smbPort());
-        } else {
-            smbc_setPort(m_context, 0 /* use the default */);
+            port = options->smbPort();
         }
     } else {
         if (Smb4KSettings::useRemoteSmbPort()) {
-            smbc_setPort(m_context, Smb4KSettings::remoteSmbPort());
-        } else {
-            smbc_setPort(m_context, 0 /* use the default */);
+            port = Smb4KSettings::remoteSmbPort();
         }
     }
 
-    //
-    // Set the user data (this class)
-    //
-    smbc_setOptionUserData(m_context, this);
-
-    //
-    // Set number of master browsers to be used
-    //
-    if (Smb4KSettings::largeNetworkNeighborhood()) {
-        smbc_setOptionBrowseMaxLmbCount(m_context, 3);
-    } else {
-        smbc_setOptionBrowseMaxLmbCount(m_context, 0 /* all master browsers */);
-    }
-
     //
     // Set the protocol version if desired
     //
@@ -588,7 +675,7 @@ void Smb4KClientJob::initClientLibrary()
         }
         }
 
-        switch (Smb4KSettings::maximalClientProtocolVersion()) {
+        switch (maximal) {
         case Smb4KSettings::EnumMaximalClientProtocolVersion::NT1: {
             maximalClientProtocolVersionString = QStringLiteral("NT1");
             break;
@@ -607,27 +694,23 @@ void Smb4KClientJob::initClientLibrary()
         }
     }
 
-    if (!minimalClientProtocolVersionString.isEmpty() && !maximalClientProtocolVersionString.isEmpty()) {
-        smbc_setOptionProtocols(m_context, minimalClientProtocolVersionString.toLatin1().data(), maximalClientProtocolVersionString.toLatin1().data());
-    } else {
-        smbc_setOptionProtocols(m_context, nullptr, nullptr);
-    }
-
     //
     // Set the encryption level
     //
+    int encryptionLevel = -1 /* use the default */;
+
     if (Smb4KSettings::useEncryptionLevel()) {
         switch (Smb4KSettings::encryptionLevel()) {
         case Smb4KSettings::EnumEncryptionLevel::None: {
-            smbc_setOptionSmbEncryptionLevel(m_context, SMBC_ENCRYPTLEVEL_NONE);
+            encryptionLevel = SMBC_ENCRYPTLEVEL_NONE;
             break;
         }
         case Smb4KSettings::EnumEncryptionLevel::Request: {
-            smbc_setOptionSmbEncryptionLevel(m_context, SMBC_ENCRYPTLEVEL_REQUEST);
+            encryptionLevel = SMBC_ENCRYPTLEVEL_REQUEST;
             break;
         }
         case Smb4KSettings::EnumEncryptionLevel::Require: {
-            smbc_setOptionSmbEncryptionLevel(m_context, SMBC_ENCRYPTLEVEL_REQUIRE);
+            encryptionLevel = SMBC_ENCRYPTLEVEL_REQUIRE;
             break;
         }
         default: {
@@ -636,57 +719,190 @@ void Smb4KClientJob::initClientLibrary()
         }
     }
 
-    //
-    // Set the usage of anonymous login
-    //
-    smbc_setOptionNoAutoAnonymousLogin(m_context, false);
-
-    //
-    // Set the usage of the winbind ccache
-    //
-    smbc_setOptionUseCCache(m_context, Smb4KSettings::useWinbindCCache());
-
     //
     // Set usage of Kerberos
     //
-    if (options) {
-        smbc_setOptionUseKerberos(m_context, options->useKerberos());
-    } else {
-        smbc_setOptionUseKerberos(m_context, Smb4KSettings::useKerberos());
-    }
-
-    smbc_setOptionFallbackAfterKerberos(m_context, 1);
+    bool useKerberos = options ? options->useKerberos() : Smb4KSettings::useKerberos();
 
     //
-    // Set the channel for debug output
+    // Reuse an idle context with exactly these settings. Its connection
+    // to the server is still established and authenticated.
     //
-    smbc_setOptionDebugToStderr(m_context, 1);
+    m_contextKey = QStringList({(*pNetworkItem)->url().host().toUpper(),
+                                userName,
+                                workgroupName.toUpper(),
+                                netbiosName.toUpper(),
+                                QString::number(port),
+                                minimalClientProtocolVersionString,
+                                maximalClientProtocolVersionString,
+                                QString::number(encryptionLevel),
+                                QString::number(useKerberos),
+                                QString::number(Smb4KSettings::useWinbindCCache()),
+                                QString::number(Smb4KSettings::largeNetworkNeighborhood()),
+                                m_lookup->userName,
+                                QString::number(qHash(m_lookup->password))})
+                       .join(QStringLiteral("|"));
 
-    //
-    // Set auth callback function
-    //
-    smbc_setFunctionAuthDataWithContext(m_context, get_auth_data_with_context_fn);
-}
+    m_context = Smb4KClientContextPool::self()->acquire(m_contextKey);
 
-void Smb4KClientJob::doLookups()
-{
-    //
-    // Set the new context
-    //
-    (void)smbc_set_context(m_context);
+    if (m_context) {
+        smbc_setOptionUserData(m_context, m_lookup.data());
+        return;
+    }
 
     //
-    // Get the function to open the directory.
+    // Get new context
     //
-    smbc_opendir_fn openDirectory = smbc_getFunctionOpendir(m_context);
+    m_context = smbc_new_context();
 
-    if (!openDirectory) {
+    if (!m_context) {
         int errorCode = errno;
+
         setError(ClientError);
         setErrorText(QString::fromUtf8(strerror(errorCode), -1));
         return;
     }
 
+    //
+    // Init the context
+    //
+    SMBCCTX *context = smbc_init_context(m_context);
+
+    if (!context) {
+        int errorCode = errno;
+
+        smbc_free_context(m_context, 1);
+        m_context = nullptr;
+
+        setError(ClientError);
+        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+        return;
+    }
+
+    m_context = context;
+
+    //
+    // Set debug level
+    //
+    smbc_setDebug(m_context, SMBC_DEBUG);
+
+    //
+    // Set the NetBIOS name and the workgroup to make connections
+    //
+    if (!netbiosName.isEmpty()) {
+        smbc_setNetbiosName(m_context, netbiosName.toUtf8().data());
+    }
+
+    if (!workgroupName.isEmpty()) {
+        smbc_setWorkgroup(m_context, workgroupName.toUtf8().data());
+    }
+
+    //
+    // Set the user for making the connection
+    //
+    smbc_setUser(m_context, userName.toUtf8().data());
+
+    //
+    // Set the port
+    //
+    smbc_setPort(m_context, port);
+
+    //
+    // Set the user data (the lookup state)
+    //
+    smbc_setOptionUserData(m_context, m_lookup.data());
+
+    //
+    // Set number of master browsers to be used
+    //
+    if (Smb4KSettings::largeNetworkNeighborhood()) {
+        smbc_setOptionBrowseMaxLmbCount(m_context, 3);
+    } else {
+        smbc_setOptionBrowseMaxLmbCount(m_context, 0 /* all master browsers */);
+    }
+
+    //
+    // Set the protocol version if desired
+    //
+    if (!minimalClientProtocolVersionString.isEmpty() && !maximalClientProtocolVersionString.isEmpty()) {
+        smbc_setOptionProtocols(m_context, minimalClientProtocolVersionString.toLatin1().data(), maximalClientProtocolVersionString.toLatin1().data());
+    } else {
+        smbc_setOptionProtocols(m_context, nullptr, nullptr);
+    }
+
+    //
+    // Set the encryption level
+    //
+    if (encryptionLevel != -1) {
+        smbc_setOptionSmbEncryptionLevel(m_context, static_cast<smbc_smb_encrypt_level>(encryptionLevel));
+    }
+
+    //
+    // Set the usage of anonymous login
+    //
+    smbc_setOptionNoAutoAnonymousLogin(m_context, false);
+
+    //
+    // Set the usage of the winbind ccache
+    //
+    smbc_setOptionUseCCache(m_context, Smb4KSettings::useWinbindCCache());
+
+    //
+    // Set usage of Kerberos
+    //
+    smbc_setOptionUseKerberos(m_context, useKerberos);
+    smbc_setOptionFallbackAfterKerberos(m_context, 1);
+
+    //
+    // Set the channel for debug output
+    //
+    smbc_setOptionDebugToStderr(m_context, 1);
+
+    //
+    // Set auth callback function
+    //
+    smbc_setFunctionAuthDataWithContext(m_context, get_auth_data_with_context_fn);
+}
+
+void Smb4KClientJob::doLookups(Smb4KClientLookup *lookup)
+{
+    //
+    // This function runs in the thread pool. Only use the lookup state, that
+    // was filled in slotStartJob(), never the job itself. Do not call smbc_set_context()
+    // here, because it changes the process wide default context.
+    //
+    // Get the function to open the directory.
+    //
+    smbc_opendir_fn openDirectory = smbc_getFunctionOpendir(lookup->context);
+
+    if (!openDirectory) {
+        int errorCode = errno;
+        lookup->error = ClientError;
+        lookup->errorText = QString::fromUtf8(strerror(errorCode), -1);
+        return;
+    }
+
+    //
+    // The contents of shares and directories are passed to the receiver in
+    // portions while the directory is read. So, the IP address of the host
+    // has to be known beforehand.
+    //
+    bool listFiles = (lookup->networkItemType == Share || lookup->networkItemType == FileOrDirectory);
+    QList<Smb4KFileRecord> fileBatch;
+
+    if (listFiles) {
+        lookup->hostAddress = Smb4KHostResolver::self()->lookupAndWait(QStringList{lookup->url.host()}, &lookup->abort).value(lookup->url.host());
+
+        //
+        // If the address is null, the server most likely went offline.
+        //
+        if (lookup->hostAddress.isNull()) {
+            return;
+        }
+
+        fileBatch.reserve(FILE_BATCH_SIZE);
+    }
+
     //
     // Open the directory
     //
@@ -695,29 +911,29 @@ void Smb4KClientJob::doLookups()
     // to stop here in that case, do not throw an error when using DNS-SD and
     // Network and Workgroup (parent) items.
     //
-    SMBCFILE *directory = openDirectory(m_context, (*pNetworkItem)->url().toString().toUtf8().data());
+    SMBCFILE *directory = openDirectory(lookup->context, lookup->url.toString().toUtf8().data());
 
     if (!directory) {
-        if (!(*pNetworkItem)->dnsDiscovered() && !((*pNetworkItem)->type() == Network || (*pNetworkItem)->type() == Workgroup)) {
+        if (!lookup->dnsDiscovered && !(lookup->networkItemType == Network || lookup->networkItemType == Workgroup)) {
             int errorCode = errno;
 
             switch (errorCode) {
             case EACCES:
             case EPERM: {
-                setError(AccessDeniedError);
-                setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+                lookup->error = AccessDeniedError;
+                lookup->errorText = QString::fromUtf8(strerror(errorCode), -1);
                 break;
             }
             case ENOENT: {
-                if ((*pNetworkItem)->type() != Network) {
-                    setError(ClientError);
-                    setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+                if (lookup->networkItemType != Network) {
+                    lookup->error = ClientError;
+                    lookup->errorText = QString::fromUtf8(strerror(errorCode), -1);
                 }
                 break;
             }
             default: {
-                setError(ClientError);
-                setErrorText(QString::fromUtf8(strerror(errorCode), -1));
+                lookup->error = ClientError;
+                lookup->errorText = QString::fromUtf8(strerror(errorCode), -1);
                 break;
             }
             }
@@ -727,391 +943,285 @@ void Smb4KClientJob::doLookups()
     }
 
     //
-    // Read the directory
+    // Close the directory. This is also done on every early return below.
     //
-    struct smbc_dirent *directoryEntry = nullptr;
-    smbc_readdir_fn readDirectory = smbc_getFunctionReaddir(m_context);
+    auto closeDirectory = [lookup, directory]() {
+        smbc_closedir_fn closeDirectoryFunction = smbc_getFunctionClosedir(lookup->context);
 
-    if (!readDirectory) {
-        int errorCode = errno;
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
-        return;
-    }
-
-    while ((directoryEntry = readDirectory(m_context, directory)) != nullptr) {
-        switch (directoryEntry->smbc_type) {
-        case SMBC_WORKGROUP: {
-            //
-            // Create a workgroup pointer
-            //
-            WorkgroupPtr workgroup = WorkgroupPtr(new Smb4KWorkgroup());
-
-            //
-            // Set the workgroup name
-            //
-            QString workgroupName = QString::fromUtf8(directoryEntry->name, -1);
-            workgroup->setWorkgroupName(workgroupName);
-
-            //
-            // Set the master browser
-            //
-            QString masterBrowserName = QString::fromUtf8(directoryEntry->comment, -1);
-            workgroup->setMasterBrowserName(masterBrowserName);
-
-            //
-            // Lookup IP address
-            //
-            QHostAddress address = lookupIpAddress(masterBrowserName);
+        if (!closeDirectoryFunction) {
+            int errorCode = errno;
 
-            //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip the
-            // workgroup and delete the pointer.
-            //
-            if (!address.isNull()) {
-                workgroup->setMasterBrowserIpAddress(address);
-                *pWorkgroups << workgroup;
-            } else {
-                workgroup.clear();
+            if (lookup->error == NoError) {
+                lookup->error = ClientError;
+                lookup->errorText = QString::fromUtf8(strerror(errorCode), -1);
             }
 
-            break;
+            return;
         }
-        case SMBC_SERVER: {
-            //
-            // Create a host pointer
-            //
-            HostPtr host = HostPtr(new Smb4KHost());
-
-            //
-            // Set the workgroup name
-            //
-            host->setWorkgroupName((*pNetworkItem)->url().host());
-
-            //
-            // Set the host name
-            //
-            QString hostName = QString::fromUtf8(directoryEntry->name, -1);
-            host->setHostName(hostName);
 
-            //
-            // Set the comment
-            //
-            QString comment = QString::fromUtf8(directoryEntry->comment, -1);
-            host->setComment(comment);
+        (void)closeDirectoryFunction(lookup->context, directory);
+    };
 
-            //
-            // Lookup IP address
-            //
-            QHostAddress address = lookupIpAddress(hostName);
+    auto closeDirectoryGuard = qScopeGuard(closeDirectory);
 
-            //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip it
-            // and delete the pointer.
-            //
-            if (!address.isNull()) {
-                host->setIpAddress(address);
-                *pHosts << host;
-            } else {
-                host.clear();
-            }
+    //
+    // Read the directory
+    //
+    if (listFiles) {
+        //
+        // Use readdirplus for files and directories, because it returns the
+        // size, the time stamps and the attributes together with the name.
+        // This way no extra round trip per entry is needed to stat it.
+        //
+        smbc_readdirplus2_fn readDirectoryPlus = smbc_getFunctionReaddirPlus2(lookup->context);
 
-            break;
+        if (!readDirectoryPlus) {
+            int errorCode = errno;
+            lookup->error = ClientError;
+            lookup->errorText = QString::fromUtf8(strerror(errorCode), -1);
+            return;
         }
-        case SMBC_FILE_SHARE: {
-            //
-            // Create a share pointer
-            //
-            SharePtr share = SharePtr(new Smb4KShare());
 
-            //
-            // Set the workgroup name
-            //
-            share->setWorkgroupName((*pNetworkItem).staticCast<Smb4KHost>()->workgroupName());
-
-            //
-            // Set the host name
-            //
-            share->setHostName((*pNetworkItem)->url().host());
-
-            //
-            // Set the share name
-            //
-            share->setShareName(QString::fromUtf8(directoryEntry->name, -1));
-
-            //
-            // Set the comment
-            //
-            share->setComment(QString::fromUtf8(directoryEntry->comment, -1));
+        const struct libsmb_file_info *fileInfo = nullptr;
+        struct stat fileStat;
 
+        while ((fileInfo = readDirectoryPlus(lookup->context, directory, &fileStat)) != nullptr) {
             //
-            // Set share type
+            // Stop, if the job was killed
             //
-            share->setShareType(FileShare);
-
-            //
-            // Set the authentication data
-            //
-            share->setUserName((*pNetworkItem)->url().userName());
-            share->setPassword((*pNetworkItem)->url().password());
-
-            //
-            // Lookup IP address
-            //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
-
-            //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip it
-            // and delete the pointer.
-            //
-            if (!address.isNull()) {
-                share->setHostIpAddress(address);
-                *pShares << share;
-            } else {
-                share.clear();
+            if (lookup->abort) {
+                break;
             }
 
-            break;
-        }
-        case SMBC_PRINTER_SHARE: {
-            //
-            // Create a share pointer
-            //
-            SharePtr share = SharePtr(new Smb4KShare());
-
-            //
-            // Set the workgroup name
-            //
-            share->setWorkgroupName((*pNetworkItem).staticCast<Smb4KHost>()->workgroupName());
-
-            //
-            // Set the host name
-            //
-            share->setHostName((*pNetworkItem)->url().host());
-
             //
-            // Set the share name
+            // Do not process '.' and '..' directories
             //
-            share->setShareName(QString::fromUtf8(directoryEntry->name, -1));
+            QString name = QString::fromUtf8(fileInfo->name, -1);
 
-            //
-            // Set the comment
-            //
-            share->setComment(QString::fromUtf8(directoryEntry->comment, -1));
+            if (name == QStringLiteral(".") || name == QStringLiteral("..")) {
+                continue;
+            }
 
             //
-            // Set share type
+            // Create the URL for the discovered item
             //
-            share->setShareType(PrinterShare);
+            QUrl u = lookup->url;
+            u.setPath(lookup->url.path() + QDir::separator() + name);
 
             //
-            // Set the authentication data
+            // Record the file or directory with its metadata. The file object
+            // is created in the main thread.
             //
-            share->setUserName((*pNetworkItem)->url().userName());
-            share->setPassword((*pNetworkItem)->url().password());
+            Smb4KFileRecord file;
+            file.url = u;
+            file.directory = S_ISDIR(fileStat.st_mode);
+            file.size = static_cast<qint64>(fileInfo->size);
+            file.lastModified = QDateTime::fromMSecsSinceEpoch(qint64(fileInfo->mtime_ts.tv_sec) * 1000 + fileInfo->mtime_ts.tv_nsec / 1000000);
+            file.lastAccessed = QDateTime::fromMSecsSinceEpoch(qint64(fileInfo->atime_ts.tv_sec) * 1000 + fileInfo->atime_ts.tv_nsec / 1000000);
+            file.attributes = fileInfo->attrs;
 
             //
-            // Lookup IP address
+            // Add the file or directory and pass a full portion on
             //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+            fileBatch << file;
 
-            //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip it
-            // and delete the pointer.
-            //
-            if (!address.isNull()) {
-                share->setHostIpAddress(address);
-                *pShares << share;
-            } else {
-                share.clear();
+            if (fileBatch.size() >= FILE_BATCH_SIZE) {
+                sendFiles(lookup, fileBatch);
+                fileBatch.clear();
             }
-
-            break;
         }
-        case SMBC_IPC_SHARE: {
-            //
-            // Create a share pointer
-            //
-            SharePtr share = SharePtr(new Smb4KShare());
 
-            //
-            // Set the workgroup name
-            //
-            share->setWorkgroupName((*pNetworkItem).staticCast<Smb4KHost>()->workgroupName());
-
-            //
-            // Set the host name
-            //
-            share->setHostName((*pNetworkItem)->url().host());
-
-            //
-            // Set the share name
-            //
-            share->setShareName(QString::fromUtf8(directoryEntry->name, -1));
-
-            //
-            // Set the comment
-            //
-            share->setComment(QString::fromUtf8(directoryEntry->comment, -1));
-
-            //
-            // Set share type
-            //
-            share->setShareType(IpcShare);
-
-            //
-            // Set the authentication data
-            //
-            share->setUserName((*pNetworkItem)->url().userName());
-            share->setPassword((*pNetworkItem)->url().password());
+        //
+        // Pass the remaining files and directories on
+        //
+        if (!fileBatch.isEmpty() && !lookup->abort) {
+            sendFiles(lookup, fileBatch);
+        }
+    } else {
+        struct smbc_dirent *directoryEntry = nullptr;
+        smbc_readdir_fn readDirectory = smbc_getFunctionReaddir(lookup->context);
 
-            //
-            // Lookup IP address
-            //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+        if (!readDirectory) {
+            int errorCode = errno;
+            lookup->error = ClientError;
+            lookup->errorText = QString::fromUtf8(strerror(errorCode), -1);
+            return;
+        }
 
+        while ((directoryEntry = readDirectory(lookup->context, directory)) != nullptr) {
             //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip it
-            // and delete the pointer.
+            // Stop, if the job was killed
             //
-            if (!address.isNull()) {
-                share->setHostIpAddress(address);
-                *pShares << share;
-            } else {
-                share.clear();
+            if (lookup->abort) {
+                break;
             }
 
-            break;
-        }
-        case SMBC_DIR: {
-            //
-            // Do not process '.' and '..' directories
-            //
-            QString name = QString::fromUtf8(directoryEntry->name, -1);
-
-            if (name != QStringLiteral(".") && name != QStringLiteral("..")) {
+            switch (directoryEntry->smbc_type) {
+            case SMBC_WORKGROUP: {
                 //
-                // Create the URL for the discovered item
+                // Record the workgroup and its master browser. The IP
+                // address is looked up later.
                 //
-                QUrl u = (*pNetworkItem)->url();
-                u.setPath((*pNetworkItem)->url().path() + QDir::separator() + QString::fromUtf8(directoryEntry->name, -1));
+                Smb4KWorkgroupRecord workgroup;
+                workgroup.workgroupName = QString::fromUtf8(directoryEntry->name, -1);
+                workgroup.masterBrowserName = QString::fromUtf8(directoryEntry->comment, -1);
 
-                //
-                // We do not stat directories. Directly create the directory object
-                //
-                FilePtr dir = FilePtr(new Smb4KFile(u));
-                dir->setDirectory(true);
+                lookup->workgroups << workgroup;
 
+                break;
+            }
+            case SMBC_SERVER: {
                 //
-                // Set the workgroup name
+                // Record the host. The IP address is looked up later.
                 //
-                dir->setWorkgroupName((*pNetworkItem).staticCast<Smb4KShare>()->workgroupName());
+                Smb4KHostRecord host;
+                host.workgroupName = lookup->url.host();
+                host.hostName = QString::fromUtf8(directoryEntry->name, -1);
+                host.comment = QString::fromUtf8(directoryEntry->comment, -1);
 
-                //
-                // Set the authentication data
-                //
-                dir->setUserName((*pNetworkItem)->url().userName());
-                dir->setPassword((*pNetworkItem)->url().password());
-
-                //
-                // Lookup IP address
-                //
-                QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+                lookup->hosts << host;
 
+                break;
+            }
+            case SMBC_FILE_SHARE:
+            case SMBC_PRINTER_SHARE:
+            case SMBC_IPC_SHARE: {
                 //
-                // Process the IP address.
-                // If the address is null, the server most likely went offline. So, skip it
-                // and delete the pointer.
+                // Record the share including the authentication data. The IP
+                // address is looked up later.
                 //
-                if (!address.isNull()) {
-                    dir->setHostIpAddress(address);
-                    *pFiles << dir;
+                Smb4KShareRecord share;
+                share.url.setScheme(QStringLiteral("smb"));
+                share.url.setHost(lookup->url.host());
+                share.url.setPath(QStringLiteral("/") + QString::fromUtf8(directoryEntry->name, -1).trimmed());
+                share.url.setUserName(lookup->url.userName());
+                share.url.setPassword(lookup->url.password());
+                share.workgroupName = lookup->workgroupName;
+                share.comment = QString::fromUtf8(directoryEntry->comment, -1);
+
+                if (directoryEntry->smbc_type == SMBC_PRINTER_SHARE) {
+                    share.shareType = PrinterShare;
+                } else if (directoryEntry->smbc_type == SMBC_IPC_SHARE) {
+                    share.shareType = IpcShare;
                 } else {
-                    dir.clear();
+                    share.shareType = FileShare;
                 }
-            }
 
-            break;
+                lookup->shares << share;
+
+                break;
+            }
+            case SMBC_LINK: {
+                qDebug() << "Processing links is not implemented.";
+                qDebug() << directoryEntry->name;
+                qDebug() << directoryEntry->comment;
+                break;
+            }
+            default: {
+                qDebug() << "Need to process network item " << directoryEntry->name;
+                break;
+            }
+            }
         }
-        case SMBC_FILE: {
-            //
-            // Create the URL for the discovered item
-            //
-            QUrl u = (*pNetworkItem)->url();
-            u.setPath((*pNetworkItem)->url().path() + QDir::separator() + QString::fromUtf8(directoryEntry->name, -1));
+    }
 
-            //
-            // Create the file object
-            //
-            FilePtr file = FilePtr(new Smb4KFile(u));
+    //
+    // Close the directory before the IP addresses are looked up
+    //
+    closeDirectoryGuard.dismiss();
+    closeDirectory();
 
-            //
-            // Set the workgroup name
-            //
-            file->setWorkgroupName((*pNetworkItem).staticCast<Smb4KShare>()->workgroupName());
+    if (lookup->error != NoError) {
+        return;
+    }
 
-            //
-            // Stat the file
-            //
-            // FIXME
+    //
+    // Look up the IP addresses. All names are resolved in one go, so that
+    // the host of the shares is only looked up once.
+    //
+    QStringList names;
 
-            //
-            // Set the authentication data
-            //
-            file->setUserName((*pNetworkItem)->url().userName());
-            file->setPassword((*pNetworkItem)->url().password());
+    for (const Smb4KWorkgroupRecord &workgroup : std::as_const(lookup->workgroups)) {
+        names << workgroup.masterBrowserName;
+    }
 
-            //
-            // Lookup IP address
-            //
-            QHostAddress address = lookupIpAddress((*pNetworkItem)->url().host());
+    for (const Smb4KHostRecord &host : std::as_const(lookup->hosts)) {
+        names << host.hostName;
+    }
 
-            //
-            // Process the IP address.
-            // If the address is null, the server most likely went offline. So, skip it
-            // and delete the pointer.
-            //
-            if (!address.isNull()) {
-                file->setHostIpAddress(address);
-                *pFiles << file;
-            } else {
-                file.clear();
-            }
+    if (!lookup->shares.isEmpty()) {
+        names << lookup->url.host();
+    }
 
-            break;
-        }
-        case SMBC_LINK: {
-            qDebug() << "Processing links is not implemented.";
-            qDebug() << directoryEntry->name;
-            qDebug() << directoryEntry->comment;
-            break;
-        }
-        default: {
-            qDebug() << "Need to process network item " << directoryEntry->name;
-            break;
+    names.removeDuplicates();
+
+    if (names.isEmpty()) {
+        return;
+    }
+
+    QMap<QString, QHostAddress> addresses = Smb4KHostResolver::self()->lookupAndWait(names, &lookup->abort);
+
+    //
+    // Process the IP addresses.
+    // If an address is null, the server most likely went offline. So, remove
+    // the respective items.
+    //
+    for (Smb4KWorkgroupRecord &workgroup : lookup->workgroups) {
+        workgroup.masterBrowserIpAddress = addresses.value(workgroup.masterBrowserName);
+    }
+
+    lookup->workgroups.removeIf([](const Smb4KWorkgroupRecord &workgroup) {
+        return workgroup.masterBrowserIpAddress.isNull();
+    });
+
+    for (Smb4KHostRecord &host : lookup->hosts) {
+        host.ipAddress = addresses.value(host.hostName);
+    }
+
+    lookup->hosts.removeIf([](const Smb4KHostRecord &host) {
+        return host.ipAddress.isNull();
+    });
+
+    QHostAddress hostAddress = addresses.value(lookup->url.host());
+
+    if (!hostAddress.isNull()) {
+        for (Smb4KShareRecord &share : lookup->shares) {
+            share.hostIpAddress = hostAddress;
         }
+    } else {
+        lookup->shares.clear();
+    }
+}
+
+void Smb4KClientJob::sendFiles(Smb4KClientLookup *lookup, const QList<Smb4KFileRecord> &files)
+{
+    //
+    // Do not read ahead too far, if the receiver cannot keep up. Check
+    // regularly if the job was killed while waiting.
+    //
+    while (!lookup->pendingBatches.tryAcquire(1, 100)) {
+        if (lookup->abort) {
+            return;
         }
     }
 
     //
-    // Close the directory
+    // The files are emitted from the main thread. Queued calls to the
+    // job are delivered in order, so all portions arrive before the
+    // result is emitted in slotLookupsFinished().
     //
-    smbc_closedir_fn closeDirectory = smbc_getFunctionClosedir(m_context);
+    QMutexLocker locker(&lookup->jobMutex);
 
-    if (!closeDirectory) {
-        int errorCode = errno;
+    if (lookup->job) {
+        Smb4KClientJob *job = lookup->job;
 
-        setError(ClientError);
-        setErrorText(QString::fromUtf8(strerror(errorCode), -1));
-        return;
+        QMetaObject::invokeMethod(
+            job,
+            [job, files]() {
+                job->slotEmitFiles(files);
+            },
+            Qt::QueuedConnection);
     }
-
-    (void)closeDirectory(m_context, directory);
 }
 
 void Smb4KClientJob::doPrinting()
@@ -1267,13 +1377,59 @@ void Smb4KClientJob::doPrinting()
     closePrinter(m_context, printer);
 }
 
+bool Smb4KClientJob::doKill()
+{
+    //
+    // A running lookup cannot be interrupted inside libsmbclient. Tell it
+    // to stop and let slotLookupsFinished() finish the job. A worker that
+    // waits for addresses returns right away.
+    //
+    m_lookup->abort = true;
+    Smb4KHostResolver::self()->cancelWaits();
+
+    return !m_lookupRunning;
+}
+
 void Smb4KClientJob::slotStartJob()
 {
+    //
+    // Do nothing, if the job was killed before it was started
+    //
+    if (m_lookup->abort) {
+        return;
+    }
+
+    //
+    // The type is needed by the authentication function
+    //
+    m_lookup->networkItemType = (*pNetworkItem)->type();
+
+    //
+    // Initialize the thread support of the client library once
+    //
+    static bool threadsInitialized = false;
+
+    if (!threadsInitialized) {
+        smbc_thread_posix();
+        threadsInitialized = true;
+    }
+
+    //
+    // Read the credentials first, because the pooled contexts are
+    // distinguished by them
+    //
+    readLoginCredentials();
+
     //
     // Initialize the client library
     //
     initClientLibrary();
 
+    if (error() != 0) {
+        emitResult();
+        return;
+    }
+
     //
     // Process the given URL according to the passed process
     //
@@ -1283,10 +1439,54 @@ void Smb4KClientJob::slotStartJob()
     case LookupShares:
     case LookupFiles: {
         //
-        // Do lookups using the client library
+        // Copy everything the lookup needs, because the worker thread must
+        // neither access the credentials manager nor the network item, that
+        // might be modified in the main thread in the meantime.
         //
-        doLookups();
-        break;
+        m_lookup->context = m_context;
+        m_lookup->url = (*pNetworkItem)->url();
+        m_lookup->dnsDiscovered = (*pNetworkItem)->dnsDiscovered();
+
+        switch ((*pNetworkItem)->type()) {
+        case Host: {
+            m_lookup->workgroupName = (*pNetworkItem).staticCast<Smb4KHost>()->workgroupName();
+            break;
+        }
+        case Share: {
+            m_lookup->workgroupName = (*pNetworkItem).staticCast<Smb4KShare>()->workgroupName();
+            break;
+        }
+        case FileOrDirectory: {
+            m_lookup->workgroupName = (*pNetworkItem).staticCast<Smb4KFile>()->workgroupName();
+            break;
+        }
+        default: {
+            break;
+        }
+        }
+
+        //
+        // Do lookups using the client library in the thread pool. The result
+        // is emitted from the main thread in slotLookupsFinished(). The worker
+        // only holds the lookup state, so the job does not need to wait for it,
+        // if it is destroyed in the meantime.
+        //
+        m_lookupRunning = true;
+
+        QSharedPointer<Smb4KClientLookup> lookup = m_lookup;
+
+        clientThreadPool->setMaxThreadCount(Smb4KSettings::maximumParallelLookups());
+        clientThreadPool->start([lookup]() {
+            doLookups(lookup.data());
+
+            QMutexLocker locker(&lookup->jobMutex);
+
+            if (lookup->job) {
+                QMetaObject::invokeMethod(lookup->job, &Smb4KClientJob::slotLookupsFinished, Qt::QueuedConnection);
+            }
+        });
+
+        return;
     }
     case PrintFile: {
         //
@@ -1308,9 +1508,73 @@ void Smb4KClientJob::slotStartJob()
 
 void Smb4KClientJob::slotFinishJob()
 {
+    //
+    // Give the context back to the pool. Contexts of failed jobs are discarded,
+    // because their connection might be broken or authenticated with the wrong
+    // credentials.
+    //
     if (m_context != nullptr) {
-        smbc_free_context(m_context, 1);
+        Smb4KClientContextPool::self()->release(m_contextKey, m_context, error() == 0);
+        m_context = nullptr;
+    }
+}
+
+void Smb4KClientJob::slotLookupsFinished()
+{
+    //
+    // The worker is done with the lookup state, so the results can be
+    // taken over
+    //
+    m_lookupRunning = false;
+
+    *pWorkgroups = m_lookup->workgroups;
+    *pHosts = m_lookup->hosts;
+    *pShares = m_lookup->shares;
+
+    if (m_lookup->abort) {
+        setError(KilledJobError);
+    } else if (m_lookup->error != 0) {
+        setError(m_lookup->error);
+        setErrorText(m_lookup->errorText);
     }
+
+    //
+    // Emit the result
+    //
+    emitResult();
+}
+
+void Smb4KClientJob::slotEmitFiles(const QList<Smb4KFileRecord> &files)
+{
+    if (!m_lookup->abort) {
+        //
+        // Create the file objects in the main thread
+        //
+        QList<FilePtr> list;
+        list.reserve(files.size());
+
+        for (const Smb4KFileRecord &record : files) {
+            FilePtr file = FilePtr(new Smb4KFile(record.url));
+            file->setDirectory(record.directory);
+            file->setWorkgroupName(m_lookup->workgroupName);
+            file->setSize(record.size);
+            file->setLastModified(record.lastModified);
+            file->setLastAccessed(record.lastAccessed);
+            file->setAttributes(record.attributes);
+            file->setUserName(m_lookup->url.userName());
+            file->setPassword(m_lookup->url.password());
+            file->setHostIpAddress(m_lookup->hostAddress);
+
+            list << file;
+        }
+
+        Q_EMIT filesReceived(list);
+    }
+
+    //
+    // Let the worker continue with the next portion
+    //
+    m_lookup->pendingBatches.release();
 }
 
 Smb4KDnsDiscoveryJob::Smb4KDnsDiscoveryJob(QObject *parent)
@@ -1370,8 +1634,8 @@ void Smb4KDnsDiscoveryJob::slotServiceAdded(KDNSSD::RemoteService::Ptr service)
         //
         bool foundWorkgroup = false;
 
-        for (const WorkgroupPtr &w : std::as_const(*pWorkgroups)) {
-            if (QString::compare(w->workgroupName(), service->domain(), Qt::CaseInsensitive) == 0) {
+        for (const Smb4KWorkgroupRecord &w : std::as_const(*pWorkgroups)) {
+            if (QString::compare(w.workgroupName, service->domain(), Qt::CaseInsensitive) == 0) {
                 foundWorkgroup = true;
                 break;
             }
@@ -1382,23 +1646,13 @@ void Smb4KDnsDiscoveryJob::slotServiceAdded(KDNSSD::RemoteService::Ptr service)
         //
         if (!foundWorkgroup) {
             //
-            // Create the workgroup item
+            // Record the _DNS-SD_ domain and tell the program that it
+            // was discovered by DNS-SD
             //
-            WorkgroupPtr workgroup = WorkgroupPtr(new Smb4KWorkgroup());
+            Smb4KWorkgroupRecord workgroup;
+            workgroup.workgroupName = service->domain();
+            workgroup.dnsDiscovered = true;
 
-            //
-            // Set the _DNS-SD_ domain name
-            //
-            workgroup->setWorkgroupName(service->domain());
-
-            //
-            // Tell the program that the workgroup was discovered by DNS-SD
-            //
-            workgroup->setDnsDiscovered(true);
-
-            //
-            // Add the workgroup
-            //
             *pWorkgroups << workgroup;
         }
         break;
@@ -1409,13 +1663,13 @@ void Smb4KDnsDiscoveryJob::slotServiceAdded(KDNSSD::RemoteService::Ptr service)
         //
         bool foundServer = false;
 
-        for (const HostPtr &h : std::as_const(*pHosts)) {
+        for (const Smb4KHostRecord &h : std::as_const(*pHosts)) {
             //
             // On a local network there will most likely be no two servers with
             // identical name, thus, to avoid duplicates, only test the hostname
             // here.
             //
-            if (QString::compare(h->hostName(), service->serviceName(), Qt::CaseInsensitive) == 0) {
+            if (QString::compare(h.hostName, service->serviceName(), Qt::CaseInsensitive) == 0) {
                 foundServer = true;
                 break;
             }
@@ -1426,40 +1680,15 @@ void Smb4KDnsDiscoveryJob::slotServiceAdded(KDNSSD::RemoteService::Ptr service)
         //
         if (!foundServer) {
             //
-            // Create the host item
-            //
-            HostPtr host = HostPtr(new Smb4KHost());
-
-            //
-            // Set the _DNS-SD_ host name
-            //
-            host->setHostName(service->serviceName());
-
-            //
-            // Set the _DNS-SD_ domain name
-            //
-            host->setWorkgroupName(service->domain());
-
-            //
-            // Tell the program that the host was discovered by DNS-SD
-            //
-            host->setDnsDiscovered(true);
-
-            //
-            // Lookup IP address
+            // Record the _DNS-SD_ host and domain names and tell the program
+            // that the host was discovered by DNS-SD. The IP address is looked
+            // up when the discovery finished.
             //
-            QHostAddress address = lookupIpAddress(service->serviceName());
-
-            //
-            // Process the IP address.
-            //
-            if (!address.isNull()) {
-                host->setIpAddress(address);
-            }
+            Smb4KHostRecord host;
+            host.hostName = service->serviceName();
+            host.workgroupName = service->domain();
+            host.dnsDiscovered = true;
 
-            //
-            // Add the host
-            //
             *pHosts << host;
         }
 
@@ -1473,7 +1702,7 @@ void Smb4KDnsDiscoveryJob::slotServiceAdded(KDNSSD::RemoteService::Ptr service)
 
 void Smb4KDnsDiscoveryJob::slotFinished()
 {
-    emitResult();
+    emitResultWhenResolved();
 }
 
 #ifdef USE_WS_DISCOVERY
@@ -1481,6 +1710,7 @@ Smb4KWsDiscoveryJob::Smb4KWsDiscoveryJob(QObject *parent)
     : Smb4KClientBaseJob(parent)
 {
     m_discoveryClient = new WSDiscoveryClient(this);
+    m_timedOut = false;
 
     m_timer = new QTimer(this);
     m_timer->setSingleShot(true);
@@ -1493,6 +1723,14 @@ Smb4KWsDiscoveryJob::Smb4KWsDiscoveryJob(QObject *parent)
 
 Smb4KWsDiscoveryJob::~Smb4KWsDiscoveryJob()
 {
+    //
+    // Delete the watchers before the client interfaces that own the
+    // network replies they watch
+    //
+    for (auto it = m_runningRequests.constBegin(); it != m_runningRequests.constEnd(); ++it) {
+        delete it.key();
+        delete it.value().clientInterface;
+    }
 }
 
 void Smb4KWsDiscoveryJob::start()
@@ -1530,190 +1768,16 @@ void Smb4KWsDiscoveryJob::slotProbeMatchReceived(const WSDiscoveryTargetService
     // Stop the timer
     //
     m_timer->stop();
+    m_timedOut = false;
 
     //
     // If there is no address, we need to resolve it. Otherwise,
-    // resolve the available addresses and add the discovered network
-    // items to the respective lists.
+    // request the metadata from the available addresses.
     //
     if (service.xAddrList().isEmpty()) {
         m_discoveryClient->sendResolve(service.endpointReference());
     } else {
-        if (!service.xAddrList().isEmpty()) {
-            for (const QUrl &address : service.xAddrList()) {
-                KDSoapClientInterface clientInterface(address.toString(), QStringLiteral("http://schemas.xmlsoap.org/ws/2004/09/transfer"));
-                clientInterface.setSoapVersion(KDSoapClientInterface::SoapVersion::SOAP1_2);
-                clientInterface.setTimeout(5000);
-
-                KDSoapMessage soapMessage;
-                KDSoapMessageAddressingProperties soapMessageProperties;
-                soapMessageProperties.setAddressingNamespace(KDSoapMessageAddressingProperties::Addressing200408);
-                soapMessageProperties.setAction(QStringLiteral("http://schemas.xmlsoap.org/ws/2004/09/transfer/Get"));
-                soapMessageProperties.setMessageID(QStringLiteral("urn:uuid:") + QUuid::createUuid().toString(QUuid::WithoutBraces));
-                soapMessageProperties.setDestination(service.endpointReference());
-                soapMessageProperties.setReplyEndpointAddress(
-                    KDSoapMessageAddressingProperties::predefinedAddressToString(KDSoapMessageAddressingProperties::Anonymous,
-                                                                                 KDSoapMessageAddressingProperties::Addressing200408));
-                soapMessageProperties.setSourceEndpointAddress(QStringLiteral("urn:uuid:") + QUuid::createUuid().toString(QUuid::WithoutBraces));
-                soapMessage.setMessageAddressingProperties(soapMessageProperties);
-
-                KDSoapMessage response = clientInterface.call(QString(), soapMessage);
-
-                if (!response.isFault()) {
-                    KDSoapValueList childValues = response.childValues();
-
-                    for (const KDSoapValue &value : std::as_const(childValues)) {
-                        QString entry = value.childValues()
-                                            .child(QStringLiteral("Relationship"))
-                                            .childValues()
-                                            .child(QStringLiteral("Host"))
-                                            .childValues()
-                                            .child(QStringLiteral("Computer"))
-                                            .value()
-                                            .toString();
-
-                        switch (*pProcess) {
-                        case LookupDomains: {
-                            //
-                            // Get the name of the workgroup or domain
-                            //
-                            QString workgroupName = entry.section(QStringLiteral(":"), 1, -1);
-
-                            //
-                            // Work around an empty workgroup/domain name. Use the "LOCAL" domain from
-                            // DNS-SD for that.
-                            //
-                            if (workgroupName.isEmpty()) {
-                                workgroupName = QStringLiteral("LOCAL");
-                            }
-
-                            //
-                            // Process the workgroup name. Only add a new workgroup, if it
-                            // is not present already.
-                            //
-                            bool foundWorkgroup = false;
-
-                            for (const WorkgroupPtr &w : std::as_const(*pWorkgroups)) {
-                                if (QString::compare(w->workgroupName(), workgroupName, Qt::CaseInsensitive) == 0) {
-                                    foundWorkgroup = true;
-                                    break;
-                                }
-                            }
-
-                            //
-                            // If the workgroup is unknown, add it to the list
-                            //
-                            if (!foundWorkgroup) {
-                                //
-                                // Create the workgroup object
-                                //
-                                WorkgroupPtr workgroup = WorkgroupPtr(new Smb4KWorkgroup());
-
-                                //
-                                // Set the workgroup/domain name
-                                //
-                                workgroup->setWorkgroupName(workgroupName);
-
-                                //
-                                // Add the workgroup
-                                //
-                                *pWorkgroups << workgroup;
-                            }
-
-                            break;
-                        }
-                        case LookupDomainMembers: {
-                            //
-                            // Get the workgroup name
-                            //
-                            QString workgroupName = entry.section(QStringLiteral(":"), 1, -1);
-
-                            //
-                            // Work around an empty workgroup/domain name. Use the "LOCAL" domain from
-                            // DNS-SD for that.
-                            //
-                            if (workgroupName.isEmpty()) {
-                                workgroupName = QStringLiteral("LOCAL");
-                            }
-
-                            //
-                            // Get the host name. Unfortunately, the delimiter depends on
-                            // whether the host is member of a workgroup (/) or domain (\).
-                            //
-                            QString hostName;
-
-                            if (entry.contains(QStringLiteral("/"))) {
-                                hostName = entry.section(QStringLiteral("/"), 0, 0);
-                            } else if (entry.contains(QStringLiteral("\\"))) {
-                                hostName = entry.section(QStringLiteral("\\"), 0, 0);
-                            }
-
-                            //
-                            // Process the host name. Only add a new host, if it
-                            // is not present already.
-                            //
-                            if (!hostName.isEmpty()) {
-                                //
-                                // Check if the server is already known
-                                //
-                                bool foundServer = false;
-
-                                for (const HostPtr &h : std::as_const(*pHosts)) {
-                                    if (QString::compare(h->hostName(), hostName, Qt::CaseInsensitive) == 0
-                                        && QString::compare(h->workgroupName(), workgroupName, Qt::CaseInsensitive) == 0) {
-                                        foundServer = true;
-                                        break;
-                                    }
-                                }
-
-                                //
-                                // If the server is unknown, add it to the list
-                                //
-                                if (!foundServer) {
-                                    //
-                                    // Create the host object
-                                    //
-                                    HostPtr host = HostPtr(new Smb4KHost());
-
-                                    //
-                                    // Set the workgroup/domain name
-                                    //
-                                    host->setWorkgroupName(workgroupName);
-
-                                    //
-                                    // Set the host name
-                                    //
-                                    host->setHostName(hostName);
-
-                                    //
-                                    // Lookup IP address
-                                    //
-                                    QHostAddress address = lookupIpAddress(hostName);
-
-                                    //
-                                    // Process the IP address.
-                                    //
-                                    if (!address.isNull()) {
-                                        host->setIpAddress(address);
-                                    }
-
-                                    //
-                                    // Add the host
-                                    //
-                                    *pHosts << host;
-                                }
-                            }
-
-                            break;
-                        }
-                        default: {
-                            break;
-                        }
-                        }
-                    }
-                }
-            }
-        }
+        queueRequests(service);
     }
 
     //
@@ -1728,185 +1792,13 @@ void Smb4KWsDiscoveryJob::slotResolveMatchReceived(const WSDiscoveryTargetServic
     // Stop the timer
     //
     m_timer->stop();
+    m_timedOut = false;
 
     //
-    // If there are addresses available, resolve them and add the
-    // discovered network items to the respective lists.
+    // If there are addresses available, request the metadata from them.
     //
     if (!service.xAddrList().isEmpty()) {
-        for (const QUrl &address : service.xAddrList()) {
-            KDSoapClientInterface clientInterface(address.toString(), QStringLiteral("http://schemas.xmlsoap.org/ws/2004/09/transfer"));
-            clientInterface.setSoapVersion(KDSoapClientInterface::SoapVersion::SOAP1_2);
-            clientInterface.setTimeout(5000);
-
-            KDSoapMessage soapMessage;
-            KDSoapMessageAddressingProperties soapMessageProperties;
-            soapMessageProperties.setAddressingNamespace(KDSoapMessageAddressingProperties::Addressing200408);
-            soapMessageProperties.setAction(QStringLiteral("http://schemas.xmlsoap.org/ws/2004/09/transfer/Get"));
-            soapMessageProperties.setMessageID(QStringLiteral("urn:uuid:") + QUuid::createUuid().toString(QUuid::WithoutBraces));
-            soapMessageProperties.setDestination(service.endpointReference());
-            soapMessageProperties.setReplyEndpointAddress(
-                KDSoapMessageAddressingProperties::predefinedAddressToString(KDSoapMessageAddressingProperties::Anonymous,
-                                                                             KDSoapMessageAddressingProperties::Addressing200408));
-            soapMessageProperties.setSourceEndpointAddress(QStringLiteral("urn:uuid:") + QUuid::createUuid().toString(QUuid::WithoutBraces));
-            soapMessage.setMessageAddressingProperties(soapMessageProperties);
-
-            KDSoapMessage response = clientInterface.call(QString(), soapMessage);
-
-            if (!response.isFault()) {
-                KDSoapValueList childValues = response.childValues();
-
-                for (const KDSoapValue &value : std::as_const(childValues)) {
-                    QString entry = value.childValues()
-                                        .child(QStringLiteral("Relationship"))
-                                        .childValues()
-                                        .child(QStringLiteral("Host"))
-                                        .childValues()
-                                        .child(QStringLiteral("Computer"))
-                                        .value()
-                                        .toString();
-
-                    switch (*pProcess) {
-                    case LookupDomains: {
-                        //
-                        // Get the name of the workgroup or domain
-                        //
-                        QString workgroupName = entry.section(QStringLiteral(":"), 1, -1);
-
-                        //
-                        // Work around an empty workgroup/domain name. Use the "LOCAL" domain from
-                        // DNS-SD for that.
-                        //
-                        if (workgroupName.isEmpty()) {
-                            workgroupName = QStringLiteral("LOCAL");
-                        }
-
-                        //
-                        // Process the workgroup name. Only add a new workgroup, if it
-                        // is not present already.
-                        //
-                        bool foundWorkgroup = false;
-
-                        for (const WorkgroupPtr &w : std::as_const(*pWorkgroups)) {
-                            if (QString::compare(w->workgroupName(), workgroupName, Qt::CaseInsensitive) == 0) {
-                                foundWorkgroup = true;
-                                break;
-                            }
-                        }
-
-                        //
-                        // If the workgroup is unknown, add it to the list
-                        //
-                        if (!foundWorkgroup) {
-                            //
-                            // Create the workgroup object
-                            //
-                            WorkgroupPtr workgroup = WorkgroupPtr(new Smb4KWorkgroup());
-
-                            //
-                            // Set the workgroup/domain name
-                            //
-                            workgroup->setWorkgroupName(workgroupName);
-
-                            //
-                            // Add the workgroup
-                            //
-                            *pWorkgroups << workgroup;
-                        }
-
-                        break;
-                    }
-                    case LookupDomainMembers: {
-                        //
-                        // Get the workgroup name
-                        //
-                        QString workgroupName = entry.section(QStringLiteral(":"), 1, -1);
-
-                        //
-                        // Work around an empty workgroup/domain name. Use the "LOCAL" domain from
-                        // DNS-SD for that.
-                        //
-                        if (workgroupName.isEmpty()) {
-                            workgroupName = QStringLiteral("LOCAL");
-                        }
-
-                        //
-                        // Get the host name. Unfortunately, the delimiter depends on
-                        // whether the host is member of a workgroup (/) or domain (\).
-                        //
-                        QString hostName;
-
-                        if (entry.contains(QStringLiteral("/"))) {
-                            hostName = entry.section(QStringLiteral("/"), 0, 0);
-                        } else if (entry.contains(QStringLiteral("\\"))) {
-                            hostName = entry.section(QStringLiteral("\\"), 0, 0);
-                        }
-
-                        //
-                        // Process the host name. Only add a new host, if it
-                        // is not present already.
-                        //
-                        if (!hostName.isEmpty()) {
-                            //
-                            // Check if the server is already known
-                            //
-                            bool foundServer = false;
-
-                            for (const HostPtr &h : std::as_const(*pHosts)) {
-                                if (QString::compare(h->hostName(), hostName, Qt::CaseInsensitive) == 0
-                                    && QString::compare(h->workgroupName(), workgroupName, Qt::CaseInsensitive) == 0) {
-                                    foundServer = true;
-                                    break;
-                                }
-                            }
-
-                            //
-                            // If the server is unknown, add it to the list
-                            //
-                            if (!foundServer) {
-                                //
-                                // Create the host object
-                                //
-                                HostPtr host = HostPtr(new Smb4KHost());
-
-                                //
-                                // Set the workgroup/domain name
-                                //
-                                host->setWorkgroupName(workgroupName);
-
-                                //
-                                // Set the host name
-                                //
-                                host->setHostName(hostName);
-
-                                //
-                                // Lookup IP address
-                                //
-                                QHostAddress address = lookupIpAddress(hostName);
-
-                                //
-                                // Process the IP address.
-                                //
-                                if (!address.isNull()) {
-                                    host->setIpAddress(address);
-                                }
-
-                                //
-                                // Add the host
-                                //
-                                *pHosts << host;
-                            }
-                        }
-
-                        break;
-                    }
-                    default: {
-                        break;
-                    }
-                    }
-                }
-            }
-        }
+        queueRequests(service);
     }
 
     //
@@ -1917,6 +1809,375 @@ void Smb4KWsDiscoveryJob::slotResolveMatchReceived(const WSDiscoveryTargetServic
 
 void Smb4KWsDiscoveryJob::slotDiscoveryFinished()
 {
-    emitResult();
+    //
+    // No more devices answered. Finish the job as soon as all
+    // requests settled.
+    //
+    m_timedOut = true;
+    finishWhenSettled();
+}
+
+void Smb4KWsDiscoveryJob::slotRequestFinished(KDSoapPendingCallWatcher *watcher)
+{
+    //
+    // Failed requests and requests that timed out return a fault
+    //
+    KDSoapMessage response = watcher->returnMessage();
+    Request request = m_runningRequests.take(watcher);
+
+    if (!response.isFault()) {
+        KDSoapValueList childValues = response.childValues();
+        QStringList computers;
+
+        for (const KDSoapValue &value : std::as_const(childValues)) {
+            computers << value.childValues()
+                             .child(QStringLiteral("Relationship"))
+                             .childValues()
+                             .child(QStringLiteral("Host"))
+                             .childValues()
+                             .child(QStringLiteral("Computer"))
+                             .value()
+                             .toString();
+        }
+
+        for (const QString &entry : std::as_const(computers)) {
+            processEntry(entry);
+        }
+
+        //
+        // Remember the metadata, so that the device does not have to be
+        // asked again until it announces a new metadata version
+        //
+        Smb4KWsDiscoveryCache::self()->insert(request.endpointReference, request.metadataVersion, computers, request.addresses);
+    }
+
+    delete request.clientInterface;
+    watcher->deleteLater();
+
+    //
+    // Continue with the queued requests
+    //
+    startRequests();
+    finishWhenSettled();
+}
+
+void Smb4KWsDiscoveryJob::queueRequests(const WSDiscoveryTargetService &service)
+{
+    //
+    // Use the cached metadata, if the device did not change
+    //
+    QStringList computers;
+
+    if (Smb4KWsDiscoveryCache::self()->find(service.endpointReference(), service.metadataVersion(), &computers)) {
+        for (const QString &entry : std::as_const(computers)) {
+            processEntry(entry);
+        }
+
+        return;
+    }
+
+    for (const QUrl &address : service.xAddrList()) {
+        //
+        // Do not ask a device twice, if it answered the probe and the resolve
+        //
+        QString key = address.toString() + service.endpointReference();
+
+        if (m_requestedAddresses.contains(key)) {
+            continue;
+        }
+
+        m_requestedAddresses.insert(key);
+
+        Request request;
+        request.address = address;
+        request.endpointReference = service.endpointReference();
+        request.metadataVersion = service.metadataVersion();
+        request.addresses = service.xAddrList();
+        request.clientInterface = nullptr;
+
+        m_queuedRequests << request;
+    }
+
+    startRequests();
+}
+
+void Smb4KWsDiscoveryJob::startRequests()
+{
+    //
+    // Limit the number of requests that are in flight, so that slow or
+    // unreachable devices do not use up all connections.
+    //
+    while (!m_queuedRequests.isEmpty() && m_runningRequests.size() < Smb4KSettings::maximumParallelLookups()) {
+        Request request = m_queuedRequests.takeFirst();
+
+        //
+        // Another address of the device might have answered in the meantime
+        //
+        QStringList computers;
+
+        if (Smb4KWsDiscoveryCache::self()->find(request.endpointReference, request.metadataVersion, &computers)) {
+            continue;
+        }
+
+        request.clientInterface = new KDSoapClientInterface(request.address.toString(), QStringLiteral("http://schemas.xmlsoap.org/ws/2004/09/transfer"));
+        request.clientInterface->setSoapVersion(KDSoapClientInterface::SoapVersion::SOAP1_2);
+        request.clientInterface->setTimeout(5000);
+
+        KDSoapMessage soapMessage;
+        KDSoapMessageAddressingProperties soapMessageProperties;
+        soapMessageProperties.setAddressingNamespace(KDSoapMessageAddressingProperties::Addressing200408);
+        soapMessageProperties.setAction(QStringLiteral("http://schemas.xmlsoap.org/ws/2004/09/transfer/Get"));
+        soapMessageProperties.setMessageID(QStringLiteral("urn:uuid:") + QUuid::createUuid().toString(QUuid::WithoutBraces));
+        soapMessageProperties.setDestination(request.endpointReference);
+        soapMessageProperties.setReplyEndpointAddress(
+            KDSoapMessageAddressingProperties::predefinedAddressToString(KDSoapMessageAddressingProperties::Anonymous,
+                                                                         KDSoapMessageAddressingProperties::Addressing200408));
+        soapMessageProperties.setSourceEndpointAddress(QStringLiteral("urn:uuid:") + QUuid::createUuid().toString(QUuid::WithoutBraces));
+        soapMessage.setMessageAddressingProperties(soapMessageProperties);
+
+        KDSoapPendingCallWatcher *watcher = new KDSoapPendingCallWatcher(request.clientInterface->asyncCall(QString(), soapMessage), this);
+        connect(watcher, &KDSoapPendingCallWatcher::finished, this, &Smb4KWsDiscoveryJob::slotRequestFinished);
+
+        m_runningRequests.insert(watcher, request);
+    }
+}
+
+void Smb4KWsDiscoveryJob::processEntry(const QString &entry)
+{
+    switch (*pProcess) {
+    case LookupDomains: {
+        //
+        // Get the name of the workgroup or domain
+        //
+        QString workgroupName = entry.section(QStringLiteral(":"), 1, -1);
+
+        //
+        // Work around an empty workgroup/domain name. Use the "LOCAL" domain from
+        // DNS-SD for that.
+        //
+        if (workgroupName.isEmpty()) {
+            workgroupName = QStringLiteral("LOCAL");
+        }
+
+        //
+        // Process the workgroup name. Only add a new workgroup, if it
+        // is not present already.
+        //
+        bool foundWorkgroup = false;
+
+        for (const Smb4KWorkgroupRecord &w : std::as_const(*pWorkgroups)) {
+            if (QString::compare(w.workgroupName, workgroupName, Qt::CaseInsensitive) == 0) {
+                foundWorkgroup = true;
+                break;
+            }
+        }
+
+        //
+        // If the workgroup is unknown, add it to the list
+        //
+        if (!foundWorkgroup) {
+            //
+            // Record the workgroup/domain
+            //
+            Smb4KWorkgroupRecord workgroup;
+            workgroup.workgroupName = workgroupName;
+
+            *pWorkgroups << workgroup;
+        }
+
+        break;
+    }
+    case LookupDomainMembers: {
+        //
+        // Get the workgroup name
+        //
+        QString workgroupName = entry.section(QStringLiteral(":"), 1, -1);
+
+        //
+        // Work around an empty workgroup/domain name. Use the "LOCAL" domain from
+        // DNS-SD for that.
+        //
+        if (workgroupName.isEmpty()) {
+            workgroupName = QStringLiteral("LOCAL");
+        }
+
+        //
+        // Get the host name. Unfortunately, the delimiter depends on
+        // whether the host is member of a workgroup (/) or domain (\).
+        //
+        QString hostName;
+
+        if (entry.contains(QStringLiteral("/"))) {
+            hostName = entry.section(QStringLiteral("/"), 0, 0);
+        } else if (entry.contains(QStringLiteral("\\"))) {
+            hostName = entry.section(QStringLiteral("\\"), 0, 0);
+        }
+
+        //
+        // Process the host name. Only add a new host, if it
+        // is not present already.
+        //
+        if (!hostName.isEmpty()) {
+            //
+            // Check if the server is already known
+            //
+            bool foundServer = false;
+
+            for (const Smb4KHostRecord &h : std::as_const(*pHosts)) {
+                if (QString::compare(h.hostName, hostName, Qt::CaseInsensitive) == 0
+                    && QString::compare(h.workgroupName, workgroupName, Qt::CaseInsensitive) == 0) {
+                    foundServer = true;
+                    break;
+                }
+            }
+
+            //
+            // If the server is unknown, add it to the list
+            //
+            if (!foundServer) {
+                //
+                // Record the host. The IP address is looked up when the
+                // discovery finished.
+                //
+                Smb4KHostRecord host;
+                host.workgroupName = workgroupName;
+                host.hostName = hostName;
+
+                *pHosts << host;
+            }
+        }
+
+        break;
+    }
+    default: {
+        break;
+    }
+    }
+}
+
+void Smb4KWsDiscoveryJob::finishWhenSettled()
+{
+    if (m_timedOut && !m_timer->isActive() && m_queuedRequests.isEmpty() && m_runningRequests.isEmpty()) {
+        m_timedOut = false;
+        emitResultWhenResolved();
+    }
+}
+
+//
+// WS-Discovery cache
+//
+Smb4KWsDiscoveryCache::Smb4KWsDiscoveryCache()
+    : m_loaded(false)
+    , m_modified(false)
+{
+}
+
+Smb4KWsDiscoveryCache::~Smb4KWsDiscoveryCache()
+{
+}
+
+Smb4KWsDiscoveryCache *Smb4KWsDiscoveryCache::self()
+{
+    return wsDiscoveryCache;
+}
+
+bool Smb4KWsDiscoveryCache::find(const QString &endpointReference, uint metadataVersion, QStringList *computers)
+{
+    if (!m_loaded) {
+        load();
+    }
+
+    auto it = m_entries.constFind(endpointReference);
+
+    if (it == m_entries.constEnd() || it->metadataVersion != metadataVersion
+        || it->fetched.secsTo(QDateTime::currentDateTimeUtc()) > WSD_CACHE_TIMEOUT) {
+        return false;
+    }
+
+    *computers = it->computers;
+
+    return true;
+}
+
+void Smb4KWsDiscoveryCache::insert(const QString &endpointReference, uint metadataVersion, const QStringList &computers, const QList<QUrl> &addresses)
+{
+    if (!m_loaded) {
+        load();
+    }
+
+    Entry entry;
+    entry.metadataVersion = metadataVersion;
+    entry.computers = computers;
+    entry.addresses = addresses;
+    entry.fetched = QDateTime::currentDateTimeUtc();
+
+    m_entries.insert(endpointReference, entry);
+    m_modified = true;
+}
+
+void Smb4KWsDiscoveryCache::load()
+{
+    m_loaded = true;
+
+    QFile cacheFile(dataLocation() + QDir::separator() + QStringLiteral("wsdiscovery_cache"));
+
+    if (!cacheFile.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0, version = 0, count = 0;
+    stream >> magic >> version;
+
+    if (magic != WSD_CACHE_MAGIC || version != WSD_CACHE_VERSION) {
+        return;
+    }
+
+    stream >> count;
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString endpointReference;
+        Entry entry;
+
+        stream >> endpointReference >> entry.metadataVersion >> entry.computers >> entry.addresses >> entry.fetched;
+
+        //
+        // Do not load expired entries
+        //
+        if (stream.status() == QDataStream::Ok && entry.fetched.secsTo(QDateTime::currentDateTimeUtc()) <= WSD_CACHE_TIMEOUT) {
+            m_entries.insert(endpointReference, entry);
+        }
+    }
+
+    cacheFile.close();
+}
+
+void Smb4KWsDiscoveryCache::save()
+{
+    if (!m_modified) {
+        return;
+    }
+
+    QFile cacheFile(dataLocation() + QDir::separator() + QStringLiteral("wsdiscovery_cache"));
+
+    if (!cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        Smb4KNotification::openingFileFailed(cacheFile);
+        return;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    stream << quint32(WSD_CACHE_MAGIC) << quint32(WSD_CACHE_VERSION) << quint32(m_entries.size());
+
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        stream << it.key() << it->metadataVersion << it->computers << it->addresses << it->fetched;
+    }
+
+    cacheFile.close();
+
+    m_modified = false;
 }
 #endif
@@ -1,7 +1,7 @@
 /*
     Private classes for the SMB client
 
-    SPDX-FileCopyrightText: 2018-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2018-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -20,19 +20,114 @@
 #include <libsmbclient.h>
 
 // Qt includes
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QHash>
 #include <QHostAddress>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QSet>
 #include <QTimer>
 #include <QUrl>
 
+// System includes
+#include <atomic>
+
 // KDE includes
 #include <KDNSSD/RemoteService>
 #include <KDNSSD/ServiceBrowser>
 #include <KJob>
 
 #ifdef USE_WS_DISCOVERY
+#include <KDSoapClient/KDSoapClientInterface>
+#include <KDSoapClient/KDSoapMessage>
+#include <KDSoapClient/KDSoapPendingCallWatcher>
 #include <WSDiscoveryClient>
 #endif
 
+/**
+ * Plain records of the workgroups, hosts and shares found while browsing.
+ * They are reconciled in place with the global lists, so that network items
+ * only need to be created for entries that are not known yet.
+ */
+struct Smb4KWorkgroupRecord {
+    QString workgroupName;
+    QString masterBrowserName;
+    QHostAddress masterBrowserIpAddress;
+    bool dnsDiscovered = false;
+};
+
+struct Smb4KHostRecord {
+    QString workgroupName;
+    QString hostName;
+    QString comment;
+    QHostAddress ipAddress;
+    bool dnsDiscovered = false;
+};
+
+struct Smb4KShareRecord {
+    QUrl url;
+    QString workgroupName;
+    QString comment;
+    Smb4KGlobal::ShareType shareType = Smb4KGlobal::FileShare;
+    QHostAddress hostIpAddress;
+};
+
+struct Smb4KFileRecord {
+    QUrl url;
+    bool directory = false;
+    qint64 size = 0;
+    QDateTime lastModified;
+    QDateTime lastAccessed;
+    quint16 attributes = 0;
+};
+
+class Smb4KClientJob;
+
+/**
+ * The state of a lookup that runs in the thread pool. It is shared by the
+ * job and the worker, so that the job can be destroyed while the worker is
+ * still blocked inside libsmbclient. The worker only uses this object.
+ */
+class Smb4KClientLookup
+{
+public:
+    /**
+     * Constructor
+     */
+    Smb4KClientLookup();
+
+    /**
+     * Destructor
+     */
+    ~Smb4KClientLookup();
+
+    SMBCCTX *context;
+    bool ownsContext;
+    Smb4KGlobal::NetworkItem networkItemType;
+    QUrl url;
+    QString workgroupName;
+    bool dnsDiscovered;
+    QString userName;
+    QString password;
+    QHostAddress hostAddress;
+    std::atomic<bool> abort;
+    int error;
+    QString errorText;
+    QList<Smb4KWorkgroupRecord> workgroups;
+    QList<Smb4KHostRecord> hosts;
+    QList<Smb4KShareRecord> shares;
+    QSemaphore pendingBatches;
+
+    /**
+     * The job that receives the results. It is reset by the job when it is
+     * destroyed. Only access it while the mutex is locked.
+     */
+    QMutex jobMutex;
+    Smb4KClientJob *job;
+};
+
 class Smb4KClientBaseJob : public KJob
 {
     Q_OBJECT
@@ -71,22 +166,17 @@ public:
     /**
      * The list of workgroups that was discovered.
      */
-    QList<WorkgroupPtr> workgroups();
+    QList<Smb4KWorkgroupRecord> workgroups();
 
     /**
      * The list of hosts that was discovered.
      */
-    QList<HostPtr> hosts();
+    QList<Smb4KHostRecord> hosts();
 
     /**
      * The list shares that was discovered.
      */
-    QList<SharePtr> shares();
-
-    /**
-     * The ist of files and directories that were discovered.
-     */
-    QList<FilePtr> files();
+    QList<Smb4KShareRecord> shares();
 
     /**
      * Error enumeration
@@ -106,19 +196,26 @@ public:
 protected:
     Smb4KGlobal::Process *pProcess;
     NetworkItemPtr *pNetworkItem;
-    QList<WorkgroupPtr> *pWorkgroups;
-    QList<HostPtr> *pHosts;
-    QList<SharePtr> *pShares;
-    QList<FilePtr> *pFiles;
-    QHostAddress lookupIpAddress(const QString &name);
+    QList<Smb4KWorkgroupRecord> *pWorkgroups;
+    QList<Smb4KHostRecord> *pHosts;
+    QList<Smb4KShareRecord> *pShares;
+
+    /**
+     * Look up the IP addresses of the discovered hosts, that do not have
+     * one yet, and emit the result when all lookups finished.
+     */
+    void emitResultWhenResolved();
+
+protected Q_SLOTS:
+    void slotAddressResolved(const QString &name, const QHostAddress &address);
 
 private:
     Smb4KGlobal::Process m_process;
     NetworkItemPtr m_networkItem;
-    QList<WorkgroupPtr> m_workgroups;
-    QList<HostPtr> m_hosts;
-    QList<SharePtr> m_shares;
-    QList<FilePtr> m_files;
+    QList<Smb4KWorkgroupRecord> m_workgroups;
+    QList<Smb4KHostRecord> m_hosts;
+    QList<Smb4KShareRecord> m_shares;
+    QStringList m_pendingLookups;
 };
 
 class Smb4KClientJob : public Smb4KClientBaseJob
@@ -161,29 +258,41 @@ public:
      */
     int printCopies() const;
 
+Q_SIGNALS:
     /**
-     * The authentication function for libsmbclient
+     * This signal is emitted while the contents of a share or directory are
+     * read. The files and directories are passed in portions, so that the
+     * receiver can show them before the whole listing was transferred.
+     *
+     * @param files         The files and directories of this portion
      */
-    void get_auth_data_fn(const char *server,
-                          const char *share,
-                          char *workgroup,
-                          int maxLenWorkgroup,
-                          char *username,
-                          int maxLenUsername,
-                          char *password,
-                          int maxLenPassword);
+    void filesReceived(const QList<FilePtr> &files);
+
+protected:
+    /**
+     * Reimplemented from KJob. Tells a running lookup to stop
+     * after the current directory entry.
+     */
+    bool doKill() override;
 
 protected Q_SLOTS:
     void slotStartJob();
     void slotFinishJob();
+    void slotLookupsFinished();
+    void slotEmitFiles(const QList<Smb4KFileRecord> &files);
 
 private:
     void initClientLibrary();
-    void doLookups();
+    void readLoginCredentials();
+    static void doLookups(Smb4KClientLookup *lookup);
+    static void sendFiles(Smb4KClientLookup *lookup, const QList<Smb4KFileRecord> &files);
     void doPrinting();
     SMBCCTX *m_context;
+    QString m_contextKey;
     KFileItem m_fileItem;
     int m_copies;
+    bool m_lookupRunning;
+    QSharedPointer<Smb4KClientLookup> m_lookup;
 };
 
 class Smb4KDnsDiscoveryJob : public Smb4KClientBaseJob
@@ -241,13 +350,149 @@ protected Q_SLOTS:
     void slotProbeMatchReceived(const WSDiscoveryTargetService &service);
     void slotResolveMatchReceived(const WSDiscoveryTargetService &service);
     void slotDiscoveryFinished();
+    void slotRequestFinished(KDSoapPendingCallWatcher *watcher);
 
 private:
+    struct Request {
+        QUrl address;
+        QString endpointReference;
+        uint metadataVersion;
+        QList<QUrl> addresses;
+        KDSoapClientInterface *clientInterface;
+    };
+    void queueRequests(const WSDiscoveryTargetService &service);
+    void startRequests();
+    void processEntry(const QString &entry);
+    void finishWhenSettled();
     WSDiscoveryClient *m_discoveryClient;
     QTimer *m_timer;
+    bool m_timedOut;
+    QList<Request> m_queuedRequests;
+    QSet<QString> m_requestedAddresses;
+    QHash<KDSoapPendingCallWatcher *, Request> m_runningRequests;
+};
+
+class Smb4KWsDiscoveryCache
+{
+public:
+    /**
+     * Constructor
+     */
+    Smb4KWsDiscoveryCache();
+
+    /**
+     * Destructor
+     */
+    ~Smb4KWsDiscoveryCache();
+
+    /**
+     * The static pointer to this class
+     */
+    static Smb4KWsDiscoveryCache *self();
+
+    /**
+     * Find the computer entries of the device @p endpointReference. The
+     * entry is only used, if the device still announces @p metadataVersion
+     * and the entry did not expire yet.
+     *
+     * @returns TRUE if a valid entry was found.
+     */
+    bool find(const QString &endpointReference, uint metadataVersion, QStringList *computers);
+
+    /**
+     * Insert or replace the computer entries of the device @p endpointReference.
+     */
+    void insert(const QString &endpointReference, uint metadataVersion, const QStringList &computers, const QList<QUrl> &addresses);
+
+    /**
+     * Save the cache to disk
+     */
+    void save();
+
+private:
+    void load();
+    struct Entry {
+        uint metadataVersion;
+        QStringList computers;
+        QList<QUrl> addresses;
+        QDateTime fetched;
+    };
+    QHash<QString, Entry> m_entries;
+    bool m_loaded;
+    bool m_modified;
 };
 #endif
 
+class Smb4KClientContextPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Constructor
+     */
+    explicit Smb4KClientContextPool(QObject *parent = nullptr);
+
+    /**
+     * Destructor
+     */
+    ~Smb4KClientContextPool();
+
+    /**
+     * The static pointer to this class
+     */
+    static Smb4KClientContextPool *self();
+
+    /**
+     * Take an idle context from the pool, that was set up with the
+     * settings described by @p key.
+     *
+     * @returns the context or nullptr, if there is none.
+     */
+    SMBCCTX *acquire(const QString &key);
+
+    /**
+     * Return a context to the pool. If @p reusable is FALSE, the context
+     * is freed immediately.
+     */
+    void release(const QString &key, SMBCCTX *context, bool reusable);
+
+    /**
+     * Free all idle contexts
+     */
+    void clear();
+
+protected Q_SLOTS:
+    /**
+     * Free all idle contexts, because their connections were authenticated
+     * with outdated credentials.
+     */
+    void slotCredentialsUpdated();
+
+    /**
+     * Free all idle contexts and stop pooling the contexts of the jobs
+     * that are still finishing.
+     */
+    void slotAboutToQuit();
+
+protected:
+    /**
+     * Reimplemented from QObject to free contexts that were idle
+     * for too long.
+     */
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    struct IdleContext {
+        QString key;
+        SMBCCTX *context;
+        QDeadlineTimer expiry;
+    };
+    QList<IdleContext> m_idleContexts;
+    int m_timerId;
+    bool m_shutDown;
+};
+
 class Smb4KClientPrivate
 {
 public:
@@ -257,9 +502,19 @@ public:
         KFileItem printFileItem;
         int printCopies;
     };
-    QList<WorkgroupPtr> tempWorkgroupList;
-    QList<HostPtr> tempHostList;
+    QList<Smb4KWorkgroupRecord> tempWorkgroupList;
+    QMap<QString, QList<Smb4KHostRecord>> tempHostLists;
     QList<QueueContainer> queue;
+    bool searchRunning;
+    QString searchItem;
+    NetworkItemPtr searchNetworkItem;
+    QList<HostPtr> searchQueue;
+    QSet<HostPtr> queuedSearchHosts;
+    QSet<HostPtr> searchHosts;
+    bool browseCacheLoaded;
+    QHash<QString, QDateTime> browseCacheTimestamps;
+    NetworkItemPtr wakeUpItem;
+    QSet<QString> wakeUpKeys;
 };
 
 class Smb4KClientStatic
@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a directory or file.
 
-    SPDX-FileCopyrightText: 2018-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2018-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -15,7 +15,10 @@
 
 // KDE includes
 #include <KIO/Global>
-#include <KIconLoader>
+
+#define DOS_ATTRIBUTE_READONLY 0x01
+#define DOS_ATTRIBUTE_HIDDEN 0x02
+#define DOS_ATTRIBUTE_SYSTEM 0x04
 
 using namespace Smb4KGlobal;
 
@@ -24,7 +27,11 @@ class Smb4KFilePrivate
 public:
     QString workgroupName;
     QHostAddress ip;
-    bool isDirectory;
+    QDateTime lastModified;
+    QDateTime lastAccessed;
+    qint64 size;
+    quint16 attributes;
+    bool isDirectory : 1;
 };
 
 Smb4KFile::Smb4KFile(const QUrl &url)
@@ -32,8 +39,9 @@ Smb4KFile::Smb4KFile(const QUrl &url)
     , d(new Smb4KFilePrivate)
 {
     *pUrl = url;
-    *pIcon = KDE::icon(KIO::iconNameForUrl(url));
     d->isDirectory = false;
+    d->size = 0;
+    d->attributes = 0;
 }
 
 Smb4KFile::Smb4KFile(const Smb4KFile &file)
@@ -48,15 +56,28 @@ Smb4KFile::Smb4KFile()
     , d(new Smb4KFilePrivate)
 {
     d->isDirectory = false;
+    d->size = 0;
+    d->attributes = 0;
 }
 
 Smb4KFile::~Smb4KFile()
 {
 }
 
+QIcon Smb4KFile::icon() const
+{
+    QIcon icon = Smb4KBasicNetworkItem::icon();
+
+    if (!icon.isNull()) {
+        return icon;
+    }
+
+    return cachedIcon(d->isDirectory ? QStringLiteral("folder") : KIO::iconNameForUrl(*pUrl));
+}
+
 void Smb4KFile::setWorkgroupName(const QString &name) const
 {
-    d->workgroupName = name;
+    d->workgroupName = internedString(name);
 }
 
 QString Smb4KFile::workgroupName() const
@@ -114,7 +135,6 @@ QString Smb4KFile::password() const
 void Smb4KFile::setDirectory(bool directory) const
 {
     d->isDirectory = directory;
-    *pIcon = KDE::icon(QStringLiteral("folder"));
 }
 
 bool Smb4KFile::isDirectory() const
@@ -137,7 +157,57 @@ QString Smb4KFile::name() const
 
 bool Smb4KFile::isHidden() const
 {
-    return name().startsWith(QStringLiteral("."));
+    return (d->attributes & DOS_ATTRIBUTE_HIDDEN) || name().startsWith(QStringLiteral("."));
+}
+
+void Smb4KFile::setSize(qint64 size) const
+{
+    d->size = size;
+}
+
+qint64 Smb4KFile::size() const
+{
+    return d->size;
+}
+
+void Smb4KFile::setLastModified(const QDateTime &dateTime) const
+{
+    d->lastModified = dateTime;
+}
+
+QDateTime Smb4KFile::lastModified() const
+{
+    return d->lastModified;
+}
+
+void Smb4KFile::setLastAccessed(const QDateTime &dateTime) const
+{
+    d->lastAccessed = dateTime;
+}
+
+QDateTime Smb4KFile::lastAccessed() const
+{
+    return d->lastAccessed;
+}
+
+void Smb4KFile::setAttributes(quint16 attributes) const
+{
+    d->attributes = attributes;
+}
+
+quint16 Smb4KFile::attributes() const
+{
+    return d->attributes;
+}
+
+bool Smb4KFile::isSystem() const
+{
+    return (d->attributes & DOS_ATTRIBUTE_SYSTEM);
+}
+
+bool Smb4KFile::isReadOnly() const
+{
+    return (d->attributes & DOS_ATTRIBUTE_READONLY);
 }
 
 Smb4KFile &Smb4KFile::operator=(const Smb4KFile &other)
@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a directory or file.
 
-    SPDX-FileCopyrightText: 2018-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2018-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -13,6 +13,7 @@
 #include "smb4kcore_export.h"
 
 // Qt includes
+#include <QDateTime>
 #include <QHostAddress>
 #include <QScopedPointer>
 
@@ -45,6 +46,14 @@ public:
      */
     ~Smb4KFile();
 
+    /**
+     * Returns the icon of the file or directory. It is derived from the
+     * URL each time it is requested.
+     *
+     * @returns the icon
+     */
+    QIcon icon() const override;
+
     /**
      * Sets the workgroup name to @p name.
      *
@@ -145,11 +154,86 @@ public:
 
     /**
      * Returns TRUE if the file or directory is hidden and FALSE otherwise.
+     * A file or directory is hidden if its name starts with a dot or if the
+     * hidden attribute is set.
      *
      * @returns TRUE is the file or directory id hidden
      */
     bool isHidden() const;
 
+    /**
+     * Set the size of the file to @p size.
+     *
+     * @param size          The size in bytes
+     */
+    void setSize(qint64 size) const;
+
+    /**
+     * Returns the size of the file in bytes.
+     *
+     * @returns the size
+     */
+    qint64 size() const;
+
+    /**
+     * Set the time the file or directory was last modified to @p dateTime.
+     *
+     * @param dateTime      The modification time
+     */
+    void setLastModified(const QDateTime &dateTime) const;
+
+    /**
+     * Returns the time the file or directory was last modified. If it
+     * is not known, an invalid date and time is returned.
+     *
+     * @returns the modification time
+     */
+    QDateTime lastModified() const;
+
+    /**
+     * Set the time the file or directory was last accessed to @p dateTime.
+     *
+     * @param dateTime      The access time
+     */
+    void setLastAccessed(const QDateTime &dateTime) const;
+
+    /**
+     * Returns the time the file or directory was last accessed. If it
+     * is not known, an invalid date and time is returned.
+     *
+     * @returns the access time
+     */
+    QDateTime lastAccessed() const;
+
+    /**
+     * Set the DOS attributes of the file or directory as reported by
+     * the server to @p attributes.
+     *
+     * @param attributes    The DOS attributes
+     */
+    void setAttributes(quint16 attributes) const;
+
+    /**
+     * Returns the DOS attributes of the file or directory.
+     *
+     * @returns the DOS attributes
+     */
+    quint16 attributes() const;
+
+    /**
+     * Returns TRUE if the system attribute is set and FALSE otherwise.
+     *
+     * @returns TRUE if this is a system file or directory
+     */
+    bool isSystem() const;
+
+    /**
+     * Returns TRUE if the read-only attribute is set and FALSE otherwise.
+     *
+     * @returns TRUE if the file or directory is read-only
+     */
+    bool isReadOnly() const;
+
     /**
      * Copy assignment operator
      */
@@ -7,6 +7,7 @@
 
 // application specific includes
 #include "smb4kglobal.h"
+#include "smb4kchangenotifier.h"
 #include "smb4kclient.h"
 #include "smb4kglobal_p.h"
 #include "smb4kglobalenums.h"
@@ -18,7 +19,6 @@
 #include <QDebug>
 #include <QDirIterator>
 #include <QEventLoop>
-#include <QRecursiveMutex>
 #include <QStandardPaths>
 #include <QTimer>
 #include <QUrl>
@@ -28,29 +28,276 @@
 #include <KIO/OpenUrlJob>
 
 Q_GLOBAL_STATIC(Smb4KGlobalPrivate, p);
-QRecursiveMutex mutex;
 
-const QList<WorkgroupPtr> &Smb4KGlobal::workgroupsList()
+//
+// Lookups in the indexes of the lists
+//
+static WorkgroupPtr lookupWorkgroup(const QString &name)
 {
-    return p->workgroupsList;
+    return p->workgroupsIndex.value(Smb4KGlobalPrivate::workgroupKey(name));
 }
 
-WorkgroupPtr Smb4KGlobal::findWorkgroup(const QString &name)
+static HostPtr lookupHost(const QString &name, const QString &workgroup)
 {
-    WorkgroupPtr workgroup;
+    auto range = p->hostsIndex.equal_range(Smb4KGlobalPrivate::hostKey(name));
 
-    mutex.lock();
+    for (auto it = range.first; it != range.second; ++it) {
+        if (workgroup.isEmpty() || QString::compare((*it)->workgroupName(), workgroup, Qt::CaseInsensitive) == 0) {
+            return *it;
+        }
+    }
 
-    for (const WorkgroupPtr &w : std::as_const(p->workgroupsList)) {
-        if (QString::compare(w->workgroupName(), name, Qt::CaseInsensitive) == 0) {
-            workgroup = w;
-            break;
+    return HostPtr();
+}
+
+static SharePtr lookupShare(const QString &key, const QString &workgroup)
+{
+    auto range = p->sharesIndex.equal_range(key);
+
+    for (auto it = range.first; it != range.second; ++it) {
+        if (workgroup.isEmpty() || QString::compare((*it)->workgroupName(), workgroup, Qt::CaseInsensitive) == 0) {
+            return *it;
+        }
+    }
+
+    return SharePtr();
+}
+
+//
+// Append an item to a list and take it from the list. The position of each
+// item is recorded, so that it can be removed without searching the list.
+// The last item of the list takes the place of the removed one.
+//
+template<class T>
+static void appendItem(QList<QSharedPointer<T>> &list, QHash<T *, qsizetype> &positions, const QSharedPointer<T> &item)
+{
+    positions.insert(item.data(), list.size());
+    list.append(item);
+}
+
+template<class T>
+static bool takeItem(QList<QSharedPointer<T>> &list, QHash<T *, qsizetype> &positions, const QSharedPointer<T> &item)
+{
+    auto it = positions.find(item.data());
+
+    if (it == positions.end()) {
+        return false;
+    }
+
+    qsizetype index = it.value();
+    qsizetype last = list.size() - 1;
+    positions.erase(it);
+
+    if (index != last) {
+        list[index] = list.at(last);
+        positions[list.at(index).data()] = index;
+    }
+
+    list.removeLast();
+
+    return true;
+}
+
+//
+// Add the host or share to the indexes and remove it from them
+//
+static void indexHost(const HostPtr &host)
+{
+    p->hostsIndex.insert(Smb4KGlobalPrivate::hostKey(host->hostName()), host);
+    p->workgroupMembersIndex[Smb4KGlobalPrivate::workgroupKey(host->workgroupName())].append(host);
+}
+
+static void unindexHost(const HostPtr &host)
+{
+    p->hostsIndex.remove(Smb4KGlobalPrivate::hostKey(host->hostName()), host);
+
+    auto it = p->workgroupMembersIndex.find(Smb4KGlobalPrivate::workgroupKey(host->workgroupName()));
+
+    if (it != p->workgroupMembersIndex.end()) {
+        it->removeOne(host);
+
+        if (it->isEmpty()) {
+            p->workgroupMembersIndex.erase(it);
+        }
+    }
+}
+
+static void indexShare(const SharePtr &share)
+{
+    p->sharesIndex.insert(share->key(), share);
+    p->sharedResourcesIndex[Smb4KGlobalPrivate::memberKey(share->workgroupName(), share->hostName())].append(share);
+}
+
+static void unindexShare(const SharePtr &share)
+{
+    p->sharesIndex.remove(share->key(), share);
+
+    auto it = p->sharedResourcesIndex.find(Smb4KGlobalPrivate::memberKey(share->workgroupName(), share->hostName()));
+
+    if (it != p->sharedResourcesIndex.end()) {
+        it->removeOne(share);
+
+        if (it->isEmpty()) {
+            p->sharedResourcesIndex.erase(it);
+        }
+    }
+}
+
+static void indexMountedShare(const SharePtr &share)
+{
+    p->mountedSharesUrlIndex.insert(share->key(), share);
+
+    QStringList &pathKeys = p->mountedSharesPathKeys[share.data()];
+
+    if (!share->path().isEmpty()) {
+        pathKeys << share->path().toCaseFolded();
+    }
+
+    if (share->hasCanonicalPath()) {
+        pathKeys << share->canonicalPath().toCaseFolded();
+    }
+
+    for (const QString &key : std::as_const(pathKeys)) {
+        p->mountedSharesPathIndex.insert(key, share);
+    }
+}
+
+static void unindexMountedShare(const SharePtr &share)
+{
+    p->mountedSharesUrlIndex.remove(share->key(), share);
+
+    //
+    // The share might have become inaccessible since it was indexed, so
+    // remove the entries with the keys it was indexed with instead of
+    // relying on canonicalPath().
+    //
+    const QStringList pathKeys = p->mountedSharesPathKeys.take(share.data());
+
+    for (const QString &key : pathKeys) {
+        auto it = p->mountedSharesPathIndex.find(key);
+
+        if (it != p->mountedSharesPathIndex.end() && it.value() == share) {
+            p->mountedSharesPathIndex.erase(it);
+        }
+    }
+}
+
+static SharePtr lookupMountedShare(const QString &path)
+{
+    SharePtr share;
+
+    if (!path.isEmpty()) {
+        share = p->mountedSharesPathIndex.value(path.toCaseFolded());
+    }
+
+    return share;
+}
+
+
+//
+// Copy the IP address and the workgroup name of the network host
+// to the mounted share, if necessary
+//
+static void completeMountedShare(const SharePtr &share)
+{
+    HostPtr networkHost = Smb4KGlobal::findHost(share->hostName(), share->workgroupName());
+
+    if (networkHost) {
+        // Set the IP address
+        if (!share->hasHostIpAddress() || networkHost->ipAddress() != share->hostIpAddress()) {
+            share->setHostIpAddress(networkHost->ipAddress());
+        }
+
+        // Set the workgroup name
+        if (share->workgroupName().isEmpty()) {
+            share->setWorkgroupName(networkHost->workgroupName());
         }
     }
+}
+
+//
+// Determine the properties that differ between two versions of
+// a network item
+//
+static int changedFields(const Smb4KBasicNetworkItem &before, const Smb4KBasicNetworkItem &after)
+{
+    int fields = Smb4KGlobal::NoField;
+
+    if (before.url() != after.url()) {
+        fields |= Smb4KGlobal::UrlField;
+    }
+
+    if (before.comment() != after.comment()) {
+        fields |= Smb4KGlobal::CommentField;
+    }
+
+    if (before.isStale() != after.isStale()) {
+        fields |= Smb4KGlobal::StaleField;
+    }
+
+    return fields;
+}
+
+static int changedFields(const Smb4KWorkgroup &before, const Smb4KWorkgroup &after)
+{
+    int fields = changedFields(static_cast<const Smb4KBasicNetworkItem &>(before), after);
+
+    if (before.masterBrowserName() != after.masterBrowserName() || before.masterBrowserIpAddress() != after.masterBrowserIpAddress()) {
+        fields |= Smb4KGlobal::MasterBrowserField;
+    }
+
+    return fields;
+}
+
+static int changedFields(const Smb4KHost &before, const Smb4KHost &after)
+{
+    int fields = changedFields(static_cast<const Smb4KBasicNetworkItem &>(before), after);
+
+    if (before.ipAddress() != after.ipAddress()) {
+        fields |= Smb4KGlobal::IpAddressField;
+    }
+
+    if (before.isMasterBrowser() != after.isMasterBrowser()) {
+        fields |= Smb4KGlobal::MasterBrowserField;
+    }
+
+    return fields;
+}
+
+static int changedMountData(const Smb4KShare &before, const Smb4KShare &after)
+{
+    if (before.isMounted() != after.isMounted() || before.path() != after.path() || before.isInaccessible() != after.isInaccessible()
+        || before.isForeign() != after.isForeign() || before.totalDiskSpace() != after.totalDiskSpace()
+        || before.freeDiskSpace() != after.freeDiskSpace()) {
+        return Smb4KGlobal::MountDataField;
+    }
+
+    return Smb4KGlobal::NoField;
+}
 
-    mutex.unlock();
+static int changedFields(const Smb4KShare &before, const Smb4KShare &after)
+{
+    int fields = changedFields(static_cast<const Smb4KBasicNetworkItem &>(before), after) | changedMountData(before, after);
+
+    if (before.hostIpAddress() != after.hostIpAddress()) {
+        fields |= Smb4KGlobal::IpAddressField;
+    }
+
+    if (before.shareType() != after.shareType()) {
+        fields |= Smb4KGlobal::ShareTypeField;
+    }
+
+    return fields;
+}
+
+QList<WorkgroupPtr> Smb4KGlobal::workgroupsList()
+{
+    return p->workgroupsList;
+}
 
-    return workgroup;
+WorkgroupPtr Smb4KGlobal::findWorkgroup(const QString &name)
+{
+    return lookupWorkgroup(name);
 }
 
 bool Smb4KGlobal::addWorkgroup(WorkgroupPtr workgroup)
@@ -60,14 +307,12 @@ bool Smb4KGlobal::addWorkgroup(WorkgroupPtr workgroup)
     bool added = false;
 
     if (workgroup) {
-        mutex.lock();
-
-        if (!findWorkgroup(workgroup->workgroupName())) {
-            p->workgroupsList.append(workgroup);
+        if (!lookupWorkgroup(workgroup->workgroupName())) {
+            appendItem(p->workgroupsList, p->workgroupsPositions, workgroup);
+            p->workgroupsIndex.insert(Smb4KGlobalPrivate::workgroupKey(workgroup->workgroupName()), workgroup);
+            Smb4KChangeNotifier::self()->postAdded(Smb4KChangeNotifier::NetworkNeighborhood, workgroup);
             added = true;
         }
-
-        mutex.unlock();
     }
 
     return added;
@@ -80,53 +325,58 @@ bool Smb4KGlobal::updateWorkgroup(WorkgroupPtr workgroup)
     bool updated = false;
 
     if (workgroup) {
-        mutex.lock();
-
-        WorkgroupPtr existingWorkgroup = findWorkgroup(workgroup->workgroupName());
+        WorkgroupPtr existingWorkgroup = lookupWorkgroup(workgroup->workgroupName());
 
         if (existingWorkgroup) {
+            Smb4KWorkgroup before(*existingWorkgroup);
             existingWorkgroup->update(workgroup.data());
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood,
+                                                     existingWorkgroup,
+                                                     changedFields(before, *existingWorkgroup));
             updated = true;
         }
-
-        mutex.unlock();
     }
 
     return updated;
 }
 
-bool Smb4KGlobal::removeWorkgroup(WorkgroupPtr workgroup)
+bool Smb4KGlobal::modifyWorkgroup(WorkgroupPtr workgroup, const std::function<int(Smb4KWorkgroup *)> &modify)
 {
     Q_ASSERT(workgroup);
 
-    bool removed = false;
+    bool modified = false;
 
     if (workgroup) {
-        mutex.lock();
+        WorkgroupPtr existingWorkgroup = lookupWorkgroup(workgroup->workgroupName());
 
-        int index = p->workgroupsList.indexOf(workgroup);
+        if (existingWorkgroup) {
+            int fields = modify(existingWorkgroup.data());
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood, existingWorkgroup, fields);
+            modified = true;
+        }
+    }
 
-        if (index != -1) {
-            // The workgroup was found. Remove it.
-            p->workgroupsList.takeAt(index).clear();
-            removed = true;
-        } else {
-            // Try harder to find the workgroup.
-            WorkgroupPtr wg = findWorkgroup(workgroup->workgroupName());
+    return modified;
+}
 
-            if (wg) {
-                index = p->workgroupsList.indexOf(wg);
+bool Smb4KGlobal::removeWorkgroup(WorkgroupPtr workgroup)
+{
+    Q_ASSERT(workgroup);
 
-                if (index != -1) {
-                    p->workgroupsList.takeAt(index).clear();
-                    removed = true;
-                }
-            }
+    bool removed = false;
 
-            workgroup.clear();
-        }
+    if (workgroup) {
+        //
+        // If the workgroup is not in the list, try harder to find it.
+        //
+        WorkgroupPtr existingWorkgroup =
+            p->workgroupsPositions.contains(workgroup.data()) ? workgroup : lookupWorkgroup(workgroup->workgroupName());
 
-        mutex.unlock();
+        if (existingWorkgroup && takeItem(p->workgroupsList, p->workgroupsPositions, existingWorkgroup)) {
+            p->workgroupsIndex.remove(Smb4KGlobalPrivate::workgroupKey(existingWorkgroup->workgroupName()));
+            Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, existingWorkgroup);
+            removed = true;
+        }
     }
 
     return removed;
@@ -134,37 +384,24 @@ bool Smb4KGlobal::removeWorkgroup(WorkgroupPtr workgroup)
 
 void Smb4KGlobal::clearWorkgroupsList()
 {
-    mutex.lock();
+    p->workgroupsIndex.clear();
 
-    while (!p->workgroupsList.isEmpty()) {
-        p->workgroupsList.takeFirst().clear();
+    for (const WorkgroupPtr &workgroup : std::as_const(p->workgroupsList)) {
+        Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, workgroup);
     }
 
-    mutex.unlock();
+    p->workgroupsList.clear();
+    p->workgroupsPositions.clear();
 }
 
-const QList<HostPtr> &Smb4KGlobal::hostsList()
+QList<HostPtr> Smb4KGlobal::hostsList()
 {
     return p->hostsList;
 }
 
 HostPtr Smb4KGlobal::findHost(const QString &name, const QString &workgroup)
 {
-    HostPtr host;
-
-    mutex.lock();
-
-    for (const HostPtr &h : std::as_const(p->hostsList)) {
-        if ((workgroup.isEmpty() || QString::compare(h->workgroupName(), workgroup, Qt::CaseInsensitive) == 0)
-            && QString::compare(h->hostName(), name, Qt::CaseInsensitive) == 0) {
-            host = h;
-            break;
-        }
-    }
-
-    mutex.unlock();
-
-    return host;
+    return lookupHost(name, workgroup);
 }
 
 bool Smb4KGlobal::addHost(HostPtr host)
@@ -174,14 +411,12 @@ bool Smb4KGlobal::addHost(HostPtr host)
     bool added = false;
 
     if (host) {
-        mutex.lock();
-
-        if (!findHost(host->hostName(), host->workgroupName())) {
-            p->hostsList.append(host);
+        if (!lookupHost(host->hostName(), host->workgroupName())) {
+            appendItem(p->hostsList, p->hostsPositions, host);
+            indexHost(host);
+            Smb4KChangeNotifier::self()->postAdded(Smb4KChangeNotifier::NetworkNeighborhood, host);
             added = true;
         }
-
-        mutex.unlock();
     }
 
     return added;
@@ -194,53 +429,55 @@ bool Smb4KGlobal::updateHost(HostPtr host)
     bool updated = false;
 
     if (host) {
-        mutex.lock();
-
-        HostPtr existingHost = findHost(host->hostName(), host->workgroupName());
+        HostPtr existingHost = lookupHost(host->hostName(), host->workgroupName());
 
         if (existingHost) {
+            Smb4KHost before(*existingHost);
             existingHost->update(host.data());
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood, existingHost, changedFields(before, *existingHost));
             updated = true;
         }
-
-        mutex.unlock();
     }
 
     return updated;
 }
 
-bool Smb4KGlobal::removeHost(HostPtr host)
+bool Smb4KGlobal::modifyHost(HostPtr host, const std::function<int(Smb4KHost *)> &modify)
 {
     Q_ASSERT(host);
 
-    bool removed = false;
+    bool modified = false;
 
     if (host) {
-        mutex.lock();
+        HostPtr existingHost = lookupHost(host->hostName(), host->workgroupName());
 
-        int index = p->hostsList.indexOf(host);
+        if (existingHost) {
+            int fields = modify(existingHost.data());
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood, existingHost, fields);
+            modified = true;
+        }
+    }
 
-        if (index != -1) {
-            // The host was found. Remove it.
-            p->hostsList.takeAt(index).clear();
-            removed = true;
-        } else {
-            // Try harder to find the host.
-            HostPtr h = findHost(host->hostName(), host->workgroupName());
+    return modified;
+}
 
-            if (h) {
-                index = p->hostsList.indexOf(h);
+bool Smb4KGlobal::removeHost(HostPtr host)
+{
+    Q_ASSERT(host);
 
-                if (index != -1) {
-                    p->hostsList.takeAt(index).clear();
-                    removed = true;
-                }
-            }
+    bool removed = false;
 
-            host.clear();
-        }
+    if (host) {
+        //
+        // If the host is not in the list, try harder to find it.
+        //
+        HostPtr existingHost = p->hostsPositions.contains(host.data()) ? host : lookupHost(host->hostName(), host->workgroupName());
 
-        mutex.unlock();
+        if (existingHost && takeItem(p->hostsList, p->hostsPositions, existingHost)) {
+            unindexHost(existingHost);
+            Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, existingHost);
+            removed = true;
+        }
     }
 
     return removed;
@@ -248,57 +485,83 @@ bool Smb4KGlobal::removeHost(HostPtr host)
 
 void Smb4KGlobal::clearHostsList()
 {
-    mutex.lock();
+    p->hostsIndex.clear();
+    p->workgroupMembersIndex.clear();
 
-    while (!p->hostsList.isEmpty()) {
-        p->hostsList.takeFirst().clear();
+    for (const HostPtr &host : std::as_const(p->hostsList)) {
+        Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, host);
     }
 
-    mutex.unlock();
+    p->hostsList.clear();
+    p->hostsPositions.clear();
 }
 
 QList<HostPtr> Smb4KGlobal::workgroupMembers(WorkgroupPtr workgroup)
 {
-    QList<HostPtr> hosts;
+    return p->workgroupMembersIndex.value(Smb4KGlobalPrivate::workgroupKey(workgroup->workgroupName()));
+}
 
-    mutex.lock();
+void Smb4KGlobal::removeWorkgroupMembers(WorkgroupPtr workgroup)
+{
+    Q_ASSERT(workgroup);
 
-    for (const HostPtr &h : std::as_const(p->hostsList)) {
-        if (QString::compare(h->workgroupName(), workgroup->workgroupName(), Qt::CaseInsensitive) == 0) {
-            hosts << h;
-        }
+    if (!workgroup) {
+        return;
+    }
+
+    //
+    // Remove the members from the host list
+    //
+    const QList<HostPtr> members = p->workgroupMembersIndex.take(Smb4KGlobalPrivate::workgroupKey(workgroup->workgroupName()));
+
+    if (members.isEmpty()) {
+        return;
     }
 
-    mutex.unlock();
+    for (const HostPtr &host : members) {
+        takeItem(p->hostsList, p->hostsPositions, host);
+        p->hostsIndex.remove(Smb4KGlobalPrivate::hostKey(host->hostName()), host);
+        Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, host);
+    }
+
+    //
+    // Remove the shares of the members
+    //
+    for (const HostPtr &host : members) {
+        const QList<SharePtr> shares = p->sharedResourcesIndex.take(Smb4KGlobalPrivate::memberKey(host->workgroupName(), host->hostName()));
 
-    return hosts;
+        for (const SharePtr &share : shares) {
+            takeItem(p->sharesList, p->sharesPositions, share);
+            p->sharesIndex.remove(share->key(), share);
+            Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, share);
+        }
+    }
 }
 
-const QList<SharePtr> &Smb4KGlobal::sharesList()
+QList<SharePtr> Smb4KGlobal::sharesList()
 {
     return p->sharesList;
 }
 
 SharePtr Smb4KGlobal::findShare(const QUrl &url, const QString &workgroup)
 {
-    SharePtr share;
+    return lookupShare(Smb4KBasicNetworkItem::keyForUrl(url), workgroup);
+}
 
-    mutex.lock();
+//
+// Copy the mount data of the mounted share to the network share. Only
+// honor shares that are owned by the user.
+//
+static void copyMountData(const SharePtr &share)
+{
+    const QList<SharePtr> mountedShares = p->mountedSharesUrlIndex.values(share->key());
 
-    for (const SharePtr &s : std::as_const(p->sharesList)) {
-        if (QString::compare(s->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                             url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                             Qt::CaseInsensitive)
-                == 0
-            && (workgroup.isEmpty() || QString::compare(s->workgroupName(), workgroup, Qt::CaseInsensitive) == 0)) {
-            share = s;
+    for (const SharePtr &s : mountedShares) {
+        if (!s->isForeign()) {
+            share->setMountData(s.data());
             break;
         }
     }
-
-    mutex.unlock();
-
-    return share;
 }
 
 bool Smb4KGlobal::addShare(SharePtr share)
@@ -308,39 +571,23 @@ bool Smb4KGlobal::addShare(SharePtr share)
     bool added = false;
 
     if (share) {
-        mutex.lock();
+        //
+        // Set the share mounted
+        //
+        copyMountData(share);
 
         //
         // Add the share
         //
-        if (!findShare(share->url(), share->workgroupName())) {
-            //
-            // Set the share mounted
-            // Only honor shares that are owned by the user
-            //
-            QList<SharePtr> mountedShares = findShareByUrl(share->url());
-
-            if (!mountedShares.isEmpty()) {
-                for (const SharePtr &s : std::as_const(mountedShares)) {
-                    if (!s->isForeign()) {
-                        share->setMountData(s.data());
-                        break;
-                    } else {
-                        continue;
-                    }
-                }
-            }
 
-            //
-            // Add it
-            //
-            p->sharesList.append(share);
+        if (!lookupShare(share->key(), share->workgroupName())) {
+            appendItem(p->sharesList, p->sharesPositions, share);
+            indexShare(share);
+            Smb4KChangeNotifier::self()->postAdded(Smb4KChangeNotifier::NetworkNeighborhood, share);
             added = true;
         }
     }
 
-    mutex.unlock();
-
     return added;
 }
 
@@ -351,76 +598,92 @@ bool Smb4KGlobal::updateShare(SharePtr share)
     bool updated = false;
 
     if (share) {
-        mutex.lock();
+        //
+        // Set the share mounted
+        //
+        copyMountData(share);
 
         //
-        // Updated the share
+        // Update the share
         //
-        SharePtr existingShare = findShare(share->url(), share->workgroupName());
+
+        SharePtr existingShare = lookupShare(share->key(), share->workgroupName());
 
         if (existingShare) {
             //
-            // Set the share mounted
-            // Only honor shares that are owned by the user
+            // Update it. Homes shares might change their URL, so
+            // keep the index up to date.
             //
-            QList<SharePtr> mountedShares = findShareByUrl(share->url());
-
-            if (!mountedShares.isEmpty()) {
-                for (const SharePtr &s : std::as_const(mountedShares)) {
-                    if (!s->isForeign()) {
-                        share->setMountData(s.data());
-                        break;
-                    } else {
-                        continue;
-                    }
-                }
-            }
+            Smb4KShare before(*existingShare);
+            QString oldKey = existingShare->key();
 
-            //
-            // Update it
-            //
             existingShare->update(share.data());
+
+            QString newKey = existingShare->key();
+
+            if (oldKey != newKey) {
+                p->sharesIndex.remove(oldKey, existingShare);
+                p->sharesIndex.insert(newKey, existingShare);
+            }
+
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood, existingShare, changedFields(before, *existingShare));
+
             updated = true;
         }
-
-        mutex.unlock();
     }
 
     return updated;
 }
 
-bool Smb4KGlobal::removeShare(SharePtr share)
+bool Smb4KGlobal::modifyShare(SharePtr share, const std::function<int(Smb4KShare *)> &modify)
 {
     Q_ASSERT(share);
 
-    bool removed = false;
+    bool modified = false;
 
     if (share) {
-        mutex.lock();
+        SharePtr existingShare = lookupShare(share->key(), share->workgroupName());
 
-        int index = p->sharesList.indexOf(share);
+        if (existingShare) {
+            //
+            // The URL might be modified, so keep the index up to date.
+            //
+            QString oldKey = existingShare->key();
 
-        if (index != -1) {
-            // The share was found. Remove it.
-            p->sharesList.takeAt(index).clear();
-            removed = true;
-        } else {
-            // Try harder to find the share.
-            SharePtr s = findShare(share->url(), share->workgroupName());
+            int fields = modify(existingShare.data());
 
-            if (s) {
-                index = p->sharesList.indexOf(s);
+            QString newKey = existingShare->key();
 
-                if (index != -1) {
-                    p->sharesList.takeAt(index).clear();
-                    removed = true;
-                }
+            if (oldKey != newKey) {
+                p->sharesIndex.remove(oldKey, existingShare);
+                p->sharesIndex.insert(newKey, existingShare);
             }
 
-            share.clear();
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood, existingShare, fields);
+            modified = true;
         }
+    }
+
+    return modified;
+}
+
+bool Smb4KGlobal::removeShare(SharePtr share)
+{
+    Q_ASSERT(share);
+
+    bool removed = false;
+
+    if (share) {
+        //
+        // If the share is not in the list, try harder to find it.
+        //
+        SharePtr existingShare = p->sharesPositions.contains(share.data()) ? share : lookupShare(share->key(), share->workgroupName());
 
-        mutex.unlock();
+        if (existingShare && takeItem(p->sharesList, p->sharesPositions, existingShare)) {
+            unindexShare(existingShare);
+            Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, existingShare);
+            removed = true;
+        }
     }
 
     return removed;
@@ -428,79 +691,58 @@ bool Smb4KGlobal::removeShare(SharePtr share)
 
 void Smb4KGlobal::clearSharesList()
 {
-    mutex.lock();
+    p->sharesIndex.clear();
+    p->sharedResourcesIndex.clear();
 
-    while (!p->sharesList.isEmpty()) {
-        p->sharesList.takeFirst().clear();
+    for (const SharePtr &share : std::as_const(p->sharesList)) {
+        Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, share);
     }
 
-    mutex.unlock();
+    p->sharesList.clear();
+    p->sharesPositions.clear();
 }
 
 QList<SharePtr> Smb4KGlobal::sharedResources(HostPtr host)
 {
-    QList<SharePtr> shares;
+    return p->sharedResourcesIndex.value(Smb4KGlobalPrivate::memberKey(host->workgroupName(), host->hostName()));
+}
 
-    mutex.lock();
+void Smb4KGlobal::removeSharedResources(HostPtr host)
+{
+    Q_ASSERT(host);
 
-    for (const SharePtr &s : std::as_const(p->sharesList)) {
-        if (QString::compare(s->hostName(), host->hostName(), Qt::CaseInsensitive) == 0
-            && QString::compare(s->workgroupName(), host->workgroupName(), Qt::CaseInsensitive) == 0) {
-            shares += s;
-        }
+    if (!host) {
+        return;
     }
 
-    mutex.unlock();
 
-    return shares;
+    const QList<SharePtr> shares = p->sharedResourcesIndex.take(Smb4KGlobalPrivate::memberKey(host->workgroupName(), host->hostName()));
+
+    for (const SharePtr &share : shares) {
+        takeItem(p->sharesList, p->sharesPositions, share);
+        p->sharesIndex.remove(share->key(), share);
+        Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::NetworkNeighborhood, share);
+    }
 }
 
-const QList<SharePtr> &Smb4KGlobal::mountedSharesList()
+QList<SharePtr> Smb4KGlobal::mountedSharesList()
 {
     return p->mountedSharesList;
 }
 
 SharePtr Smb4KGlobal::findShareByPath(const QString &path)
 {
-    SharePtr share;
-
-    mutex.lock();
-
-    if (!path.isEmpty() && !p->mountedSharesList.isEmpty()) {
-        for (const SharePtr &s : std::as_const(p->mountedSharesList)) {
-            if (QString::compare(s->path(), path, Qt::CaseInsensitive) == 0
-                || (!s->isInaccessible() && QString::compare(s->canonicalPath(), path, Qt::CaseInsensitive) == 0)) {
-                share = s;
-                break;
-            }
-        }
-    }
-
-    mutex.unlock();
-
-    return share;
+    return lookupMountedShare(path);
 }
 
 QList<SharePtr> Smb4KGlobal::findShareByUrl(const QUrl &url)
 {
     QList<SharePtr> shares;
 
-    mutex.lock();
-
-    if (!url.isEmpty() && url.isValid() && !p->mountedSharesList.isEmpty()) {
-        for (const SharePtr &s : std::as_const(p->mountedSharesList)) {
-            if (QString::compare(s->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                == 0) {
-                shares << s;
-                break;
-            }
-        }
+    if (!url.isEmpty() && url.isValid()) {
+        shares = p->mountedSharesUrlIndex.values(Smb4KBasicNetworkItem::keyForUrl(url));
     }
 
-    mutex.unlock();
-
     return shares;
 }
 
@@ -508,7 +750,6 @@ QList<SharePtr> Smb4KGlobal::findInaccessibleShares()
 {
     QList<SharePtr> inaccessibleShares;
 
-    mutex.lock();
 
     for (const SharePtr &s : std::as_const(p->mountedSharesList)) {
         if (s->isInaccessible()) {
@@ -516,11 +757,23 @@ QList<SharePtr> Smb4KGlobal::findInaccessibleShares()
         }
     }
 
-    mutex.unlock();
-
     return inaccessibleShares;
 }
 
+//
+// Copy the mount data of the mounted share @p share to the network share
+//
+static void setNetworkShareMountData(const SharePtr &share)
+{
+    SharePtr networkShare = lookupShare(share->key(), share->workgroupName());
+
+    if (networkShare) {
+        Smb4KShare before(*networkShare);
+        networkShare->setMountData(share.data());
+        Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood, networkShare, changedMountData(before, *networkShare));
+    }
+}
+
 bool Smb4KGlobal::addMountedShare(SharePtr share)
 {
     Q_ASSERT(share);
@@ -528,53 +781,30 @@ bool Smb4KGlobal::addMountedShare(SharePtr share)
     bool added = false;
 
     if (share) {
-        mutex.lock();
-
         //
         // Copy the mount data to the network share if available.
         // Only honor shares that were mounted by the user.
         //
         if (!share->isForeign()) {
-            // Network share
-            SharePtr networkShare = findShare(share->url(), share->workgroupName());
-
-            if (networkShare) {
-                networkShare->setMountData(share.data());
-            }
+            setNetworkShareMountData(share);
         }
 
-        if (!findShareByPath(share->path())) {
-            //
-            // Check if we have to add a workgroup name and/or IP address
-            //
-            HostPtr networkHost = findHost(share->hostName(), share->workgroupName());
-
-            if (networkHost) {
-                // Set the IP address
-                if (!share->hasHostIpAddress() || networkHost->ipAddress() != share->hostIpAddress()) {
-                    share->setHostIpAddress(networkHost->ipAddress());
-                }
-
-                // Set the workgroup name
-                if (share->workgroupName().isEmpty()) {
-                    share->setWorkgroupName(networkHost->workgroupName());
-                }
-            }
+        //
+        // Check if we have to add a workgroup name and/or IP address
+        //
+        completeMountedShare(share);
 
-            p->mountedSharesList.append(share);
-            added = true;
 
-            p->onlyForeignShares = true;
+        if (!lookupMountedShare(share->path())) {
+            appendItem(p->mountedSharesList, p->mountedSharesPositions, share);
+            indexMountedShare(share);
+            Smb4KChangeNotifier::self()->postAdded(Smb4KChangeNotifier::MountedShares, share);
+            added = true;
 
-            for (const SharePtr &s : std::as_const(p->mountedSharesList)) {
-                if (!s->isForeign()) {
-                    p->onlyForeignShares = false;
-                    break;
-                }
+            if (!share->isForeign()) {
+                p->ownMountedShares++;
             }
         }
-
-        mutex.unlock();
     }
 
     return added;
@@ -587,53 +817,73 @@ bool Smb4KGlobal::updateMountedShare(SharePtr share)
     bool updated = false;
 
     if (share) {
-        mutex.lock();
-
         //
         // Copy the mount data to the network share (needed for unmounting from the network browser)
         // Only honor shares that were mounted by the user.
         //
         if (!share->isForeign()) {
-            SharePtr networkShare = findShare(share->url(), share->workgroupName());
-
-            if (networkShare) {
-                networkShare->setMountData(share.data());
-            }
+            setNetworkShareMountData(share);
         }
 
-        SharePtr mountedShare = findShareByPath(share->path());
+        //
+        // Check if we have to add a workgroup name and/or IP address
+        //
+        completeMountedShare(share);
 
-        if (mountedShare) {
-            //
-            // Check if we have to add a workgroup name and/or IP address
-            //
-            HostPtr networkHost = findHost(share->hostName(), share->workgroupName());
-
-            if (networkHost) {
-                // Set the IP address
-                if (!share->hasHostIpAddress() || networkHost->ipAddress() != share->hostIpAddress()) {
-                    share->setHostIpAddress(networkHost->ipAddress());
-                }
-
-                // Set the workgroup name
-                if (share->workgroupName().isEmpty()) {
-                    share->setWorkgroupName(networkHost->workgroupName());
-                }
-            }
 
+        SharePtr mountedShare = lookupMountedShare(share->path());
+
+        if (mountedShare) {
             //
             // Update share
             //
+            Smb4KShare before(*mountedShare);
+            unindexMountedShare(mountedShare);
             mountedShare->setMountData(share.data());
+            indexMountedShare(mountedShare);
+
+            if (before.isForeign() != mountedShare->isForeign()) {
+                p->ownMountedShares += before.isForeign() ? 1 : -1;
+            }
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::MountedShares, mountedShare, changedFields(before, *mountedShare));
             updated = true;
         }
-
-        mutex.unlock();
     }
 
     return updated;
 }
 
+bool Smb4KGlobal::modifyMountedShare(SharePtr share, const std::function<int(Smb4KShare *)> &modify)
+{
+    Q_ASSERT(share);
+
+    bool modified = false;
+
+    if (share) {
+        SharePtr mountedShare = lookupMountedShare(share->path());
+
+        if (mountedShare) {
+            //
+            // The URL or the path might be modified, so keep the index up to date.
+            //
+            bool wasForeign = mountedShare->isForeign();
+
+            unindexMountedShare(mountedShare);
+            int fields = modify(mountedShare.data());
+            indexMountedShare(mountedShare);
+
+            if (wasForeign != mountedShare->isForeign()) {
+                p->ownMountedShares += wasForeign ? 1 : -1;
+            }
+
+            Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::MountedShares, mountedShare, fields);
+            modified = true;
+        }
+    }
+
+    return modified;
+}
+
 bool Smb4KGlobal::removeMountedShare(SharePtr share)
 {
     Q_ASSERT(share);
@@ -641,54 +891,39 @@ bool Smb4KGlobal::removeMountedShare(SharePtr share)
     bool removed = false;
 
     if (share) {
-        mutex.lock();
-
         //
         // Reset the mount data for the network share and the
         // search result
         //
         if (!share->isForeign()) {
-            // Network share
-            SharePtr networkShare = findShare(share->url(), share->workgroupName());
+            SharePtr networkShare = lookupShare(share->key(), share->workgroupName());
 
             if (networkShare) {
                 networkShare->resetMountData();
+                Smb4KChangeNotifier::self()->postChanged(Smb4KChangeNotifier::NetworkNeighborhood, networkShare, Smb4KGlobal::MountDataField);
             }
         }
 
         //
-        // Remove the mounted share
+        // Remove the mounted share. If it is not in the list, try harder
+        // to find it.
         //
-        int index = p->mountedSharesList.indexOf(share);
 
-        if (index != -1) {
-            // The share was found. Remove it.
-            p->mountedSharesList.takeAt(index).clear();
-            removed = true;
-        } else {
-            // Try harder to find the share.
-            SharePtr s = findShareByPath(share->isInaccessible() ? share->path() : share->canonicalPath());
+        SharePtr mountedShare = share;
 
-            if (s) {
-                index = p->mountedSharesList.indexOf(s);
-
-                if (index != -1) {
-                    p->mountedSharesList.takeAt(index).clear();
-                    removed = true;
-                }
-            }
-
-            share.clear();
+        if (!p->mountedSharesPositions.contains(share.data())) {
+            mountedShare = lookupMountedShare(share->isInaccessible() ? share->path() : share->canonicalPath());
         }
 
-        for (const SharePtr &s : std::as_const(p->mountedSharesList)) {
-            if (!s->isForeign()) {
-                p->onlyForeignShares = false;
-                break;
+        if (mountedShare && takeItem(p->mountedSharesList, p->mountedSharesPositions, mountedShare)) {
+            unindexMountedShare(mountedShare);
+            Smb4KChangeNotifier::self()->postRemoved(Smb4KChangeNotifier::MountedShares, mountedShare);
+            removed = true;
+
+            if (!mountedShare->isForeign()) {
+                p->ownMountedShares--;
             }
         }
-
-        mutex.unlock();
     }
 
     return removed;
@@ -696,7 +931,7 @@ bool Smb4KGlobal::removeMountedShare(SharePtr share)
 
 bool Smb4KGlobal::onlyForeignMountedShares()
 {
-    return p->onlyForeignShares;
+    return p->ownMountedShares == 0;
 }
 
 void Smb4KGlobal::openShare(SharePtr share, OpenWith openWith)
@@ -26,6 +26,9 @@
 #include <QString>
 #include <QStringList>
 
+// std includes
+#include <functional>
+
 // type definitions
 typedef QSharedPointer<Smb4KBasicNetworkItem> NetworkItemPtr;
 typedef QSharedPointer<Smb4KWorkgroup> WorkgroupPtr;
@@ -45,18 +48,26 @@ typedef QSharedPointer<Smb4KCustomSettings> CustomSettingsPtr;
  * of workgroups, hosts and shares, to the global settings of the Samba
  * configuration and much more.
  *
+ * The global lists must only be accessed from the main thread. The lists
+ * returned by the functions below are copies, but their items are shared
+ * with the global lists. Do not modify an item of a global list directly,
+ * but use the respective update or modify function, so that the change is
+ * reported.
+ *
  * @author    Alexander Reinholdt <alexander.reinholdt@kdemail.net>
  */
 
 namespace Smb4KGlobal
 {
 /**
- * This function returns the global list of workgroups that were discovered by
- * Smb4K. Use this if you want to access and modify the list with your code.
+ * This function returns a copy of the global list of workgroups that were
+ * discovered by Smb4K. The copy does not change while you iterate over it,
+ * even if the global list is modified in the meantime. Use the functions below
+ * to modify the global list.
  *
  * @returns the global list of known workgroups.
  */
-SMB4KCORE_EXPORT const QList<WorkgroupPtr> &workgroupsList();
+SMB4KCORE_EXPORT QList<WorkgroupPtr> workgroupsList();
 
 /**
  * This function returns the workgroup or domain that matches the name @p name or
@@ -90,6 +101,16 @@ SMB4KCORE_EXPORT bool addWorkgroup(WorkgroupPtr workgroup);
  */
 SMB4KCORE_EXPORT bool updateWorkgroup(WorkgroupPtr workgroup);
 
+/**
+ * This function modifies the workgroup @p workgroup of the global list in place.
+ * The function @p modify is called with the workgroup of the global list.
+ * It has to return the properties it changed (see Smb4KGlobal::ChangedField).
+ * In contrast to @see updateWorkgroup(), no second workgroup object is needed.
+ *
+ * @returns TRUE if the workgroup was found and FALSE otherwise
+ */
+SMB4KCORE_EXPORT bool modifyWorkgroup(WorkgroupPtr workgroup, const std::function<int(Smb4KWorkgroup *)> &modify);
+
 /**
  * This function removes a workgroup @p workgroup from the list of domains. The
  * pointer that is passed to this function will be deleted. You won't be able
@@ -110,12 +131,14 @@ SMB4KCORE_EXPORT bool removeWorkgroup(WorkgroupPtr workgroup);
 SMB4KCORE_EXPORT void clearWorkgroupsList();
 
 /**
- * This function returns the global list of hosts that were discovered by
- * Smb4K. Use this if you want to access and modify the list with your code.
+ * This function returns a copy of the global list of hosts that were
+ * discovered by Smb4K. The copy does not change while you iterate over it,
+ * even if the global list is modified in the meantime. Use the functions below
+ * to modify the global list.
  *
  * @returns the global list of known hosts.
  */
-SMB4KCORE_EXPORT const QList<HostPtr> &hostsList();
+SMB4KCORE_EXPORT QList<HostPtr> hostsList();
 
 /**
  * This function returns the host matching the name @p name or NULL if there is no
@@ -154,6 +177,16 @@ SMB4KCORE_EXPORT bool addHost(HostPtr host);
  */
 SMB4KCORE_EXPORT bool updateHost(HostPtr host);
 
+/**
+ * This function modifies the host @p host of the global list in place.
+ * The function @p modify is called with the host of the global list.
+ * It has to return the properties it changed (see Smb4KGlobal::ChangedField).
+ * In contrast to @see updateHost(), no second host object is needed.
+ *
+ * @returns TRUE if the host was found and FALSE otherwise
+ */
+SMB4KCORE_EXPORT bool modifyHost(HostPtr host, const std::function<int(Smb4KHost *)> &modify);
+
 /**
  * This function removes a host @p host from the list of hosts. The
  * pointer that is passed to this function will be deleted. You won't
@@ -186,12 +219,24 @@ SMB4KCORE_EXPORT void clearHostsList();
 SMB4KCORE_EXPORT QList<HostPtr> workgroupMembers(WorkgroupPtr workgroup);
 
 /**
- * This function returns the list of shares that were discovered by Smb4K.
- * Use this if you want to access and modify the list with your code.
+ * This function removes all hosts that belong to the workgroup or domain
+ * @p workgroup from the global list of hosts. The shares of these hosts are
+ * removed from the global list of shares as well. The workgroup itself is
+ * not removed, use @see removeWorkgroup() for that.
+ *
+ * @param workgroup   The workgroup whose members should be removed
+ */
+SMB4KCORE_EXPORT void removeWorkgroupMembers(WorkgroupPtr workgroup);
+
+/**
+ * This function returns a copy of the list of shares that were discovered
+ * by Smb4K. The copy does not change while you iterate over it, even if the
+ * global list is modified in the meantime. Use the functions below to modify
+ * the global list.
  *
  * @returns the global list of known shares.
  */
-SMB4KCORE_EXPORT const QList<SharePtr> &sharesList();
+SMB4KCORE_EXPORT QList<SharePtr> sharesList();
 
 /**
  * This function returns the share with URL @p url located in the workgroup or
@@ -230,6 +275,16 @@ SMB4KCORE_EXPORT bool addShare(SharePtr share);
  */
 SMB4KCORE_EXPORT bool updateShare(SharePtr share);
 
+/**
+ * This function modifies the share @p share of the global list in place.
+ * The function @p modify is called with the share of the global list.
+ * It has to return the properties it changed (see Smb4KGlobal::ChangedField).
+ * In contrast to @see updateShare(), no second share object is needed.
+ *
+ * @returns TRUE if the share was found and FALSE otherwise
+ */
+SMB4KCORE_EXPORT bool modifyShare(SharePtr share, const std::function<int(Smb4KShare *)> &modify);
+
 /**
  * This function removes a share @p share from the list of shares. The
  * pointer that is passed to this function will be deleted. You won't
@@ -262,12 +317,23 @@ SMB4KCORE_EXPORT void clearSharesList();
 SMB4KCORE_EXPORT QList<SharePtr> sharedResources(HostPtr host);
 
 /**
- * This function returns the global list of mounted shares that were discovered by
- * Smb4K. Use this if you want to access and modify the list with your code.
+ * This function removes all shares that are provided by the host @p host from
+ * the global list of shares. The host itself is not removed, use @see removeHost()
+ * for that.
+ *
+ * @param host          The host whose shares should be removed
+ */
+SMB4KCORE_EXPORT void removeSharedResources(HostPtr host);
+
+/**
+ * This function returns a copy of the global list of mounted shares that were
+ * discovered by Smb4K. The copy does not change while you iterate over it,
+ * even if the global list is modified in the meantime. Use the functions below
+ * to modify the global list.
  *
  * @returns the global list of known mounted shares.
  */
-SMB4KCORE_EXPORT const QList<SharePtr> &mountedSharesList();
+SMB4KCORE_EXPORT QList<SharePtr> mountedSharesList();
 
 /**
  * Find a mounted share by its path (i.e. mount point).
@@ -318,6 +384,15 @@ SMB4KCORE_EXPORT bool addMountedShare(SharePtr share);
  */
 SMB4KCORE_EXPORT bool updateMountedShare(SharePtr share);
 
+/**
+ * This function modifies the mounted share @p share of the global list in
+ * place. The function @p modify is called with the share of the global list.
+ * It has to return the properties it changed (see Smb4KGlobal::ChangedField).
+ *
+ * @returns TRUE if the share was found and FALSE otherwise
+ */
+SMB4KCORE_EXPORT bool modifyMountedShare(SharePtr share, const std::function<int(Smb4KShare *)> &modify);
+
 /**
  * This function removes a mounted share @p share from the list of mounted
  * shares. The pointer that is passed to this function will be deleted.
@@ -24,7 +24,7 @@
 
 Smb4KGlobalPrivate::Smb4KGlobalPrivate()
 {
-    onlyForeignShares = false;
+    ownMountedShares = 0;
 
 #ifdef Q_OS_LINUX
     //
@@ -140,6 +140,37 @@ Smb4KGlobalPrivate::~Smb4KGlobalPrivate()
     while (!sharesList.isEmpty()) {
         sharesList.takeFirst().clear();
     }
+
+    //
+    // Clear the indexes
+    //
+    workgroupsIndex.clear();
+    hostsIndex.clear();
+    sharesIndex.clear();
+    workgroupMembersIndex.clear();
+    sharedResourcesIndex.clear();
+    mountedSharesUrlIndex.clear();
+    mountedSharesPathIndex.clear();
+    mountedSharesPathKeys.clear();
+    workgroupsPositions.clear();
+    hostsPositions.clear();
+    sharesPositions.clear();
+    mountedSharesPositions.clear();
+}
+
+QString Smb4KGlobalPrivate::workgroupKey(const QString &name)
+{
+    return name.toCaseFolded();
+}
+
+QString Smb4KGlobalPrivate::hostKey(const QString &name)
+{
+    return name.toCaseFolded();
+}
+
+QString Smb4KGlobalPrivate::memberKey(const QString &workgroup, const QString &host)
+{
+    return workgroup.toCaseFolded() + QStringLiteral("/") + host.toCaseFolded();
 }
 
 void Smb4KGlobalPrivate::slotAboutToQuit()
@@ -15,8 +15,10 @@
 
 // Qt includes
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QList>
 #include <QMap>
+#include <QMultiHash>
 #include <QObject>
 #include <QSharedPointer>
 
@@ -62,10 +64,81 @@ public:
     QList<QSharedPointer<Smb4KShare>> sharesList;
 
     /**
-     * Boolean that is TRUE when only foreign shares
-     * are in the list of mounted shares
+     * The index of the workgroup list. The key is the case folded
+     * workgroup name.
      */
-    bool onlyForeignShares;
+    QHash<QString, QSharedPointer<Smb4KWorkgroup>> workgroupsIndex;
+
+    /**
+     * The index of the host list. The key is the case folded host
+     * name. Hosts with the same name may exist in different workgroups.
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KHost>> hostsIndex;
+
+    /**
+     * The index of the share list. The key is the case folded URL
+     * without user info and port.
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KShare>> sharesIndex;
+
+    /**
+     * The members of each workgroup. The key is the same as for the
+     * workgroup index.
+     */
+    QHash<QString, QList<QSharedPointer<Smb4KHost>>> workgroupMembersIndex;
+
+    /**
+     * The shares of each host. The key is built by memberKey() from the
+     * workgroup and host name.
+     */
+    QHash<QString, QList<QSharedPointer<Smb4KShare>>> sharedResourcesIndex;
+
+    /**
+     * The index of the mounted shares by their URL. The key is the
+     * same as for the share list.
+     */
+    QMultiHash<QString, QSharedPointer<Smb4KShare>> mountedSharesUrlIndex;
+
+    /**
+     * The index of the mounted shares by their path and their canonical
+     * path. The key is the case folded path.
+     */
+    QHash<QString, QSharedPointer<Smb4KShare>> mountedSharesPathIndex;
+
+    /**
+     * The keys each mounted share was entered with into the path index
+     */
+    QHash<Smb4KShare *, QStringList> mountedSharesPathKeys;
+
+    /**
+     * The positions of the items in the lists. They are used to remove
+     * an item without searching the list.
+     */
+    QHash<Smb4KWorkgroup *, qsizetype> workgroupsPositions;
+    QHash<Smb4KHost *, qsizetype> hostsPositions;
+    QHash<Smb4KShare *, qsizetype> sharesPositions;
+    QHash<Smb4KShare *, qsizetype> mountedSharesPositions;
+
+    /**
+     * Returns the key used by the workgroup index
+     */
+    static QString workgroupKey(const QString &name);
+
+    /**
+     * Returns the key used by the host index
+     */
+    static QString hostKey(const QString &name);
+
+    /**
+     * Returns the key used by the index of the shared resources
+     */
+    static QString memberKey(const QString &workgroup, const QString &host);
+
+    /**
+     * The number of shares in the list of mounted shares that
+     * are not foreign
+     */
+    int ownMountedShares;
 
 #ifdef Q_OS_LINUX
     /**
@@ -68,6 +68,32 @@ enum ShareType {
     PrinterShare,
     IpcShare
 };
+
+/**
+ * The enumeration that determines which properties of a network item
+ * changed. The values can be combined.
+ *
+ * @enum NoField                Nothing changed
+ * @enum UrlField               The URL including the user info and port
+ * @enum CommentField           The comment
+ * @enum IpAddressField         The IP address of a host or the host of a share
+ * @enum MasterBrowserField     The master browser of a workgroup or the master browser flag of a host
+ * @enum MountDataField         The mount data of a share (path, mount state, accessibility, disk usage)
+ * @enum ShareTypeField         The type of a share
+ * @enum StaleField             The stale flag
+ * @enum AllFields              Everything changed
+ */
+enum ChangedField {
+    NoField = 0x00,
+    UrlField = 0x01,
+    CommentField = 0x02,
+    IpAddressField = 0x04,
+    MasterBrowserField = 0x08,
+    MountDataField = 0x10,
+    ShareTypeField = 0x20,
+    StaleField = 0x40,
+    AllFields = 0x7F
+};
 };
 
 #endif
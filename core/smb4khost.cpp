@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a host.
 
-    SPDX-FileCopyrightText: 2008-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2008-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -13,9 +13,6 @@
 #include <QStringList>
 #include <QUrl>
 
-// KDE includes
-#include <KIconLoader>
-
 using namespace Smb4KGlobal;
 
 class Smb4KHostPrivate
@@ -23,7 +20,9 @@ class Smb4KHostPrivate
 public:
     QString workgroup;
     QHostAddress ip;
-    bool isMaster;
+    mutable QString hostName;
+    bool isMaster : 1;
+    mutable bool hostNameValid;
 };
 
 Smb4KHost::Smb4KHost(const QUrl &url)
@@ -31,7 +30,7 @@ Smb4KHost::Smb4KHost(const QUrl &url)
     , d(new Smb4KHostPrivate)
 {
     d->isMaster = false;
-    *pIcon = KDE::icon(QStringLiteral("network-server"));
+    d->hostNameValid = false;
     *pUrl = url;
 }
 
@@ -40,10 +39,6 @@ Smb4KHost::Smb4KHost(const Smb4KHost &host)
     , d(new Smb4KHostPrivate)
 {
     *d = *host.d;
-
-    if (pIcon->isNull()) {
-        *pIcon = KDE::icon(QStringLiteral("network-server"));
-    }
 }
 
 Smb4KHost::Smb4KHost()
@@ -51,27 +46,39 @@ Smb4KHost::Smb4KHost()
     , d(new Smb4KHostPrivate)
 {
     d->isMaster = false;
-    *pIcon = KDE::icon(QStringLiteral("network-server"));
+    d->hostNameValid = false;
 }
 
 Smb4KHost::~Smb4KHost()
 {
 }
 
+QIcon Smb4KHost::icon() const
+{
+    QIcon icon = Smb4KBasicNetworkItem::icon();
+    return !icon.isNull() ? icon : cachedIcon(QStringLiteral("network-server"));
+}
+
 void Smb4KHost::setHostName(const QString &name)
 {
     pUrl->setHost(name);
     pUrl->setScheme(QStringLiteral("smb"));
+    invalidateKey();
 }
 
 QString Smb4KHost::hostName() const
 {
-    return pUrl->host().toUpper();
+    if (!d->hostNameValid) {
+        d->hostName = pUrl->host().toUpper();
+        d->hostNameValid = true;
+    }
+
+    return d->hostName;
 }
 
 void Smb4KHost::setWorkgroupName(const QString &workgroup)
 {
-    d->workgroup = workgroup.toUpper();
+    d->workgroup = internedString(workgroup.toUpper());
 }
 
 QString Smb4KHost::workgroupName() const
@@ -145,8 +152,10 @@ void Smb4KHost::update(Smb4KHost *host)
 {
     if (QString::compare(workgroupName(), host->workgroupName()) == 0 && QString::compare(hostName(), host->hostName()) == 0) {
         *pUrl = host->url();
+        invalidateKey();
         setComment(host->comment());
         setIsMasterBrowser(host->isMasterBrowser());
+        setStale(host->isStale());
 
         // Do not kill the already discovered IP address
         if (!hasIpAddress() && host->hasIpAddress()) {
@@ -155,8 +164,15 @@ void Smb4KHost::update(Smb4KHost *host)
     }
 }
 
+void Smb4KHost::invalidateKey() const
+{
+    Smb4KBasicNetworkItem::invalidateKey();
+    d->hostNameValid = false;
+}
+
 Smb4KHost &Smb4KHost::operator=(const Smb4KHost &other)
 {
     *d = *other.d;
+    d->hostNameValid = false;
     return *this;
 }
@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a host.
 
-    SPDX-FileCopyrightText: 2008-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2008-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -57,6 +57,13 @@ public:
      */
     ~Smb4KHost();
 
+    /**
+     * Returns the icon of the host. The icon is the same for all hosts.
+     *
+     * @returns the icon
+     */
+    QIcon icon() const override;
+
     /**
      * Set the name of the host.
      *
@@ -187,6 +194,12 @@ public:
      */
     Smb4KHost &operator=(const Smb4KHost &other);
 
+protected:
+    /**
+     * Reimplemented from Smb4KBasicNetworkItem to drop the cached name.
+     */
+    void invalidateKey() const override;
+
 private:
     const QScopedPointer<Smb4KHostPrivate> d;
 };
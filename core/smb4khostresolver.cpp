@@ -0,0 +1,258 @@
+/*
+    Asynchronous and caching resolver for host names
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4khostresolver.h"
+#include "smb4kglobal.h"
+#include "smb4khardwareinterface.h"
+
+// Qt includes
+#include <QAbstractSocket>
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QNetworkInterface>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+
+#define CACHE_TIMEOUT 300000
+#define NEGATIVE_CACHE_TIMEOUT 30000
+#define LOOKUP_TIMEOUT 10000
+
+using namespace Smb4KGlobal;
+
+struct Smb4KHostResolverCacheEntry {
+    QHostAddress address;
+    QDeadlineTimer expiry;
+};
+
+class Smb4KHostResolverPrivate
+{
+public:
+    mutable QMutex mutex;
+    QWaitCondition lookupFinished;
+    QHash<QString, Smb4KHostResolverCacheEntry> cache;
+    QSet<QString> pendingNames;
+    QHash<int, QString> lookups;
+};
+
+class Smb4KHostResolverStatic
+{
+public:
+    Smb4KHostResolver instance;
+};
+
+Q_GLOBAL_STATIC(Smb4KHostResolverStatic, p);
+
+//
+// Choose the address that is used for the host. For the time being,
+// prefer the IPv4 address over the IPv6 address.
+//
+static QHostAddress preferredAddress(const QList<QHostAddress> &addresses)
+{
+    QHostAddress ipAddress;
+
+    for (const QHostAddress &addr : addresses) {
+        // We only use global addresses.
+        if (addr.isGlobal()) {
+            if (addr.protocol() == QAbstractSocket::IPv4Protocol) {
+                ipAddress = addr;
+                break;
+            } else if (addr.protocol() == QAbstractSocket::IPv6Protocol) {
+                // FIXME: Use the right address here.
+                ipAddress = addr;
+            }
+        }
+    }
+
+    return ipAddress;
+}
+
+Smb4KHostResolver::Smb4KHostResolver(QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KHostResolverPrivate)
+{
+    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::onlineStateChanged, this, &Smb4KHostResolver::slotOnlineStateChanged);
+}
+
+Smb4KHostResolver::~Smb4KHostResolver()
+{
+}
+
+Smb4KHostResolver *Smb4KHostResolver::self()
+{
+    return &p->instance;
+}
+
+void Smb4KHostResolver::lookup(const QStringList &names)
+{
+    //
+    // The lookups are always started from the main thread, so that the
+    // results are delivered there regardless of the calling thread.
+    //
+    QMetaObject::invokeMethod(
+        this,
+        [this, names]() {
+            slotStartLookups(names);
+        },
+        Qt::QueuedConnection);
+}
+
+QMap<QString, QHostAddress> Smb4KHostResolver::lookupAndWait(const QStringList &names, const std::atomic<bool> *cancelled)
+{
+    Q_ASSERT(QThread::currentThread() != thread());
+
+    QMap<QString, QHostAddress> addresses;
+    QStringList missingNames;
+
+    for (const QString &name : names) {
+        QHostAddress address;
+
+        if (cachedAddress(name, &address)) {
+            addresses.insert(name, address);
+        } else {
+            missingNames << name;
+        }
+    }
+
+    if (!missingNames.isEmpty()) {
+        lookup(missingNames);
+
+        QMutexLocker locker(&d->mutex);
+        QDeadlineTimer deadline(LOOKUP_TIMEOUT);
+
+        for (const QString &name : std::as_const(missingNames)) {
+            const QString key = name.toUpper();
+
+            while (!d->cache.contains(key) || d->cache.value(key).expiry.hasExpired()) {
+                //
+                // The caller does not need the addresses anymore
+                //
+                if (cancelled && cancelled->load()) {
+                    return addresses;
+                }
+
+                if (!d->lookupFinished.wait(&d->mutex, deadline)) {
+                    break;
+                }
+            }
+
+            addresses.insert(name, d->cache.value(key).address);
+        }
+    }
+
+    return addresses;
+}
+
+bool Smb4KHostResolver::cachedAddress(const QString &name, QHostAddress *address) const
+{
+    QMutexLocker locker(&d->mutex);
+
+    auto it = d->cache.constFind(name.toUpper());
+
+    if (it != d->cache.constEnd() && !it->expiry.hasExpired()) {
+        *address = it->address;
+        return true;
+    }
+
+    return false;
+}
+
+void Smb4KHostResolver::cancelWaits()
+{
+    QMutexLocker locker(&d->mutex);
+    d->lookupFinished.wakeAll();
+}
+
+void Smb4KHostResolver::clearCache()
+{
+    QMutexLocker locker(&d->mutex);
+    d->cache.clear();
+}
+
+void Smb4KHostResolver::slotStartLookups(const QStringList &names)
+{
+    for (const QString &name : names) {
+        const QString key = name.toUpper();
+        QHostAddress address;
+
+        //
+        // Report cached addresses right away
+        //
+        if (cachedAddress(name, &address)) {
+            Q_EMIT addressResolved(name, address);
+            continue;
+        }
+
+        //
+        // Do not look up a name twice. The result of the lookup that is
+        // in progress is reported to all receivers.
+        //
+        {
+            QMutexLocker locker(&d->mutex);
+
+            if (d->pendingNames.contains(key)) {
+                continue;
+            }
+
+            d->pendingNames.insert(key);
+        }
+
+        //
+        // If the IP address is not to be determined for the local machine, we can use QHostInfo to
+        // determine it. Otherwise we need to use QNetworkInterface for it.
+        //
+        if (key == QHostInfo::localHostName().toUpper() || key == machineNetbiosName().toUpper()) {
+            // FIXME: Do we need to honor 'interfaces' here?
+            QHostInfo hostInfo;
+            hostInfo.setHostName(name);
+            hostInfo.setAddresses(QNetworkInterface::allAddresses());
+            slotLookupFinished(hostInfo);
+        } else {
+            int lookupId = QHostInfo::lookupHost(name, this, &Smb4KHostResolver::slotLookupFinished);
+            d->lookups.insert(lookupId, name);
+        }
+    }
+}
+
+void Smb4KHostResolver::slotLookupFinished(const QHostInfo &hostInfo)
+{
+    QString name = d->lookups.contains(hostInfo.lookupId()) ? d->lookups.take(hostInfo.lookupId()) : hostInfo.hostName();
+    QHostAddress address;
+
+    if (hostInfo.error() == QHostInfo::NoError) {
+        address = preferredAddress(hostInfo.addresses());
+    }
+
+    //
+    // Cache the result. Failed lookups are kept for a shorter time, so that
+    // hosts that were just switched on are found soon.
+    //
+    {
+        QMutexLocker locker(&d->mutex);
+
+        Smb4KHostResolverCacheEntry entry;
+        entry.address = address;
+        entry.expiry.setRemainingTime(address.isNull() ? NEGATIVE_CACHE_TIMEOUT : CACHE_TIMEOUT);
+
+        d->cache.insert(name.toUpper(), entry);
+        d->pendingNames.remove(name.toUpper());
+        d->lookupFinished.wakeAll();
+    }
+
+    Q_EMIT addressResolved(name, address);
+}
+
+void Smb4KHostResolver::slotOnlineStateChanged(bool /*online*/)
+{
+    //
+    // The addresses might have changed with the network
+    //
+    clearCache();
+}
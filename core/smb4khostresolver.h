@@ -0,0 +1,127 @@
+/*
+    Asynchronous and caching resolver for host names
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KHOSTRESOLVER_H
+#define SMB4KHOSTRESOLVER_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+
+// Qt includes
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QMap>
+#include <QObject>
+#include <QScopedPointer>
+#include <QStringList>
+
+// std includes
+#include <atomic>
+
+class Smb4KHostResolverPrivate;
+
+/**
+ * This class resolves the IP addresses of the hosts found while browsing
+ * the network neighborhood. Lookups are done asynchronously and concurrently
+ * with QHostInfo, lookups for the same name that are already in progress are
+ * not issued a second time and the results are cached for a limited time.
+ * Failed lookups are cached as well, but for a shorter time.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.0.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KHostResolver : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The constructor
+     */
+    explicit Smb4KHostResolver(QObject *parent = nullptr);
+
+    /**
+     * The destructor
+     */
+    ~Smb4KHostResolver();
+
+    /**
+     * The static pointer to this class.
+     * @returns a static pointer to this class
+     */
+    static Smb4KHostResolver *self();
+
+    /**
+     * Look up the IP addresses of the hosts in @p names. Cached results are
+     * reported without doing a new lookup, all other names are resolved concurrently.
+     * For each name the addressResolved() signal is emitted. If the name could not be
+     * resolved, the address passed with the signal is null.
+     *
+     * This function is thread-safe, the signal is always emitted in the main thread.
+     *
+     * @param names         The list of host names
+     */
+    void lookup(const QStringList &names);
+
+    /**
+     * Look up the IP addresses of the hosts in @p names and wait until all
+     * lookups finished or timed out. This function is meant to be used from
+     * worker threads. It must not be called from the main thread, since the
+     * lookups themselves are processed there.
+     *
+     * If @p cancelled is set to TRUE and cancelWaits() is called, the function
+     * returns right away.
+     *
+     * @param names         The list of host names
+     * @param cancelled     The flag that tells the caller stopped waiting
+     *
+     * @returns a map of the host names and their addresses. Names that could
+     * not be resolved map to a null address.
+     */
+    QMap<QString, QHostAddress> lookupAndWait(const QStringList &names, const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * Wake up all threads waiting in lookupAndWait(), so that those whose
+     * cancellation flag was set return.
+     */
+    void cancelWaits();
+
+    /**
+     * Return the cached IP address of the host @p name, if there is one.
+     *
+     * @param name          The host name
+     * @param address       The address the cached address is written to
+     *
+     * @returns TRUE if a valid cache entry exists.
+     */
+    bool cachedAddress(const QString &name, QHostAddress *address) const;
+
+    /**
+     * Clear the cache.
+     */
+    void clearCache();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the address of a host was looked up.
+     *
+     * @param name          The host name as passed to lookup()
+     * @param address       The address or a null address if the lookup failed
+     */
+    void addressResolved(const QString &name, const QHostAddress &address);
+
+protected Q_SLOTS:
+    void slotStartLookups(const QStringList &names);
+    void slotLookupFinished(const QHostInfo &hostInfo);
+    void slotOnlineStateChanged(bool online);
+
+private:
+    const QScopedPointer<Smb4KHostResolverPrivate> d;
+};
+
+#endif
@@ -18,6 +18,8 @@
 #include "smb4kprofilemanager.h"
 #include "smb4ksettings.h"
 #include "smb4kshare.h"
+#include "smb4ksharechecker.h"
+#include "smb4kwakeonlan.h"
 #include "smb4kworkgroup.h"
 
 #if defined(Q_OS_LINUX)
@@ -28,14 +30,15 @@
 
 // Qt includes
 #include <QApplication>
+#include <QDeadlineTimer>
 #include <QDebug>
 #include <QDir>
+#include <QEventLoop>
 #include <QFileInfo>
 #include <QHostInfo>
 #include <QPointer>
-#include <QStorageInfo>
+#include <QSet>
 #include <QTimer>
-#include <QUdpSocket>
 
 // KDE includes
 #include <KAuth/ExecuteJob>
@@ -46,26 +49,55 @@
 #include <KUser>
 #include <kauth_version.h>
 
+// std includes
+#include <algorithm>
+
 using namespace Smb4KGlobal;
 
-#define TIMEOUT 50
+#define IMPORT_DELAY 100
+#define REMOUNT_RETRY_DELAY 1000
+
+//
+// Must match PROCESS_TIMEOUT of the mount helper
+//
+#define HELPER_PROCESS_TIMEOUT 30000
+#define HELPER_TIMEOUT_MARGIN 10000
+
+struct Smb4KPendingMount {
+    SharePtr share;
+    QVariantMap args;
+    QString wakeUpMacAddress;
+    QHostAddress wakeUpAddress;
+    bool waitForWakeUp;
+};
+
+struct Smb4KPendingUnmount {
+    SharePtr share;
+    QVariantMap args;
+};
 
 class Smb4KMounterPrivate
 {
 public:
-    int remountTimeout;
     int remountAttempts;
-    int timerId;
-    int checkTimeout;
-    int newlyMounted;
-    int newlyUnmounted;
+    QTimer remountTimer;
+    QDeadlineTimer remountDeadline;
+    QList<SharePtr> newlyMounted;
+    QList<SharePtr> newlyUnmounted;
     QList<SharePtr> importedShares;
+    QList<SharePtr> unclassifiedShares;
     QList<SharePtr> retries;
     QList<SharePtr> remounts;
+    QList<Smb4KPendingMount> pendingMounts;
+    QList<Smb4KPendingUnmount> pendingUnmounts;
+    QList<SharePtr> runningMounts;
+    KJob *helperJob;
+    QSet<QString> wakingUpHosts;
+    bool mountsActive;
     bool detectAllShares;
     bool firstImportDone;
-    bool longActionRunning;
-    QStorageInfo storageInfo;
+    Smb4KMountWatcher *mountWatcher;
+    Smb4KShareChecker *shareChecker;
 };
 
 class Smb4KMounterStatic
@@ -76,20 +108,30 @@ public:
 
 Q_GLOBAL_STATIC(Smb4KMounterStatic, p);
 
+//
+// The time the helper needs at most for a batch of shares. It runs up to
+// maxProcesses processes at the same time, each of which is killed after
+// HELPER_PROCESS_TIMEOUT.
+//
+static int helperTimeout(int count, int maxProcesses)
+{
+    int processes = qMax(1, maxProcesses);
+    int rounds = (count + processes - 1) / processes;
+
+    return rounds * HELPER_PROCESS_TIMEOUT + HELPER_TIMEOUT_MARGIN;
+}
+
 Smb4KMounter::Smb4KMounter(QObject *parent)
     : KCompositeJob(parent)
     , d(new Smb4KMounterPrivate)
 {
     setAutoDelete(false);
 
-    d->timerId = -1;
-    d->remountTimeout = 0;
     d->remountAttempts = 0;
-    d->checkTimeout = 0;
-    d->newlyMounted = 0;
-    d->newlyUnmounted = 0;
+    d->remountTimer.setSingleShot(true);
     d->firstImportDone = false;
-    d->longActionRunning = false;
+    d->mountsActive = false;
+    d->helperJob = nullptr;
     d->detectAllShares = Smb4KMountSettings::detectAllShares();
 
     //
@@ -101,8 +143,33 @@ Smb4KMounter::Smb4KMounter(QObject *parent)
     connect(Smb4KMountSettings::self(), &Smb4KMountSettings::configChanged, this, &Smb4KMounter::slotConfigChanged);
 
     connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::onlineStateChanged, this, &Smb4KMounter::slotOnlineStateChanged);
-    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkShareAdded, this, &Smb4KMounter::slotTriggerImport);
-    connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkShareRemoved, this, &Smb4KMounter::slotTriggerImport);
+
+    //
+    // Only fall back to Solid, if the mount table cannot be watched
+    //
+    d->mountWatcher = new Smb4KMountWatcher(this);
+
+    if (d->mountWatcher->isWatching()) {
+        connect(d->mountWatcher, &Smb4KMountWatcher::mountsChanged, this, &Smb4KMounter::slotMountsChanged);
+    } else {
+        connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkShareAdded, this, &Smb4KMounter::slotTriggerImport);
+        connect(Smb4KHardwareInterface::self(), &Smb4KHardwareInterface::networkShareRemoved, this, &Smb4KMounter::slotTriggerImport);
+    }
+
+    connect(Smb4KWakeOnLan::self(), &Smb4KWakeOnLan::hostWokenUp, this, &Smb4KMounter::slotHostWokenUp);
+
+    connect(&d->remountTimer, &QTimer::timeout, this, &Smb4KMounter::slotRemountTimeout);
+
+    //
+    // A remount that was due while a job was running is started as
+    // soon as the job finished
+    //
+    connect(this, &Smb4KMounter::finished, this, [this]() {
+        scheduleRemounts();
+    });
+
+    d->shareChecker = new Smb4KShareChecker(this);
+    connect(d->shareChecker, &Smb4KShareChecker::checked, this, &Smb4KMounter::slotShareChecked);
 
     connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Smb4KMounter::slotAboutToQuit);
 }
@@ -116,6 +183,8 @@ Smb4KMounter::~Smb4KMounter()
     while (!d->retries.isEmpty()) {
         d->retries.takeFirst().clear();
     }
+
+    d->pendingMounts.clear();
 }
 
 Smb4KMounter *Smb4KMounter::self()
@@ -125,6 +194,13 @@ Smb4KMounter *Smb4KMounter::self()
 
 void Smb4KMounter::abort()
 {
+    //
+    // Drop the queued mounts and unmounts first, so that no new job is
+    // started when the running one is killed.
+    //
+    d->pendingMounts.clear();
+    d->pendingUnmounts.clear();
+
     if (!QCoreApplication::closingDown()) {
         QListIterator<KJob *> it(subjobs());
 
@@ -136,7 +212,7 @@ void Smb4KMounter::abort()
 
 bool Smb4KMounter::isRunning()
 {
-    return (hasSubjobs() || d->longActionRunning);
+    return (hasSubjobs() || !d->pendingMounts.isEmpty() || !d->pendingUnmounts.isEmpty());
 }
 
 void Smb4KMounter::triggerRemounts(bool fillList)
@@ -176,11 +252,10 @@ void Smb4KMounter::triggerRemounts(bool fillList)
             //
             if (remountShare) {
                 bool insertShare = true;
+                QString optionKey = Smb4KBasicNetworkItem::keyForUrl(option->url());
 
                 for (const SharePtr &share : std::as_const(d->remounts)) {
-                    if (QString::compare(share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                         option->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort))
-                        == 0) {
+                    if (share->key() == optionKey) {
                         insertShare = false;
                         break;
                     }
@@ -206,9 +281,27 @@ void Smb4KMounter::triggerRemounts(bool fillList)
     mountShares(d->remounts);
 
     //
-    // Count the remount attempts
+    // Count the remount attempts and set the time of the next one
     //
     d->remountAttempts++;
+    d->remountDeadline.setRemainingTime(60000 * Smb4KMountSettings::remountInterval());
+}
+
+void Smb4KMounter::scheduleRemounts()
+{
+    if (d->remountAttempts >= Smb4KMountSettings::remountAttempts() || !d->firstImportDone || !Smb4KHardwareInterface::self()->isOnline()) {
+        d->remountTimer.stop();
+        return;
+    }
+
+    //
+    // The first attempt is made right after the first import
+    //
+    if (d->remountAttempts == 0) {
+        d->remountTimer.start(0);
+    } else {
+        d->remountTimer.start(static_cast<int>(std::max<qint64>(0, d->remountDeadline.remainingTime())));
+    }
 }
 
 void Smb4KMounter::import(bool checkInaccessible)
@@ -217,174 +310,168 @@ void Smb4KMounter::import(bool checkInaccessible)
         return;
     }
 
-    bool changedMountedSharesList = false;
-    QStringList allMountPoints;
+    QSet<QString> allMountPoints;
+    QList<Smb4KMountEntry> addedEntries;
+    QStringList removedMountPoints;
 
     //
-    // Import new  shares
+    // Find the new shares
     //
-    KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::BasicInfoNeeded | KMountPoint::NeedMountOptions);
+    const QList<Smb4KMountEntry> entries = d->mountWatcher->entries();
 
-    for (const QExplicitlySharedDataPointer<KMountPoint> &mountPoint : std::as_const(mountPoints)) {
-        if (!mountPoint->isOnNetwork()) {
+    for (const Smb4KMountEntry &entry : entries) {
+        allMountPoints << entry.mountPoint;
+
+        // Exclude all shares that were already imported. However, while we are
+        // at it, we schedule a check of them nonetheless.
+        if (SharePtr mountedShare = findShareByPath(entry.mountPoint)) {
+            if (!mountedShare->isInaccessible() || checkInaccessible) {
+                d->shareChecker->check(mountedShare);
+            }
             continue;
         }
 
-        if (mountPoint->mountType() == QStringLiteral("cifs") || mountPoint->mountType() == QStringLiteral("smb3")
-            || mountPoint->mountType() == QStringLiteral("smbfs")) {
-            allMountPoints << mountPoint->mountPoint();
+        // Shares that are still being classified are already known
+        if (findUnclassifiedShare(entry.mountPoint)) {
+            continue;
+        }
 
-            // Exclude all shares that were already imported. However, while we are
-            // at it, we run a check on them nonetheless.
-            if (SharePtr mountedShare = findShareByPath(mountPoint->mountPoint())) {
-                if (!mountedShare->isInaccessible() || checkInaccessible) {
-                    check(mountedShare);
-                }
-                continue;
-            }
+        addedEntries << entry;
+    }
 
-            SharePtr share = SharePtr(new Smb4KShare());
-            share->setUrl(QUrl(mountPoint->mountedFrom()));
-            share->setPath(mountPoint->mountPoint());
-            share->setMounted(true);
+    //
+    // Find the shares that were unmounted
+    //
+    const QList<SharePtr> mountedShares = mountedSharesList();
 
-            QStringList mountOptions = mountPoint->mountOptions();
+    for (const SharePtr &share : mountedShares) {
+        if (!allMountPoints.contains(share->path())) {
+            removedMountPoints << share->path();
+        }
+    }
 
-            for (const QString &option : std::as_const(mountOptions)) {
-                if (option.startsWith(QStringLiteral("domain=")) || option.startsWith(QStringLiteral("workgroup="))) {
-                    share->setWorkgroupName(option.section(QStringLiteral("="), 1, 1).trimmed());
-                } else if (option.startsWith(QStringLiteral("addr="))) {
-                    share->setHostIpAddress(option.section(QStringLiteral("="), 1, 1).trimmed());
-                } else if (option.startsWith(QStringLiteral("username=")) || option.startsWith(QStringLiteral("user="))) {
-                    share->setUserName(option.section(QStringLiteral("="), 1, 1).trimmed());
-                }
-            }
+    for (const SharePtr &share : std::as_const(d->unclassifiedShares)) {
+        if (!allMountPoints.contains(share->path())) {
+            removedMountPoints << share->path();
+        }
+    }
 
-            // Work around empty usernames
-            if (share->userName().isEmpty()) {
-                share->setUserName(QStringLiteral("guest"));
-            }
+    importChanges(addedEntries, removedMountPoints);
+}
+
+void Smb4KMounter::importChanges(const QList<Smb4KMountEntry> &added, const QStringList &removed)
+{
+    bool changedMountedSharesList = false;
+
+    //
+    // Create the new shares. The mount options were already parsed by
+    // the mount watcher.
+    //
+    for (const Smb4KMountEntry &entry : added) {
+        SharePtr share = SharePtr(new Smb4KShare());
+        share->setUrl(QUrl(entry.mountedFrom));
+        share->setPath(entry.mountPoint);
+        share->setFileSystemString(entry.fileSystem);
+        share->setMounted(true);
+
+        if (!entry.workgroupName.isEmpty()) {
+            share->setWorkgroupName(entry.workgroupName);
+        }
 
-            d->importedShares << share;
+        if (!entry.ipAddress.isEmpty()) {
+            share->setHostIpAddress(entry.ipAddress);
         }
+
+        // Work around empty usernames
+        share->setUserName(entry.userName.isEmpty() ? QStringLiteral("guest") : entry.userName);
+
+        d->importedShares << share;
     }
 
     //
-    // Process the shares
+    // Process the unmounted shares
     //
-    SharePtr share;
+    for (const QString &mountPoint : removed) {
+        //
+        // Forget the shares that were unmounted before they were classified
+        //
+        if (SharePtr unclassifiedShare = findUnclassifiedShare(mountPoint)) {
+            d->unclassifiedShares.removeOne(unclassifiedShare);
+            d->shareChecker->removeShare(unclassifiedShare);
+        }
 
-    QList<SharePtr> mountedShares = mountedSharesList();
-    QMutableListIterator<SharePtr> it(mountedShares);
+        SharePtr share = findShareByPath(mountPoint);
 
-    while (it.hasNext()) {
-        share = it.next();
+        if (!share) {
+            continue;
+        }
 
-        if (!allMountPoints.contains(share->path())) {
-            if (!share->isForeign()) {
-                QDir dir;
-                dir.cd(share->canonicalPath());
-                dir.rmdir(dir.canonicalPath());
+        if (!share->isForeign()) {
+            QDir dir;
+            dir.cd(share->canonicalPath());
+            dir.rmdir(dir.canonicalPath());
 
-                if (dir.cdUp()) {
-                    dir.rmdir(dir.canonicalPath());
-                }
+            if (dir.cdUp()) {
+                dir.rmdir(dir.canonicalPath());
             }
+        }
 
-            share->setMounted(false);
+        d->shareChecker->removeShare(share);
 
-            // NOTE: We are operating on a copy of the mounted shares list,
-            // so the following should be fine.
-            if (removeMountedShare(share)) {
-                d->newlyUnmounted += 1;
-                changedMountedSharesList = true;
-                Q_EMIT unmounted(share);
-            }
+        if (removeMountedShare(share)) {
+            share->setMounted(false);
+            d->newlyUnmounted << share;
+            changedMountedSharesList = true;
+            Q_EMIT unmounted(share);
         }
     }
 
     if (!isRunning()) {
-        if (d->newlyUnmounted > 1) {
-            Smb4KNotification::sharesUnmounted(d->newlyUnmounted);
-        } else if (d->newlyUnmounted == 1) {
-            Smb4KNotification::shareUnmounted(share);
+        if (d->newlyUnmounted.size() > 1) {
+            Smb4KNotification::sharesUnmounted(d->newlyUnmounted.size());
+        } else if (d->newlyUnmounted.size() == 1) {
+            Smb4KNotification::shareUnmounted(d->newlyUnmounted.first());
         }
 
-        d->newlyUnmounted = 0;
+        d->newlyUnmounted.clear();
     }
 
-    share.clear();
-
+    //
+    // Process the mounted shares
+    //
     if (Smb4KHardwareInterface::self()->isOnline()) {
         while (!d->importedShares.isEmpty()) {
-            share = d->importedShares.takeFirst();
-
-            check(share);
+            SharePtr share = d->importedShares.takeFirst();
 
-            if (share->path().startsWith(Smb4KMountSettings::mountPrefix().path())
-                || (!share->isInaccessible() && share->canonicalPath().startsWith(QDir(Smb4KMountSettings::mountPrefix().path()).canonicalPath()))) {
-                share->setForeign(false);
-            } else if (share->path().startsWith(QDir::homePath())
-                       || (!share->isInaccessible() && share->canonicalPath().startsWith(QDir::home().canonicalPath()))) {
-                share->setForeign(false);
-            } else if (share->user().userId() == KUser(KUser::UseRealUserID).userId()
-                       && share->group().groupId() == KUserGroup(KUser::UseRealUserID).groupId()) {
+            //
+            // Shares mounted below the mount prefix or the home directory are
+            // added right away. All other shares are classified by their owner
+            // after the share checker accessed them in a worker thread, so that
+            // a server that does not respond cannot block the import.
+            //
+            if (share->path().startsWith(Smb4KMountSettings::mountPrefix().path()) || share->path().startsWith(QDir::homePath())) {
                 share->setForeign(false);
-            } else {
-                share->setForeign(true);
-            }
 
-            if (!share->isForeign() || Smb4KMountSettings::detectAllShares()) {
-                if (addMountedShare(share)) {
-                    d->newlyMounted += 1;
+                if (addImportedShare(share)) {
+                    d->shareChecker->addShare(share);
                     changedMountedSharesList = true;
-
-                    // Remove share from the remounts
-                    QMutableListIterator<SharePtr> s(d->remounts);
-
-                    while (s.hasNext()) {
-                        SharePtr remount = s.next();
-
-                        if (!share->isForeign()
-                            && QString::compare(remount->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                                share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                                Qt::CaseInsensitive)
-                                == 0) {
-                            Smb4KCustomSettingsManager::self()->removeRemount(remount);
-                            s.remove();
-                            break;
-                        }
-                    }
-
-                    Q_EMIT mounted(share);
-                }
-            }
-        }
-
-        if (!isRunning()) {
-            if (d->firstImportDone) {
-                if (d->newlyMounted > 1) {
-                    Smb4KNotification::sharesMounted(d->newlyMounted);
-                } else if (d->newlyMounted == 1) {
-                    Smb4KNotification::shareMounted(share);
                 }
+            } else {
+                d->unclassifiedShares << share;
+                d->shareChecker->addShare(share);
             }
-
-            d->newlyMounted = 0;
         }
 
-        share.clear();
+        notifyMounted();
 
-        if (!d->firstImportDone && d->importedShares.isEmpty()) {
+        if (!d->firstImportDone && d->importedShares.isEmpty() && d->unclassifiedShares.isEmpty()) {
             d->firstImportDone = true;
+            scheduleRemounts();
         }
     } else {
         // If the system is offline, no mounted shares are processed, so
         // empty the list of imported shares here.
-        while (!d->importedShares.isEmpty()) {
-            SharePtr share = d->importedShares.takeFirst();
-            share.clear();
-        }
+        d->importedShares.clear();
     }
 
     if (changedMountedSharesList) {
@@ -392,7 +479,84 @@ void Smb4KMounter::import(bool checkInaccessible)
     }
 }
 
+bool Smb4KMounter::addImportedShare(const SharePtr &share)
+{
+    if (share->isForeign() && !Smb4KMountSettings::detectAllShares()) {
+        return false;
+    }
+
+    if (!addMountedShare(share)) {
+        return false;
+    }
+
+    d->newlyMounted << share;
+
+    //
+    // Remove share from the remounts
+    //
+    QMutableListIterator<SharePtr> s(d->remounts);
+
+    while (s.hasNext()) {
+        SharePtr remount = s.next();
+
+        if (!share->isForeign() && remount->hasSameUrl(share.data())) {
+            Smb4KCustomSettingsManager::self()->removeRemount(remount);
+            s.remove();
+            break;
+        }
+    }
+
+    Q_EMIT mounted(share);
+
+    return true;
+}
+
+SharePtr Smb4KMounter::findUnclassifiedShare(const QString &path) const
+{
+    for (const SharePtr &share : std::as_const(d->unclassifiedShares)) {
+        if (share->path() == path) {
+            return share;
+        }
+    }
+
+    return SharePtr();
+}
+
+void Smb4KMounter::notifyMounted()
+{
+    if (!isRunning()) {
+        if (d->firstImportDone) {
+            if (d->newlyMounted.size() > 1) {
+                Smb4KNotification::sharesMounted(d->newlyMounted.size());
+            } else if (d->newlyMounted.size() == 1) {
+                Smb4KNotification::shareMounted(d->newlyMounted.first());
+            }
+        }
+
+        d->newlyMounted.clear();
+    }
+}
+
 void Smb4KMounter::mountShare(const SharePtr &share)
+{
+    queueMount(share);
+    startHelperJob();
+}
+
+void Smb4KMounter::mountShares(const QList<SharePtr> &shares)
+{
+    //
+    // Queue all shares first, so that they are passed to the helper
+    // together
+    //
+    for (const SharePtr &share : shares) {
+        queueMount(share);
+    }
+
+    startHelperJob();
+}
+
+void Smb4KMounter::queueMount(const SharePtr &share)
 {
     if (share) {
         //
@@ -430,227 +594,266 @@ void Smb4KMounter::mountShare(const SharePtr &share)
         }
 
         //
-        // Wake-On-LAN: Wake up the host before mounting
+        // Do not queue a share twice
+        //
+        for (const Smb4KPendingMount &pendingMount : std::as_const(d->pendingMounts)) {
+            if (pendingMount.share->hasSameUrl(share.data())) {
+                return;
+            }
+        }
+
+        for (const SharePtr &runningMount : std::as_const(d->runningMounts)) {
+            if (runningMount && runningMount->hasSameUrl(share.data())) {
+                return;
+            }
+        }
+
+        Smb4KPendingMount pendingMount;
+        //
+        // The share might be an item of a global list. Work on a copy, because
+        // the mountpoint and the credentials are set while it is prepared.
+        //
+        pendingMount.share = SharePtr(new Smb4KShare(*share));
+        pendingMount.waitForWakeUp = false;
+
+        //
+        // Prepare the share right away. This does not depend on the helper,
+        // so it is done while earlier mounts are still in flight.
+        //
+        if (!prepareMount(pendingMount.share, pendingMount.args)) {
+            return;
+        }
+
+        //
+        // Wake-On-LAN: Wake up the host before mounting. The share is only
+        // mounted after the host answered or the waiting time passed, but
+        // the other shares are processed in the meantime.
         //
         if (Smb4KSettings::enableWakeOnLAN()) {
             CustomSettingsPtr customSettings = Smb4KCustomSettingsManager::self()->findCustomSettings(share->url().resolved(QUrl(QStringLiteral(".."))));
 
             if (customSettings && customSettings->wakeOnLanSendBeforeMount()) {
-                Q_EMIT aboutToStart(WakeUp);
-
-                QUdpSocket *socket = new QUdpSocket(this);
-                QHostAddress addr;
-
                 // Use the host's IP address directly from the share object.
                 if (share->hasHostIpAddress()) {
-                    addr.setAddress(share->hostIpAddress());
-                } else {
-                    addr.setAddress(QStringLiteral("255.255.255.255"));
+                    pendingMount.wakeUpAddress.setAddress(share->hostIpAddress());
                 }
 
-                // Construct magic sequence
-                QByteArray sequence;
+                pendingMount.wakeUpMacAddress = customSettings->macAddress();
+                pendingMount.waitForWakeUp = true;
 
-                // 6 times 0xFF
-                for (int j = 0; j < 6; ++j) {
-                    sequence.append(QChar(0xFF).toLatin1());
+                if (!Smb4KWakeOnLan::self()->isWakingUp(pendingMount.wakeUpMacAddress, pendingMount.wakeUpAddress)) {
+                    d->wakingUpHosts << Smb4KWakeOnLan::wakeUpKey(pendingMount.wakeUpMacAddress, pendingMount.wakeUpAddress);
+                    Q_EMIT aboutToStart(WakeUp);
+                    Smb4KWakeOnLan::self()->wakeUp(pendingMount.wakeUpMacAddress, pendingMount.wakeUpAddress);
                 }
+            }
+        }
 
-                // 16 times the MAC address
-                QStringList parts = customSettings->macAddress().split(QStringLiteral(":"), Qt::SkipEmptyParts);
+        //
+        // Emit the aboutToStart() signal once for all shares that are
+        // mounted together
+        //
+        if (!d->mountsActive) {
+            d->mountsActive = true;
+            Q_EMIT aboutToStart(MountShare);
+        }
 
-                for (int j = 0; j < 16; ++j) {
-                    for (int k = 0; k < parts.size(); ++k) {
-                        QString item = QStringLiteral("0x") + parts.at(k);
-                        sequence.append(QChar(item.toInt(nullptr, 16)).toLatin1());
-                    }
-                }
+        d->pendingMounts << pendingMount;
+    }
+}
 
-                socket->writeDatagram(sequence, addr, 9);
+bool Smb4KMounter::prepareMount(const SharePtr &share, QVariantMap &args)
+{
+    //
+    // Create the mountpoint
+    //
+    QString mountpoint;
+    mountpoint += Smb4KMountSettings::mountPrefix().path();
+    mountpoint += QDir::separator();
+    mountpoint += (Smb4KMountSettings::forceLowerCaseSubdirs() ? share->hostName().toLower() : share->hostName());
+    mountpoint += QDir::separator();
 
-                delete socket;
+    if (!share->isHomesShare()) {
+        mountpoint += (Smb4KMountSettings::forceLowerCaseSubdirs() ? share->shareName().toLower() : share->shareName());
+    } else {
+        mountpoint += (Smb4KMountSettings::forceLowerCaseSubdirs() ? share->userName().toLower() : share->userName());
+    }
 
-                // Wait the defined time
-                int stop = 1000 * Smb4KSettings::wakeOnLANWaitingTime() / 250;
-                int i = 0;
+    // Get the permissions that should be used for creating the
+    // mount prefix and all its subdirectories.
+    // Please note that the actual permissions of the mount points
+    // are determined by the mount utility.
+    QFile::Permissions permissions;
+    QUrl parentDirectory;
 
-                while (i++ < stop) {
-                    wait(250);
-                }
+    if (QFile::exists(Smb4KMountSettings::mountPrefix().path())) {
+        parentDirectory = Smb4KMountSettings::mountPrefix();
+    } else {
+        QUrl u = Smb4KMountSettings::mountPrefix();
+        parentDirectory = u.resolved(QUrl(QStringLiteral("..")));
+    }
 
-                Q_EMIT finished(WakeUp);
-            }
-        }
+    QFile f(parentDirectory.path());
+    permissions = f.permissions();
 
-        //
-        // Create the mountpoint
-        //
-        QString mountpoint;
-        mountpoint += Smb4KMountSettings::mountPrefix().path();
-        mountpoint += QDir::separator();
-        mountpoint += (Smb4KMountSettings::forceLowerCaseSubdirs() ? share->hostName().toLower() : share->hostName());
-        mountpoint += QDir::separator();
-
-        if (!share->isHomesShare()) {
-            mountpoint += (Smb4KMountSettings::forceLowerCaseSubdirs() ? share->shareName().toLower() : share->shareName());
-        } else {
-            mountpoint += (Smb4KMountSettings::forceLowerCaseSubdirs() ? share->userName().toLower() : share->userName());
-        }
+    QDir dir(mountpoint);
 
-        // Get the permissions that should be used for creating the
-        // mount prefix and all its subdirectories.
-        // Please note that the actual permissions of the mount points
-        // are determined by the mount utility.
-        QFile::Permissions permissions;
-        QUrl parentDirectory;
+    if (!dir.mkpath(dir.path())) {
+        share->setPath(QStringLiteral(""));
+        Smb4KNotification::mkdirFailed(dir);
+        return false;
+    } else {
+        QUrl u = QUrl::fromLocalFile(dir.path());
 
-        if (QFile::exists(Smb4KMountSettings::mountPrefix().path())) {
-            parentDirectory = Smb4KMountSettings::mountPrefix();
-        } else {
-            QUrl u = Smb4KMountSettings::mountPrefix();
-            parentDirectory = u.resolved(QUrl(QStringLiteral("..")));
-            ;
+        while (!parentDirectory.matches(u, QUrl::StripTrailingSlash)) {
+            QFile(u.path()).setPermissions(permissions);
+            u = u.resolved(QUrl(QStringLiteral("..")));
         }
+    }
 
-        QFile f(parentDirectory.path());
-        permissions = f.permissions();
+    share->setPath(QDir::cleanPath(mountpoint));
 
-        QDir dir(mountpoint);
+    //
+    // Get the authentication information
+    //
+    Smb4KCredentialsManager::self()->readLoginCredentials(share);
 
-        if (!dir.mkpath(dir.path())) {
-            share->setPath(QStringLiteral(""));
-            Smb4KNotification::mkdirFailed(dir);
-            return;
-        } else {
-            QUrl u = QUrl::fromLocalFile(dir.path());
+    //
+    // Mount arguments
+    //
+    return fillMountActionArgs(share, args);
+}
 
-            while (!parentDirectory.matches(u, QUrl::StripTrailingSlash)) {
-                QFile(u.path()).setPermissions(permissions);
-                u = u.resolved(QUrl(QStringLiteral("..")));
-            }
-        }
+void Smb4KMounter::startHelperJob()
+{
+    //
+    // The helper only serves one action at a time. The shares that were
+    // queued in the meantime are processed with the next batch.
+    //
+    if (d->helperJob) {
+        return;
+    }
 
-        share->setPath(QDir::cleanPath(mountpoint));
+    //
+    // Unmount before mounting, because the shares might be remounted
+    // afterwards, e.g. when the profile changed
+    //
+    if (!d->pendingUnmounts.isEmpty()) {
+        startUnmounts();
+    } else {
+        startMounts();
+    }
 
-        //
-        // Get the authentication information
-        //
-        Smb4KCredentialsManager::self()->readLoginCredentials(share);
+    //
+    // Emit the finished() signal, when all shares were mounted
+    //
+    if (d->mountsActive && d->pendingMounts.isEmpty() && !d->helperJob) {
+        d->mountsActive = false;
+        Q_EMIT finished(MountShare);
+    }
+}
 
-        //
-        // Mount arguments
-        //
-        QVariantMap args;
+void Smb4KMounter::startMounts()
+{
+    QList<SharePtr> shares;
+    QVariantList sharesArgs;
 
-        if (!fillMountActionArgs(share, args)) {
-            return;
-        }
+    QMutableListIterator<Smb4KPendingMount> it(d->pendingMounts);
 
-        //
-        // Emit the aboutToStart() signal
-        //
-        Q_EMIT aboutToStart(MountShare);
+    while (it.hasNext()) {
+        Smb4KPendingMount &pendingMount = it.next();
 
         //
-        // Create the mount action
+        // Skip the shares whose hosts are still being woken up
         //
-        KAuth::Action mountAction(QStringLiteral("org.kde.smb4k.mounthelper.mount"));
-        mountAction.setHelperId(QStringLiteral("org.kde.smb4k.mounthelper"));
-        mountAction.setArguments(args);
-
-        KAuth::ExecuteJob *job = mountAction.execute();
+        if (pendingMount.waitForWakeUp) {
+            if (Smb4KWakeOnLan::self()->isWakingUp(pendingMount.wakeUpMacAddress, pendingMount.wakeUpAddress)) {
+                continue;
+            }
 
-        //
-        // Modify the cursor, if necessary.
-        //
-        if (!hasSubjobs()) {
-            QApplication::setOverrideCursor(Qt::BusyCursor);
+            pendingMount.waitForWakeUp = false;
         }
 
-        //
-        // Add the job
-        //
-        addSubjob(job);
+        shares << pendingMount.share;
+        sharesArgs << pendingMount.args;
+
+        it.remove();
+    }
 
+    if (!shares.isEmpty()) {
         //
-        // Start the job and process the returned result.
+        // Create the mount action. All shares that can be started now are
+        // mounted with one call of the helper, which runs up to the
+        // configured number of mount processes at the same time.
         //
-        bool success = job->exec();
-
-        if (success) {
-            int errorCode = job->error();
+        KAuth::Action mountAction;
+        mountAction.setHelperId(QStringLiteral("org.kde.smb4k.mounthelper"));
 
-            if (errorCode == 0) {
-                // Get the error message
-                QString errorMsg = job->data().value(QStringLiteral("mh_error_message")).toString();
+        mountAction.setName(QStringLiteral("org.kde.smb4k.mounthelper.mount"));
+        mountAction.setTimeout(helperTimeout(shares.size(), Smb4KMountSettings::maximumConcurrentMounts()));
 
-                if (!errorMsg.isEmpty()) {
-#if defined(Q_OS_LINUX)
-                    if (errorMsg.contains(QStringLiteral("mount error 13"))
-                        || errorMsg.contains(QStringLiteral("mount error(13)")) /* authentication error */) {
-                        d->retries << share;
-                        Q_EMIT requestCredentials(share);
-                    } else if (errorMsg.contains(QStringLiteral("Unable to find suitable address."))) {
-                        // Swallow this
-                    } else {
-                        Smb4KNotification::mountingFailed(share, errorMsg);
-                    }
-#elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
-                    if (errorMsg.contains(QStringLiteral("Authentication error")) || errorMsg.contains(QStringLiteral("Permission denied"))) {
-                        d->retries << share;
-                        Q_EMIT requestCredentials(share);
-                    } else {
-                        Smb4KNotification::mountingFailed(share, errorMsg);
-                    }
-#else
-                    qWarning() << "Smb4KMounter::slotMountJobFinished(): Error handling not implemented!";
-                    Smb4KNotification::mountingFailed(share, errorMsg);
-#endif
-                }
-            } else {
-                Smb4KNotification::actionFailed(errorCode);
-            }
+        if (shares.size() == 1) {
+            mountAction.setArguments(sharesArgs.first().toMap());
         } else {
-            // FIXME: Report that the action could not be started
+            QVariantMap args;
+            args.insert(QStringLiteral("mh_shares"), sharesArgs);
+            args.insert(QStringLiteral("mh_max_processes"), Smb4KMountSettings::maximumConcurrentMounts());
+
+            mountAction.setArguments(args);
         }
 
-        //
-        // Remove the job from the job list
-        //
-        removeSubjob(job);
+        KAuth::ExecuteJob *job = mountAction.execute();
 
         //
-        // Reset the busy cursor
+        // Modify the cursor, if necessary.
         //
         if (!hasSubjobs()) {
-            QApplication::restoreOverrideCursor();
+            QApplication::setOverrideCursor(Qt::BusyCursor);
         }
 
         //
-        // Emit the finished() signal
+        // Add the job and start it. The results are processed in
+        // slotMountJobData() and slotMountJobFinished().
         //
-        Q_EMIT finished(MountShare);
+        addSubjob(job);
+        d->helperJob = job;
+        d->runningMounts = shares;
+
+        connect(job, &KAuth::ExecuteJob::newData, this, &Smb4KMounter::slotMountJobData);
+        connect(job, &KJob::result, this, &Smb4KMounter::slotMountJobFinished);
+
+        job->start();
     }
 }
 
-void Smb4KMounter::mountShares(const QList<SharePtr> &shares)
+bool Smb4KMounter::processMountResult(const SharePtr &share, const QString &errorMsg)
 {
-    //
-    // This action takes longer
-    //
-    d->longActionRunning = true;
+    if (errorMsg.isEmpty()) {
+        return true;
+    }
 
-    //
-    // Mount the shares
-    //
-    for (const SharePtr &share : shares) {
-        mountShare(share);
+#if defined(Q_OS_LINUX)
+    if (errorMsg.contains(QStringLiteral("mount error 13")) || errorMsg.contains(QStringLiteral("mount error(13)")) /* authentication error */) {
+        d->retries << share;
+        Q_EMIT requestCredentials(share);
+    } else if (errorMsg.contains(QStringLiteral("Unable to find suitable address."))) {
+        // Swallow this
+    } else {
+        Smb4KNotification::mountingFailed(share, errorMsg);
     }
+#elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
+    if (errorMsg.contains(QStringLiteral("Authentication error")) || errorMsg.contains(QStringLiteral("Permission denied"))) {
+        d->retries << share;
+        Q_EMIT requestCredentials(share);
+    } else {
+        Smb4KNotification::mountingFailed(share, errorMsg);
+    }
+#else
+    qWarning() << "Smb4KMounter::processMountResult(): Error handling not implemented!";
+    Smb4KNotification::mountingFailed(share, errorMsg);
+#endif
 
-    //
-    // This action is over
-    //
-    d->longActionRunning = false;
+    return false;
 }
 
 void Smb4KMounter::unmountShare(const SharePtr &share, bool silent)
@@ -658,168 +861,173 @@ void Smb4KMounter::unmountShare(const SharePtr &share, bool silent)
     Q_ASSERT(share);
 
     if (share) {
-        //
-        // Check that the URL is valid.
-        //
-        if (!share->url().isValid()) {
-            Smb4KNotification::invalidURLPassed();
-            return;
-        }
-
-        //
-        // Handle foreign shares according to the settings
-        //
-        if (share->isForeign()) {
-            if (!Smb4KMountSettings::unmountForeignShares()) {
-                if (!silent) {
-                    Smb4KNotification::unmountingNotAllowed(share);
-                }
-
-                return;
-            } else {
-                if (!silent) {
-                    if (KMessageBox::warningTwoActions(QApplication::activeWindow(),
-                                                       i18n("<p>The share <b>%1</b> is mounted to <br><b>%2</b> and owned by user <b>%3</b>.</p>"
-                                                            "<p>Do you really want to unmount it?</p>",
-                                                            share->displayString(),
-                                                            share->path(),
-                                                            share->user().loginName()),
-                                                       i18n("Foreign Share"),
-                                                       KStandardGuiItem::ok(),
-                                                       KStandardGuiItem::cancel())
-                        == KMessageBox::SecondaryAction) {
-                        return;
-                    }
-                } else {
-                    // Without the confirmation of the user, we are not
-                    // unmounting a foreign share!
-                    return;
-                }
-            }
-        }
-
-        //
-        // Force the unmounting of the share either if the system went offline
-        // or if the user chose to forcibly unmount inaccessible shares (Linux only).
-        //
-        bool force = false;
-
-        if (Smb4KHardwareInterface::self()->isOnline()) {
-#if defined(Q_OS_LINUX)
-            if (share->isInaccessible()) {
-                force = Smb4KMountSettings::forceUnmountInaccessible();
-            }
-#endif
-        } else {
-            force = true;
-        }
-
-        //
-        // Unmount arguments
-        //
         QVariantMap args;
 
-        if (!fillUnmountActionArgs(share, force, silent, args)) {
+        if (!prepareUnmount(share, silent, args)) {
             return;
         }
 
-        //
-        // Emit the aboutToStart() signal
-        //
-        Q_EMIT aboutToStart(UnmountShare);
-
-        //
-        // Create the unmount action
-        //
-        KAuth::Action unmountAction(QStringLiteral("org.kde.smb4k.mounthelper.unmount"));
-        unmountAction.setHelperId(QStringLiteral("org.kde.smb4k.mounthelper"));
-        unmountAction.setArguments(args);
+        d->pendingUnmounts << Smb4KPendingUnmount{share, args};
+        startHelperJob();
+    }
+}
 
-        KAuth::ExecuteJob *job = unmountAction.execute();
+void Smb4KMounter::unmountShares(const QList<SharePtr> &shares, bool silent)
+{
+    //
+    // Queue the shares first, so that the list of shares is unmounted
+    // with one call of the helper
+    //
+    for (const SharePtr &share : shares) {
+        QVariantMap args;
 
-        //
-        // Modify the cursor, if necessary.
-        //
-        if (!hasSubjobs()) {
-            QApplication::setOverrideCursor(Qt::BusyCursor);
+        if (share && prepareUnmount(share, silent, args)) {
+            d->pendingUnmounts << Smb4KPendingUnmount{share, args};
         }
+    }
 
-        //
-        // Add the job
-        //
-        addSubjob(job);
-
-        //
-        // Start the job and process the returned result.
-        //
-        bool success = job->exec();
+    startHelperJob();
+}
 
-        if (success) {
-            int errorCode = job->error();
+bool Smb4KMounter::prepareUnmount(const SharePtr &share, bool silent, QVariantMap &args)
+{
+    //
+    // Check that the URL is valid.
+    //
+    if (!share->url().isValid()) {
+        Smb4KNotification::invalidURLPassed();
+        return false;
+    }
 
-            if (errorCode == 0) {
-                // Get the error message
-                QString errorMsg = job->data().value(QStringLiteral("mh_error_message")).toString();
+    //
+    // Handle foreign shares according to the settings
+    //
+    if (share->isForeign()) {
+        if (!Smb4KMountSettings::unmountForeignShares()) {
+            if (!silent) {
+                Smb4KNotification::unmountingNotAllowed(share);
+            }
 
-                if (!errorMsg.isEmpty()) {
-                    // No error handling needed, just report the error message.
-                    Smb4KNotification::unmountingFailed(share, errorMsg);
+            return false;
+        } else {
+            if (!silent) {
+                if (KMessageBox::warningTwoActions(QApplication::activeWindow(),
+                                                   i18n("<p>The share <b>%1</b> is mounted to <br><b>%2</b> and owned by user <b>%3</b>.</p>"
+                                                        "<p>Do you really want to unmount it?</p>",
+                                                        share->displayString(),
+                                                        share->path(),
+                                                        share->user().loginName()),
+                                                   i18n("Foreign Share"),
+                                                   KStandardGuiItem::ok(),
+                                                   KStandardGuiItem::cancel())
+                    == KMessageBox::SecondaryAction) {
+                    return false;
                 }
             } else {
-                Smb4KNotification::actionFailed(errorCode);
+                // Without the confirmation of the user, we are not
+                // unmounting a foreign share!
+                return false;
             }
-        } else {
-            // FIXME: Report that the action could not be started
         }
+    }
 
-        //
-        // Remove the job from the job list
-        //
-        removeSubjob(job);
+    //
+    // Force the unmounting of the share either if the system went offline
+    // or if the user chose to forcibly unmount inaccessible shares (Linux only).
+    //
+    bool force = false;
 
-        //
-        // Reset the busy cursor
-        //
-        if (!hasSubjobs()) {
-            QApplication::restoreOverrideCursor();
+    if (Smb4KHardwareInterface::self()->isOnline()) {
+#if defined(Q_OS_LINUX)
+        if (share->isInaccessible()) {
+            force = Smb4KMountSettings::forceUnmountInaccessible();
         }
-
-        //
-        // Emit the finished() signal
-        //
-        Q_EMIT finished(UnmountShare);
+#endif
+    } else {
+        force = true;
     }
+
+    //
+    // Unmount arguments
+    //
+    return fillUnmountActionArgs(share, force, silent, args);
 }
 
-void Smb4KMounter::unmountShares(const QList<SharePtr> &shares, bool silent)
+void Smb4KMounter::startUnmounts()
 {
+    QList<SharePtr> shares;
+    QVariantList sharesArgs;
+
+    while (!d->pendingUnmounts.isEmpty()) {
+        Smb4KPendingUnmount pendingUnmount = d->pendingUnmounts.takeFirst();
+        shares << pendingUnmount.share;
+        sharesArgs << pendingUnmount.args;
+    }
+
     //
-    // This action takes longer
+    // Emit the aboutToStart() signal
     //
-    d->longActionRunning = true;
+    Q_EMIT aboutToStart(UnmountShare);
 
     //
-    // Inhibit shutdown and sleep
+    // Inhibit shutdown and sleep until the shares were unmounted
     //
     Smb4KHardwareInterface::self()->inhibit();
 
     //
-    // Unmount the list of shares
+    // Create the unmount action. A list of shares is unmounted with one
+    // call of the helper, which runs the umount processes concurrently.
     //
-    for (const SharePtr &share : shares) {
-        // Unmount the share
-        unmountShare(share, silent);
+    KAuth::Action unmountAction;
+    unmountAction.setHelperId(QStringLiteral("org.kde.smb4k.mounthelper"));
+    unmountAction.setName(QStringLiteral("org.kde.smb4k.mounthelper.unmount"));
+    unmountAction.setTimeout(helperTimeout(shares.size(), shares.size()));
+
+    if (shares.size() == 1) {
+        unmountAction.setArguments(sharesArgs.first().toMap());
+    } else {
+        QVariantMap args;
+        args.insert(QStringLiteral("mh_shares"), sharesArgs);
+        args.insert(QStringLiteral("mh_max_processes"), shares.size());
+
+        unmountAction.setArguments(args);
     }
 
+    KAuth::ExecuteJob *job = unmountAction.execute();
+
     //
-    // Uninhibit shutdown and sleep
+    // Report the result of each share of a batch as soon as the helper
+    // sends it
     //
-    Smb4KHardwareInterface::self()->uninhibit();
+    connect(job, &KAuth::ExecuteJob::newData, this, [shares](const QVariantMap &data) {
+        int index = data.value(QStringLiteral("mh_index"), -1).toInt();
+        QString errorMsg = data.value(QStringLiteral("mh_error_message")).toString();
+
+        if (index >= 0 && index < shares.size() && !errorMsg.isEmpty()) {
+            // No error handling needed, just report the error message.
+            Smb4KNotification::unmountingFailed(shares.at(index), errorMsg);
+        }
+    });
+
+    connect(job, &KJob::result, this, [this, job, shares]() {
+        slotUnmountJobFinished(job, shares);
+    });
+
+    //
+    // Modify the cursor, if necessary.
+    //
+    if (!hasSubjobs()) {
+        QApplication::setOverrideCursor(Qt::BusyCursor);
+    }
 
     //
-    // This action is over
+    // Add the job and start it. The result is processed in
+    // slotUnmountJobFinished().
     //
-    d->longActionRunning = false;
+    addSubjob(job);
+    d->helperJob = job;
+
+    job->start();
 }
 
 void Smb4KMounter::unmountAllShares(bool silent)
@@ -839,7 +1047,9 @@ void Smb4KMounter::saveSharesForRemount()
     //
     // Save the shares for remount
     //
-    for (const SharePtr &share : mountedSharesList()) {
+    const QList<SharePtr> mountedShares = mountedSharesList();
+
+    for (const SharePtr &share : mountedShares) {
         if (!share->isForeign()) {
             Smb4KCustomSettingsManager::self()->addRemount(share, false);
         } else {
@@ -857,43 +1067,6 @@ void Smb4KMounter::saveSharesForRemount()
     }
 }
 
-void Smb4KMounter::timerEvent(QTimerEvent *event)
-{
-    Q_UNUSED(event);
-
-    if (!isRunning() && Smb4KHardwareInterface::self()->isOnline()) {
-        //
-        // Try to remount shares
-        //
-        if (d->remountAttempts < Smb4KMountSettings::remountAttempts() && d->firstImportDone) {
-            if (d->remountAttempts == 0) {
-                triggerRemounts(true);
-            }
-
-            if ((60000 * Smb4KMountSettings::remountInterval()) < d->remountTimeout) {
-                triggerRemounts(false);
-                d->remountTimeout = -TIMEOUT;
-            }
-
-            d->remountTimeout += TIMEOUT;
-        }
-
-        //
-        // Check the size, accessibility, etc. of the shares
-        //
-        if (d->checkTimeout >= 2500 && d->importedShares.isEmpty()) {
-            for (const SharePtr &share : mountedSharesList()) {
-                check(share);
-                Q_EMIT updated(share);
-            }
-
-            d->checkTimeout = 0;
-        } else {
-            d->checkTimeout += TIMEOUT;
-        }
-    }
-}
-
 #if defined(Q_OS_LINUX)
 //
 // Linux arguments
@@ -1639,38 +1812,6 @@ bool Smb4KMounter::fillUnmountActionArgs(const SharePtr &, bool, bool, QVariantM
 }
 #endif
 
-void Smb4KMounter::check(const SharePtr &share)
-{
-    d->storageInfo.setPath(share->path());
-
-    if (d->storageInfo.isValid() && d->storageInfo.isReady()) {
-        // Accessibility
-        share->setInaccessible(false);
-
-        // Size information
-        share->setFreeDiskSpace(d->storageInfo.bytesAvailable()); // Bytes available to the user, might be less that bytesFree()
-        share->setTotalDiskSpace(d->storageInfo.bytesTotal());
-
-        // Get the owner an group, if possible.
-        QFileInfo fileInfo(share->path());
-        fileInfo.setCaching(false);
-
-        if (fileInfo.exists()) {
-            share->setUser(KUser(static_cast<K_UID>(fileInfo.ownerId())));
-            share->setGroup(KUserGroup(static_cast<K_GID>(fileInfo.groupId())));
-        } else {
-            share->setUser(KUser(KUser::UseRealUserID));
-            share->setGroup(KUserGroup(KUser::UseRealUserID));
-        }
-    } else {
-        share->setInaccessible(true);
-        share->setFreeDiskSpace(0);
-        share->setTotalDiskSpace(0);
-        share->setUser(KUser(KUser::UseRealUserID));
-        share->setGroup(KUserGroup(KUser::UseRealUserID));
-    }
-}
-
 /////////////////////////////////////////////////////////////////////////////
 // SLOT IMPLEMENTATIONS
 /////////////////////////////////////////////////////////////////////////////
@@ -1685,11 +1826,14 @@ void Smb4KMounter::slotStartJobs()
     }
 
     //
-    // Start the timer
+    // Schedule the remounts
     //
-    if (d->timerId == -1) {
-        d->timerId = startTimer(TIMEOUT);
-    }
+    scheduleRemounts();
+
+    //
+    // Start checking the mounted shares
+    //
+    d->shareChecker->start();
 }
 
 void Smb4KMounter::slotAboutToQuit()
@@ -1699,6 +1843,11 @@ void Smb4KMounter::slotAboutToQuit()
     //
     abort();
 
+    //
+    // Stop checking the mounted shares
+    //
+    d->shareChecker->stop();
+
     //
     // Check if the user wants to remount shares and save the
     // shares for remount if so.
@@ -1712,6 +1861,16 @@ void Smb4KMounter::slotAboutToQuit()
     //
     if (Smb4KMountSettings::unmountSharesOnExit()) {
         unmountAllShares(true);
+
+        //
+        // The application quits right after this function returned, so
+        // wait until the helper unmounted the shares.
+        //
+        if (d->helperJob) {
+            QEventLoop loop;
+            connect(d->helperJob, &KJob::result, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
     }
 
     //
@@ -1763,14 +1922,19 @@ void Smb4KMounter::slotOnlineStateChanged(bool online)
         saveSharesForRemount();
 
         // FIXME: Do we need this at all?
-        for (const SharePtr &share : mountedSharesList()) {
-            share->setInaccessible(true);
+        const QList<SharePtr> mountedShares = mountedSharesList();
+
+        for (const SharePtr &share : mountedShares) {
+            modifyMountedShare(share, [](Smb4KShare *mountedShare) {
+                mountedShare->setInaccessible(true);
+                return static_cast<int>(MountDataField);
+            });
         }
 
         unmountAllShares(true);
 
         d->remountAttempts = 0;
-        d->remountTimeout = 0;
+        d->remountTimer.stop();
     }
 }
 
@@ -1785,8 +1949,8 @@ void Smb4KMounter::slotActiveProfileChanged(const QString &newProfile)
 {
     Q_UNUSED(newProfile);
 
-    // Stop the timer.
-    killTimer(d->timerId);
+    // Stop the remounts.
+    d->remountTimer.stop();
 
     abort();
 
@@ -1805,16 +1969,250 @@ void Smb4KMounter::slotActiveProfileChanged(const QString &newProfile)
 
     // Reset some variables.
     // Don't touch d->firstImportDone here, because that remains true
-    d->remountTimeout = 0;
     d->remountAttempts = 0;
 
-    // Restart the timer
-    d->timerId = startTimer(TIMEOUT);
+    // Schedule the remounts of the new profile
+    scheduleRemounts();
+}
+
+void Smb4KMounter::slotMountJobData(const QVariantMap &data)
+{
+    //
+    // The helper reports the result of each share of a batch as soon as
+    // it is available. The next batch is started when the whole batch
+    // finished, because the helper is busy until then.
+    //
+    int index = data.value(QStringLiteral("mh_index"), -1).toInt();
+
+    if (index < 0 || index >= d->runningMounts.size() || !d->runningMounts.at(index)) {
+        return;
+    }
+
+    SharePtr share = d->runningMounts.at(index);
+    d->runningMounts[index].clear();
+
+    bool success = false;
+
+    if (!data.value(QStringLiteral("mh_process_failed")).toBool()) {
+        success = processMountResult(share, data.value(QStringLiteral("mh_error_message")).toString());
+    }
+
+    //
+    // Import the share right away, so that the mounted() signal is
+    // emitted for each share as soon as it was mounted. This is not
+    // necessary, if the mount table is watched.
+    //
+    if (success && Smb4KHardwareInterface::self()->isOnline() && !d->mountWatcher->isWatching()) {
+        import(false);
+    }
+}
+
+void Smb4KMounter::slotMountJobFinished(KJob *job)
+{
+    QList<SharePtr> shares = d->runningMounts;
+    d->runningMounts.clear();
+    d->helperJob = nullptr;
+
+    KAuth::ExecuteJob *mountJob = qobject_cast<KAuth::ExecuteJob *>(job);
+
+    bool success = false;
+
+    if (mountJob) {
+        int errorCode = mountJob->error();
+
+        if (errorCode == 0) {
+            //
+            // The result of a single share is returned with the reply
+            //
+            if (shares.size() == 1 && shares.first()) {
+                success = processMountResult(shares.first(), mountJob->data().value(QStringLiteral("mh_error_message")).toString());
+            }
+        } else if (errorCode != KJob::KilledJobError) {
+            Smb4KNotification::actionFailed(errorCode);
+        }
+    }
+
+    //
+    // Remove the job from the job list
+    //
+    removeSubjob(job);
+
+    //
+    // Reset the busy cursor
+    //
+    if (!hasSubjobs()) {
+        QApplication::restoreOverrideCursor();
+    }
+
+    //
+    // Start the next job
+    //
+    startHelperJob();
+
+    //
+    // Import the share right away, so that the mounted() signal is
+    // emitted for each share as soon as it was mounted. After the last
+    // mount, this also shows the notification.
+    //
+    // If the mount table is watched, the shares were or will be imported
+    // when the mount table changed. Only show the pending notifications then.
+    //
+    if ((success || !isRunning()) && Smb4KHardwareInterface::self()->isOnline()) {
+        if (d->mountWatcher->isWatching()) {
+            importChanges(QList<Smb4KMountEntry>(), QStringList());
+        } else {
+            import(false);
+        }
+    }
+}
+
+void Smb4KMounter::slotUnmountJobFinished(KJob *job, const QList<SharePtr> &shares)
+{
+    d->helperJob = nullptr;
+
+    KAuth::ExecuteJob *unmountJob = qobject_cast<KAuth::ExecuteJob *>(job);
+
+    if (unmountJob) {
+        int errorCode = unmountJob->error();
+
+        if (errorCode == 0) {
+            //
+            // The result of a single share is returned with the reply
+            //
+            if (shares.size() == 1) {
+                QString errorMsg = unmountJob->data().value(QStringLiteral("mh_error_message")).toString();
+
+                if (!errorMsg.isEmpty()) {
+                    // No error handling needed, just report the error message.
+                    Smb4KNotification::unmountingFailed(shares.first(), errorMsg);
+                }
+            }
+        } else if (errorCode != KJob::KilledJobError) {
+            Smb4KNotification::actionFailed(errorCode);
+        }
+    }
+
+    //
+    // Remove the job from the job list
+    //
+    removeSubjob(job);
+
+    //
+    // Reset the busy cursor
+    //
+    if (!hasSubjobs()) {
+        QApplication::restoreOverrideCursor();
+    }
+
+    //
+    // Uninhibit shutdown and sleep
+    //
+    Smb4KHardwareInterface::self()->uninhibit();
+
+    //
+    // Shares that were removed from the watched mount table while the
+    // job was running have not been reported yet. Do it now.
+    //
+    if (d->mountWatcher->isWatching()) {
+        importChanges(QList<Smb4KMountEntry>(), QStringList());
+    }
+
+    //
+    // Emit the finished() signal
+    //
+    Q_EMIT finished(UnmountShare);
+
+    //
+    // Start the next job
+    //
+    startHelperJob();
+}
+
+void Smb4KMounter::slotHostWokenUp(const QString &key, bool awake)
+{
+    Q_UNUSED(awake);
+
+    //
+    // Mount the shares of the host. If it did not answer in time, mounting
+    // is tried nonetheless, like it was done before the host was probed.
+    //
+    if (d->wakingUpHosts.remove(key)) {
+        Q_EMIT finished(WakeUp);
+    }
+
+    startHelperJob();
+}
+
+void Smb4KMounter::slotMountsChanged(const QList<Smb4KMountEntry> &added, const QList<Smb4KMountEntry> &removed)
+{
+    if (!d->importedShares.isEmpty()) {
+        return;
+    }
+
+    QList<Smb4KMountEntry> addedEntries;
+    QStringList removedMountPoints;
+
+    for (const Smb4KMountEntry &entry : removed) {
+        removedMountPoints << entry.mountPoint;
+    }
+
+    //
+    // A share that was mounted over the mountpoint of a removed one
+    // is reported as added. Only skip shares that are still known.
+    //
+    for (const Smb4KMountEntry &entry : added) {
+        if ((!findShareByPath(entry.mountPoint) && !findUnclassifiedShare(entry.mountPoint)) || removedMountPoints.contains(entry.mountPoint)) {
+            addedEntries << entry;
+        }
+    }
+
+    importChanges(addedEntries, removedMountPoints);
+}
+
+void Smb4KMounter::slotShareChecked(const SharePtr &share)
+{
+    //
+    // Classify a newly imported share with the owner reported by its
+    // first check
+    //
+    if (d->unclassifiedShares.removeOne(share)) {
+        if (share->path().startsWith(Smb4KMountSettings::mountPrefix().path())
+            || (!share->isInaccessible() && share->canonicalPath().startsWith(QDir(Smb4KMountSettings::mountPrefix().path()).canonicalPath()))) {
+            share->setForeign(false);
+        } else if (share->path().startsWith(QDir::homePath())
+                   || (!share->isInaccessible() && share->canonicalPath().startsWith(QDir::home().canonicalPath()))) {
+            share->setForeign(false);
+        } else if (share->user().userId() == KUser(KUser::UseRealUserID).userId()
+                   && share->group().groupId() == KUserGroup(KUser::UseRealUserID).groupId()) {
+            share->setForeign(false);
+        } else {
+            share->setForeign(true);
+        }
+
+        if (addImportedShare(share)) {
+            notifyMounted();
+            Q_EMIT mountedSharesListChanged();
+        } else {
+            d->shareChecker->removeShare(share);
+        }
+
+        if (!d->firstImportDone && d->importedShares.isEmpty() && d->unclassifiedShares.isEmpty()) {
+            d->firstImportDone = true;
+            scheduleRemounts();
+        }
+
+        return;
+    }
+
+    if (findShareByPath(share->path()) == share) {
+        updateMountedShare(share);
+        Q_EMIT updated(share);
+    }
 }
 
 void Smb4KMounter::slotTriggerImport()
 {
-    QTimer::singleShot(2 * TIMEOUT, this, [&]() {
+    QTimer::singleShot(IMPORT_DELAY, this, [&]() {
         import(true);
     });
 }
@@ -1825,22 +2223,44 @@ void Smb4KMounter::slotConfigChanged()
         import(true);
         d->detectAllShares = Smb4KMountSettings::detectAllShares();
     }
+
+    //
+    // The number of remount attempts might have changed
+    //
+    scheduleRemounts();
+}
+
+void Smb4KMounter::slotRemountTimeout()
+{
+    //
+    // Do not interfere with running jobs. Try again shortly, because not
+    // every job that keeps the mounter busy reports that it finished.
+    //
+    if (isRunning()) {
+        d->remountTimer.start(REMOUNT_RETRY_DELAY);
+        return;
+    }
+
+    //
+    // The remounts are rescheduled when the system is online again
+    //
+    if (!Smb4KHardwareInterface::self()->isOnline()) {
+        return;
+    }
+
+    triggerRemounts(d->remountAttempts == 0);
+    scheduleRemounts();
 }
 
 void Smb4KMounter::slotCredentialsUpdated(const QUrl &url)
 {
     if (!url.isEmpty() && !d->retries.isEmpty()) {
+        QString urlKey = Smb4KBasicNetworkItem::keyForUrl(url);
+
         for (int i = 0; i < d->retries.size(); i++) {
             QUrl parentUrl = d->retries[i]->url().resolved(QUrl(QStringLiteral(".."))).adjusted(QUrl::StripTrailingSlash);
 
-            if (QString::compare(d->retries[i]->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                    == 0
-                || QString::compare(parentUrl.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                    url.toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                    Qt::CaseInsensitive)
-                    == 0) {
+            if (d->retries[i]->key() == urlKey || Smb4KBasicNetworkItem::keyForUrl(parentUrl) == urlKey) {
                 SharePtr share = d->retries.takeAt(i);
                 share->setUserName(url.userName());
                 share->setPassword(url.password());
@@ -11,9 +11,11 @@
 // application specific includes
 #include "smb4kcore_export.h"
 #include "smb4kglobal.h"
+#include "smb4kmountwatcher.h"
 
 // Qt includes
 #include <QFile>
+#include <QHostAddress>
 #include <QMap>
 #include <QObject>
 #include <QScopedPointer>
@@ -68,14 +70,20 @@ public:
     void abort();
 
     /**
-     * This function attempts to mount a share.
+     * This function attempts to mount a share. The share is prepared and
+     * queued right away and mounted asynchronously. The queued shares are
+     * passed to the helper in batches, one batch at a time. Within a batch,
+     * the helper mounts up to Smb4KMountSettings::maximumConcurrentMounts()
+     * shares at the same time. The mounted() signal is emitted as soon as
+     * the share was mounted.
      *
      * @param share       The Smb4KShare object that is representing the share.
      */
     void mountShare(const SharePtr &share);
 
     /**
-     * Mounts a list of shares at once.
+     * Mounts a list of shares at once. All shares are queued first and
+     * passed to the helper together.
      *
      * @param shares      The list of shares
      */
@@ -83,7 +91,8 @@ public:
 
     /**
      * This function attempts to unmount a share. With the parameter @p silent you
-     * can suppress any error messages.
+     * can suppress any error messages. The share is queued and unmounted
+     * asynchronously.
      *
      * @param share       The share object that should be unmounted.
      *
@@ -94,7 +103,8 @@ public:
 
     /**
      * This function attempts to unmount a list of shares. With the parameter @p silent
-     * you can suppress any error messages.
+     * you can suppress any error messages. All shares are unmounted with one call of
+     * the mount helper.
      *
      * @param shares      The list of shares that is to be unmounted
      *
@@ -178,14 +188,6 @@ Q_SIGNALS:
      */
     void requestCredentials(const SharePtr &share);
 
-protected:
-    /**
-     * Reimplemented from QObject to process the queue.
-     *
-     * @param event             The QTimerEvent event
-     */
-    void timerEvent(QTimerEvent *event) override;
-
 protected Q_SLOTS:
     /**
      * Starts the composite job
@@ -236,6 +238,58 @@ protected Q_SLOTS:
      */
     void slotCredentialsUpdated(const QUrl &url);
 
+    /**
+     * Called when a mount job finished
+     *
+     * @param job       The mount job
+     */
+    void slotMountJobFinished(KJob *job);
+
+    /**
+     * Called when an unmount job finished
+     *
+     * @param job       The unmount job
+     * @param shares    The shares that were unmounted by the job
+     */
+    void slotUnmountJobFinished(KJob *job, const QList<SharePtr> &shares);
+
+    /**
+     * Called when the helper reported the result of a share that
+     * was mounted as part of a list of shares
+     *
+     * @param data      The result of the share
+     */
+    void slotMountJobData(const QVariantMap &data);
+
+    /**
+     * Called when the wake-up of a host finished
+     *
+     * @param key       The key of the wake-up
+     * @param awake     TRUE if the host answered in time
+     */
+    void slotHostWokenUp(const QString &key, bool awake);
+
+    /**
+     * Called when SMBFS or CIFS shares were added to or removed from
+     * the watched mount table
+     *
+     * @param added     The added mount table entries
+     * @param removed   The removed mount table entries
+     */
+    void slotMountsChanged(const QList<Smb4KMountEntry> &added, const QList<Smb4KMountEntry> &removed);
+
+    /**
+     * Called when a mounted share was checked
+     *
+     * @param share     The share
+     */
+    void slotShareChecked(const SharePtr &share);
+
+    /**
+     * Called when the next remount attempt is due
+     */
+    void slotRemountTimeout();
+
 private:
     /**
      * Trigger the remounting of shares. If the parameter @p fill_list is
@@ -248,15 +302,77 @@ private:
     void triggerRemounts(bool fill_list);
 
     /**
-     * Imports mounted shares.
+     * Arm the remount timer for the next remount attempt. The timer is stopped
+     * if no further attempts are to be made.
+     */
+    void scheduleRemounts();
+
+    /**
+     * Imports mounted shares. The mount table is compared to the list of
+     * mounted shares and the differences are passed to importChanges().
      */
     void import(bool checkInaccessible);
 
+    /**
+     * Add the shares of the @p added mount table entries to the list of
+     * mounted shares and remove the shares mounted at the @p removed
+     * mountpoints from it. Pending notifications are shown, if no job
+     * is running.
+     *
+     * @param added     The added mount table entries
+     * @param removed   The removed mountpoints
+     */
+    void importChanges(const QList<Smb4KMountEntry> &added, const QStringList &removed);
+
     /**
      * Save all shares that need to be remounted.
      */
     void saveSharesForRemount();
 
+    /**
+     * Create the mountpoint, read the credentials and fill the mount action
+     * arguments of the share into a map.
+     */
+    bool prepareMount(const SharePtr &share, QVariantMap &args);
+
+    /**
+     * Check the share and queue it for mounting.
+     */
+    void queueMount(const SharePtr &share);
+
+    /**
+     * Start the next helper job, unless one is already running. The helper
+     * only serves one action at a time, so the shares queued while a job is
+     * running are processed with the next batch. Queued unmounts are started
+     * before queued mounts.
+     */
+    void startHelperJob();
+
+    /**
+     * Pass all queued shares to the helper at once. Only called by
+     * startHelperJob().
+     */
+    void startMounts();
+
+    /**
+     * Process the error message the helper returned for a mounted share.
+     *
+     * @returns TRUE if the share was mounted successfully.
+     */
+    bool processMountResult(const SharePtr &share, const QString &errorMsg);
+
+    /**
+     * Check if the share may be unmounted and fill the unmount action
+     * arguments into a map.
+     */
+    bool prepareUnmount(const SharePtr &share, bool silent, QVariantMap &args);
+
+    /**
+     * Unmount all queued shares with one call of the helper. Only called
+     * by startHelperJob().
+     */
+    void startUnmounts();
+
     /**
      * Fill the mount action arguments into a map.
      */
@@ -268,9 +384,24 @@ private:
     bool fillUnmountActionArgs(const SharePtr &share, bool force, bool silent, QVariantMap &unmountArgs);
 
     /**
-     * Check the size, accessibility, ids, etc. of the share(s)
+     * Add a classified imported share to the list of mounted shares. Foreign
+     * shares are only added, if all shares are to be detected.
+     *
+     * @returns TRUE if the share was added.
+     */
+    bool addImportedShare(const SharePtr &share);
+
+    /**
+     * Find the imported share mounted at @p path that waits for its first
+     * check to be classified.
+     */
+    SharePtr findUnclassifiedShare(const QString &path) const;
+
+    /**
+     * Show the notification for the newly mounted shares, if no job is
+     * running.
      */
-    void check(const SharePtr &share);
+    void notifyMounted();
 
     /**
      * Pointer to the Smb4KMounterPrivate class.
@@ -0,0 +1,212 @@
+/*
+    Watch the mount table for mounted and unmounted shares
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kmountwatcher.h"
+
+// Qt includes
+#include <QFile>
+#include <QHash>
+#include <QSocketNotifier>
+#include <QStringList>
+
+// KDE includes
+#include <KMountPoint>
+
+class Smb4KMountWatcherPrivate
+{
+public:
+    QFile mountInfo;
+    QSocketNotifier *notifier;
+    QHash<int, Smb4KMountEntry> entries;
+};
+
+//
+// Whether the file system is one of the file systems used for
+// SMB shares
+//
+static bool isSmbFileSystem(const QString &fileSystem)
+{
+    return (fileSystem == QStringLiteral("cifs") || fileSystem == QStringLiteral("smb3") || fileSystem == QStringLiteral("smbfs"));
+}
+
+//
+// Parse the options Smb4K needs
+//
+static void parseMountOptions(const QStringList &options, Smb4KMountEntry &entry)
+{
+    for (const QString &option : options) {
+        if (option.startsWith(QStringLiteral("domain=")) || option.startsWith(QStringLiteral("workgroup="))) {
+            entry.workgroupName = option.section(QStringLiteral("="), 1, 1).trimmed();
+        } else if (option.startsWith(QStringLiteral("addr="))) {
+            entry.ipAddress = option.section(QStringLiteral("="), 1, 1).trimmed();
+        } else if (option.startsWith(QStringLiteral("username=")) || option.startsWith(QStringLiteral("user="))) {
+            entry.userName = option.section(QStringLiteral("="), 1, 1).trimmed();
+        }
+    }
+}
+
+//
+// The kernel escapes space, tab, newline and backslash in the mount
+// table as octal sequences
+//
+static QString unescape(const QByteArray &field)
+{
+    if (!field.contains('\\')) {
+        return QString::fromUtf8(field);
+    }
+
+    QByteArray result;
+    result.reserve(field.size());
+
+    for (int i = 0; i < field.size(); i++) {
+        if (field.at(i) == '\\' && i + 3 < field.size()) {
+            bool ok = false;
+            int character = field.mid(i + 1, 3).toInt(&ok, 8);
+
+            if (ok) {
+                result.append(static_cast<char>(character));
+                i += 3;
+                continue;
+            }
+        }
+
+        result.append(field.at(i));
+    }
+
+    return QString::fromUtf8(result);
+}
+
+//
+// Parse /proc/self/mountinfo. The lines have the format
+//
+// ID PARENT-ID MAJOR:MINOR ROOT MOUNTPOINT OPTIONS [OPTIONAL FIELDS] - TYPE SOURCE SUPER-OPTIONS
+//
+static QHash<int, Smb4KMountEntry> parseMountInfo(const QByteArray &data)
+{
+    QHash<int, Smb4KMountEntry> entries;
+    const QList<QByteArray> lines = data.split('\n');
+
+    for (const QByteArray &line : lines) {
+        int separator = line.indexOf(" - ");
+
+        if (separator == -1) {
+            continue;
+        }
+
+        const QList<QByteArray> tail = line.mid(separator + 3).split(' ');
+
+        if (tail.size() < 3 || !isSmbFileSystem(QString::fromLatin1(tail.at(0)))) {
+            continue;
+        }
+
+        const QList<QByteArray> head = line.left(separator).split(' ');
+
+        if (head.size() < 6) {
+            continue;
+        }
+
+        Smb4KMountEntry entry;
+        entry.mountId = head.at(0).toInt();
+        entry.mountPoint = unescape(head.at(4));
+        entry.fileSystem = QString::fromLatin1(tail.at(0));
+        entry.mountedFrom = unescape(tail.at(1));
+
+        QStringList options = QString::fromUtf8(head.at(5)).split(QStringLiteral(","), Qt::SkipEmptyParts);
+        options << QString::fromUtf8(tail.at(2)).split(QStringLiteral(","), Qt::SkipEmptyParts);
+
+        parseMountOptions(options, entry);
+
+        entries.insert(entry.mountId, entry);
+    }
+
+    return entries;
+}
+
+Smb4KMountWatcher::Smb4KMountWatcher(QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KMountWatcherPrivate)
+{
+    d->notifier = nullptr;
+
+#if defined(Q_OS_LINUX)
+    //
+    // The kernel signals a change of the mount table with POLLPRI. The
+    // file has to be read again to receive the next change.
+    //
+    d->mountInfo.setFileName(QStringLiteral("/proc/self/mountinfo"));
+
+    if (d->mountInfo.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        d->entries = parseMountInfo(d->mountInfo.readAll());
+
+        d->notifier = new QSocketNotifier(d->mountInfo.handle(), QSocketNotifier::Exception, this);
+        connect(d->notifier, &QSocketNotifier::activated, this, &Smb4KMountWatcher::slotMountTableChanged);
+    }
+#endif
+}
+
+Smb4KMountWatcher::~Smb4KMountWatcher()
+{
+}
+
+bool Smb4KMountWatcher::isWatching() const
+{
+    return d->notifier != nullptr;
+}
+
+QList<Smb4KMountEntry> Smb4KMountWatcher::entries() const
+{
+    if (isWatching()) {
+        return d->entries.values();
+    }
+
+    QList<Smb4KMountEntry> entries;
+    KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::BasicInfoNeeded | KMountPoint::NeedMountOptions);
+
+    for (const QExplicitlySharedDataPointer<KMountPoint> &mountPoint : std::as_const(mountPoints)) {
+        if (!mountPoint->isOnNetwork() || !isSmbFileSystem(mountPoint->mountType())) {
+            continue;
+        }
+
+        Smb4KMountEntry entry;
+        entry.mountPoint = mountPoint->mountPoint();
+        entry.mountedFrom = mountPoint->mountedFrom();
+        entry.fileSystem = mountPoint->mountType();
+
+        parseMountOptions(mountPoint->mountOptions(), entry);
+
+        entries << entry;
+    }
+
+    return entries;
+}
+
+void Smb4KMountWatcher::slotMountTableChanged()
+{
+    d->mountInfo.seek(0);
+
+    QHash<int, Smb4KMountEntry> entries = parseMountInfo(d->mountInfo.readAll());
+    QList<Smb4KMountEntry> added, removed;
+
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        if (!d->entries.contains(it.key())) {
+            added << it.value();
+        }
+    }
+
+    for (auto it = d->entries.cbegin(); it != d->entries.cend(); ++it) {
+        if (!entries.contains(it.key())) {
+            removed << it.value();
+        }
+    }
+
+    d->entries = entries;
+
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        Q_EMIT mountsChanged(added, removed);
+    }
+}
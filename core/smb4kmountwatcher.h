@@ -0,0 +1,99 @@
+/*
+    Watch the mount table for mounted and unmounted shares
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KMOUNTWATCHER_H
+#define SMB4KMOUNTWATCHER_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+
+// Qt includes
+#include <QList>
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+class Smb4KMountWatcherPrivate;
+
+/**
+ * A share in the mount table. The mount options that Smb4K needs are
+ * parsed when the mount table is read.
+ */
+struct Smb4KMountEntry {
+    /**
+     * The mount ID. It is -1 if the operating system does not provide it.
+     */
+    int mountId = -1;
+    QString mountPoint;
+    QString mountedFrom;
+    QString fileSystem;
+    QString workgroupName;
+    QString ipAddress;
+    QString userName;
+};
+
+/**
+ * This class reads the SMBFS and CIFS entries of the mount table. On Linux,
+ * it waits for changes of /proc/self/mountinfo and reports the entries that
+ * were added or removed, keyed by their mount ID. On other systems, only
+ * the mount table can be read and the mountsChanged() signal is never
+ * emitted.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.0.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KMountWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The constructor
+     */
+    explicit Smb4KMountWatcher(QObject *parent = nullptr);
+
+    /**
+     * The destructor
+     */
+    ~Smb4KMountWatcher();
+
+    /**
+     * Returns TRUE if the mount table is watched and changes are reported
+     * with the mountsChanged() signal.
+     *
+     * @returns TRUE if the mount table is watched.
+     */
+    bool isWatching() const;
+
+    /**
+     * Returns the SMBFS and CIFS entries of the mount table. If the mount table
+     * is watched, the entries are returned from the last read, otherwise the
+     * mount table is read.
+     *
+     * @returns the entries of the mount table
+     */
+    QList<Smb4KMountEntry> entries() const;
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when SMBFS or CIFS entries were added to or
+     * removed from the mount table.
+     *
+     * @param added         The added entries
+     * @param removed       The removed entries
+     */
+    void mountsChanged(const QList<Smb4KMountEntry> &added, const QList<Smb4KMountEntry> &removed);
+
+protected Q_SLOTS:
+    void slotMountTableChanged();
+
+private:
+    const QScopedPointer<Smb4KMountWatcherPrivate> d;
+};
+
+#endif
@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a share.
 
-    SPDX-FileCopyrightText: 2008-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2008-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -13,57 +13,103 @@
 #include <QUrl>
 
 // KDE includes
-#include "kiconthemes_version.h"
 #include <KIO/Global>
-#include <KIconLoader>
 #include <KLocalizedString>
 #include <KMountPoint>
 
+// std includes
+#include <memory>
+
 using namespace Smb4KGlobal;
 
+//
+// The data that is only meaningful for mounted shares. Most shares are
+// browse results that are never mounted, so it is only allocated when
+// it is needed.
+//
+class Smb4KShareMountData
+{
+public:
+    QString path;
+    QString canonicalPath;
+    QString filesystem;
+    KUser user = KUser(KUser::UseRealUserID);
+    KUserGroup group = KUserGroup(KUser::UseRealUserID);
+    qint64 totalSpace = -1;
+    qint64 freeSpace = -1;
+};
+
 class Smb4KSharePrivate
 {
 public:
+    Smb4KSharePrivate()
+        : shareType(FileShare)
+        , mounted(false)
+        , inaccessible(false)
+        , foreign(false)
+        , derivedValid(false)
+        , hidden(false)
+        , homes(false)
+    {
+    }
+
+    Smb4KSharePrivate(const Smb4KSharePrivate &other)
+    {
+        *this = other;
+    }
+
+    Smb4KSharePrivate &operator=(const Smb4KSharePrivate &other)
+    {
+        workgroup = other.workgroup;
+        ip = other.ip;
+        mount.reset(other.mount ? new Smb4KShareMountData(*other.mount) : nullptr);
+        shareType = other.shareType;
+        mounted = other.mounted;
+        inaccessible = other.inaccessible;
+        foreign = other.foreign;
+        shareName = other.shareName;
+        hostName = other.hostName;
+        displayString = other.displayString;
+        homesDisplayString = other.homesDisplayString;
+        derivedValid = other.derivedValid;
+        hidden = other.hidden;
+        homes = other.homes;
+        return *this;
+    }
+
+    Smb4KShareMountData *mountData()
+    {
+        if (!mount) {
+            mount.reset(new Smb4KShareMountData);
+        }
+
+        return mount.get();
+    }
+
     QString workgroup;
     QHostAddress ip;
-    QString path;
-    bool inaccessible;
-    bool foreign;
-    KUser user;
-    KUserGroup group;
-    qint64 totalSpace;
-    qint64 freeSpace;
-    bool mounted;
-    QString filesystem;
+    std::unique_ptr<Smb4KShareMountData> mount;
+    mutable QString shareName;
+    mutable QString hostName;
+    mutable QString displayString;
+    mutable QString homesDisplayString;
     Smb4KGlobal::ShareType shareType;
+    bool mounted : 1;
+    bool inaccessible : 1;
+    bool foreign : 1;
+    mutable bool derivedValid;
+    mutable bool hidden;
+    mutable bool homes;
 };
 
 Smb4KShare::Smb4KShare(const QUrl &url)
     : Smb4KBasicNetworkItem(Share)
     , d(new Smb4KSharePrivate)
 {
-    //
-    // Set the private variables
-    //
-    d->inaccessible = false;
-    d->foreign = false;
-    d->filesystem = QString();
-    d->user = KUser(KUser::UseRealUserID);
-    d->group = KUserGroup(KUser::UseRealUserID);
-    d->totalSpace = -1;
-    d->freeSpace = -1;
-    d->mounted = false;
-    d->shareType = FileShare;
-
     //
     // Set the URL
     //
     *pUrl = url;
-
-    //
-    // Set the icon
-    //
-    setShareIcon();
 }
 
 Smb4KShare::Smb4KShare(const Smb4KShare &share)
@@ -74,41 +120,16 @@ Smb4KShare::Smb4KShare(const Smb4KShare &share)
     // Copy the private variables
     //
     *d = *share.d;
-
-    //
-    // Set the icon if necessary
-    //
-    if (pIcon->isNull()) {
-        setShareIcon();
-    }
 }
 
 Smb4KShare::Smb4KShare()
     : Smb4KBasicNetworkItem(Share)
     , d(new Smb4KSharePrivate)
 {
-    //
-    // Set the private variables
-    //
-    d->inaccessible = false;
-    d->foreign = false;
-    d->filesystem = QString();
-    d->user = KUser(KUser::UseRealUserID);
-    d->group = KUserGroup(KUser::UseRealUserID);
-    d->totalSpace = -1;
-    d->freeSpace = -1;
-    d->mounted = false;
-    d->shareType = FileShare;
-
     //
     // Set the URL
     //
     pUrl->setScheme(QStringLiteral("smb"));
-
-    //
-    // Set the icon
-    //
-    setShareIcon();
 }
 
 Smb4KShare::~Smb4KShare()
@@ -124,22 +145,26 @@ void Smb4KShare::setShareName(const QString &name)
     }
 
     pUrl->setScheme(QStringLiteral("smb"));
+    invalidateKey();
 }
 
 QString Smb4KShare::shareName() const
 {
-    return pUrl->path().remove(QStringLiteral("/"));
+    updateDerivedFields();
+    return d->shareName;
 }
 
 void Smb4KShare::setHostName(const QString &hostName)
 {
     pUrl->setHost(hostName.trimmed());
     pUrl->setScheme(QStringLiteral("smb"));
+    invalidateKey();
 }
 
 QString Smb4KShare::hostName() const
 {
-    return pUrl->host().toUpper();
+    updateDerivedFields();
+    return d->hostName;
 }
 
 QUrl Smb4KShare::homeUrl() const
@@ -156,16 +181,13 @@ QUrl Smb4KShare::homeUrl() const
 
 QString Smb4KShare::displayString(bool showHomesShare) const
 {
-    if (showHomesShare && isHomesShare()) {
-        return i18n("%1 on %2", homeUrl().path().remove(QStringLiteral("/")), hostName());
-    }
-
-    return i18n("%1 on %2", shareName(), hostName());
+    updateDerivedFields();
+    return showHomesShare ? d->homesDisplayString : d->displayString;
 }
 
 void Smb4KShare::setWorkgroupName(const QString &workgroup)
 {
-    d->workgroup = workgroup;
+    d->workgroup = internedString(workgroup);
 }
 
 QString Smb4KShare::workgroupName() const
@@ -176,7 +198,6 @@ QString Smb4KShare::workgroupName() const
 void Smb4KShare::setShareType(Smb4KGlobal::ShareType type)
 {
     d->shareType = type;
-    setShareIcon();
 }
 
 Smb4KGlobal::ShareType Smb4KShare::shareType() const
@@ -233,7 +254,8 @@ bool Smb4KShare::hasHostIpAddress() const
 
 bool Smb4KShare::isHidden() const
 {
-    return pUrl->path().endsWith(QStringLiteral("$"));
+    updateDerivedFields();
+    return d->hidden;
 }
 
 bool Smb4KShare::isPrinter() const
@@ -243,23 +265,50 @@ bool Smb4KShare::isPrinter() const
 
 void Smb4KShare::setPath(const QString &mountpoint)
 {
-    d->path = mountpoint;
+    if (!d->mount && mountpoint.isEmpty()) {
+        return;
+    }
+
+    d->mountData()->path = mountpoint;
+    d->mount->canonicalPath.clear();
 }
 
 QString Smb4KShare::path() const
 {
-    return d->path;
+    return d->mount ? d->mount->path : QString();
 }
 
 QString Smb4KShare::canonicalPath() const
 {
-    return (d->inaccessible ? d->path : QDir(d->path).canonicalPath());
+    if (!d->mount) {
+        return QString();
+    }
+
+    return ((d->inaccessible || d->mount->canonicalPath.isEmpty()) ? d->mount->path : d->mount->canonicalPath);
+}
+
+void Smb4KShare::resolveCanonicalPath()
+{
+    if (d->mount && !d->mount->path.isEmpty() && !d->inaccessible) {
+        d->mount->canonicalPath = QDir(d->mount->path).canonicalPath();
+    }
+}
+
+void Smb4KShare::setCanonicalPath(const QString &path)
+{
+    if (d->mount && !d->mount->path.isEmpty()) {
+        d->mount->canonicalPath = path;
+    }
+}
+
+bool Smb4KShare::hasCanonicalPath() const
+{
+    return d->mount && !d->mount->canonicalPath.isEmpty();
 }
 
 void Smb4KShare::setInaccessible(bool in)
 {
     d->inaccessible = in;
-    setShareIcon();
 }
 
 bool Smb4KShare::isInaccessible() const
@@ -270,7 +319,6 @@ bool Smb4KShare::isInaccessible() const
 void Smb4KShare::setForeign(bool foreign)
 {
     d->foreign = foreign;
-    setShareIcon();
 }
 
 bool Smb4KShare::isForeign() const
@@ -280,42 +328,54 @@ bool Smb4KShare::isForeign() const
 
 QString Smb4KShare::fileSystemString() const
 {
-    if (!path().isEmpty() && d->filesystem.isEmpty()) {
-        KMountPoint::Ptr mp = KMountPoint::currentMountPoints().findByPath(path());
+    if (!d->mount) {
+        return QString();
+    }
+
+    if (!d->mount->path.isEmpty() && d->mount->filesystem.isEmpty()) {
+        KMountPoint::Ptr mp = KMountPoint::currentMountPoints().findByPath(d->mount->path);
 
         if (mp) {
-            d->filesystem = mp->mountType().toUpper();
+            d->mount->filesystem = mp->mountType().toUpper();
         }
     }
 
-    return d->filesystem;
+    return d->mount->filesystem;
+}
+
+void Smb4KShare::setFileSystemString(const QString &fileSystem)
+{
+    if (!d->mount && fileSystem.isEmpty()) {
+        return;
+    }
+
+    d->mountData()->filesystem = fileSystem.toUpper();
 }
 
 void Smb4KShare::setUser(const KUser &user)
 {
-    d->user = user;
+    d->mountData()->user = user;
 }
 
 KUser Smb4KShare::user() const
 {
-    return d->user;
+    return d->mount ? d->mount->user : KUser(KUser::UseRealUserID);
 }
 
 void Smb4KShare::setGroup(const KUserGroup &group)
 {
-    d->group = group;
+    d->mountData()->group = group;
 }
 
 KUserGroup Smb4KShare::group() const
 {
-    return d->group;
+    return d->mount ? d->mount->group : KUserGroup(KUser::UseRealUserID);
 }
 
 void Smb4KShare::setMounted(bool mounted)
 {
     if (!isPrinter()) {
         d->mounted = mounted;
-        setShareIcon();
     }
 }
 
@@ -326,37 +386,45 @@ bool Smb4KShare::isMounted() const
 
 void Smb4KShare::setTotalDiskSpace(qint64 size)
 {
-    d->totalSpace = size;
+    if (!d->mount && size == -1) {
+        return;
+    }
+
+    d->mountData()->totalSpace = size;
 }
 
 qint64 Smb4KShare::totalDiskSpace() const
 {
-    return d->totalSpace;
+    return d->mount ? d->mount->totalSpace : -1;
 }
 
 QString Smb4KShare::totalDiskSpaceString() const
 {
-    return KIO::convertSize(static_cast<quint64>(d->totalSpace));
+    return KIO::convertSize(static_cast<quint64>(totalDiskSpace()));
 }
 
 void Smb4KShare::setFreeDiskSpace(qint64 size)
 {
-    d->freeSpace = size;
+    if (!d->mount && size == -1) {
+        return;
+    }
+
+    d->mountData()->freeSpace = size;
 }
 
 qint64 Smb4KShare::freeDiskSpace() const
 {
-    return d->freeSpace;
+    return d->mount ? d->mount->freeSpace : -1;
 }
 
 QString Smb4KShare::freeDiskSpaceString() const
 {
-    return KIO::convertSize(static_cast<quint64>(d->freeSpace));
+    return KIO::convertSize(static_cast<quint64>(freeDiskSpace()));
 }
 
 qint64 Smb4KShare::usedDiskSpace() const
 {
-    return (d->totalSpace - d->freeSpace);
+    return (totalDiskSpace() - freeDiskSpace());
 }
 
 QString Smb4KShare::usedDiskSpaceString() const
@@ -368,9 +436,8 @@ qreal Smb4KShare::diskUsage() const
 {
     qreal usage = 0;
 
-    if (d->totalSpace > 0) {
-        qint64 used = d->totalSpace - d->freeSpace;
-        usage = static_cast<qreal>(used) * 100 / static_cast<qreal>(d->totalSpace);
+    if (totalDiskSpace() > 0) {
+        usage = static_cast<qreal>(usedDiskSpace()) * 100 / static_cast<qreal>(totalDiskSpace());
     }
 
     return usage;
@@ -385,41 +452,29 @@ void Smb4KShare::setMountData(Smb4KShare *share)
 {
     Q_ASSERT(share);
 
-    if (QString::compare(url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                         share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                         Qt::CaseInsensitive)
-            == 0
+    if (hasSameUrl(share)
         && (share->workgroupName().isEmpty() || QString::compare(workgroupName(), share->workgroupName(), Qt::CaseInsensitive) == 0)) {
-        d->path = share->path();
+        d->mount.reset(share->d->mount ? new Smb4KShareMountData(*share->d->mount) : nullptr);
         d->inaccessible = share->isInaccessible();
         d->foreign = share->isForeign();
-        d->user = share->user();
-        d->group = share->group();
-        d->totalSpace = share->totalDiskSpace();
-        d->freeSpace = share->freeDiskSpace();
         d->mounted = share->isMounted();
         d->shareType = share->shareType();
-        setShareIcon();
     }
 }
 
 void Smb4KShare::resetMountData()
 {
-    d->path.clear();
+    d->mount.reset();
     d->inaccessible = false;
     d->foreign = false;
-    d->user = KUser(KUser::UseRealUserID);
-    d->group = KUserGroup(KUser::UseRealUserID);
-    d->totalSpace = -1;
-    d->freeSpace = -1;
     d->mounted = false;
     d->shareType = FileShare;
-    setShareIcon();
 }
 
 bool Smb4KShare::isHomesShare() const
 {
-    return pUrl->path().endsWith(QStringLiteral("homes"));
+    updateDerivedFields();
+    return d->homes;
 }
 
 void Smb4KShare::setPort(int port)
@@ -438,6 +493,11 @@ void Smb4KShare::setUserName(const QString &name)
     // string if we have a homes share.
     if (!isHomesShare() || !name.isEmpty()) {
         pUrl->setUserName(name);
+
+        //
+        // The display string of a homes share contains the user name
+        //
+        d->derivedValid = false;
     }
 }
 
@@ -460,47 +520,85 @@ QString Smb4KShare::password() const
     return pUrl->password();
 }
 
-void Smb4KShare::setShareIcon()
+QIcon Smb4KShare::icon() const
 {
-    if (!isPrinter()) {
-        // Overlays
-        QStringList overlays;
-
-        if (isInaccessible()) {
-            overlays << QStringLiteral("emblem-locked");
-        } else if (isForeign()) {
-            overlays << QStringLiteral("emblem-warning");
-        } else if (isMounted()) {
-            overlays << QStringLiteral("emblem-mounted");
-        }
+    QIcon icon = Smb4KBasicNetworkItem::icon();
 
-        *pIcon = KDE::icon(QStringLiteral("folder-network"), overlays);
-    } else {
-        *pIcon = KDE::icon(QStringLiteral("printer"));
+    if (!icon.isNull()) {
+        return icon;
+    }
+
+    //
+    // Only a handful of combinations of the share type and the mount
+    // state exist, so the icons are shared between all shares.
+    //
+    if (isPrinter()) {
+        return cachedIcon(QStringLiteral("printer"));
     }
+
+    if (isInaccessible()) {
+        return cachedIcon(QStringLiteral("folder-network"), QStringList{QStringLiteral("emblem-locked")});
+    } else if (isForeign()) {
+        return cachedIcon(QStringLiteral("folder-network"), QStringList{QStringLiteral("emblem-warning")});
+    } else if (isMounted()) {
+        return cachedIcon(QStringLiteral("folder-network"), QStringList{QStringLiteral("emblem-mounted")});
+    }
+
+    return cachedIcon(QStringLiteral("folder-network"));
 }
 
 void Smb4KShare::update(Smb4KShare *share)
 {
     if (QString::compare(workgroupName(), share->workgroupName(), Qt::CaseInsensitive) == 0
-        && (QString::compare(url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                             share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                             Qt::CaseInsensitive)
-                == 0
-            || QString::compare(homeUrl().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                share->homeUrl().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                Qt::CaseInsensitive)
-                == 0)) {
+        && (hasSameUrl(share) || keyForUrl(homeUrl()) == keyForUrl(share->homeUrl()))) {
         *pUrl = share->url();
+        invalidateKey();
         setMountData(share);
         setShareType(share->shareType());
         setComment(share->comment());
         setHostIpAddress(share->hostIpAddress());
+        setStale(share->isStale());
+    }
+}
+
+void Smb4KShare::invalidateKey() const
+{
+    Smb4KBasicNetworkItem::invalidateKey();
+    d->derivedValid = false;
+}
+
+void Smb4KShare::updateDerivedFields() const
+{
+    //
+    // The values are used in sort comparators, filters and tool tips,
+    // so they are only computed once after the URL changed.
+    //
+    if (d->derivedValid) {
+        return;
     }
+
+    QString path = pUrl->path();
+
+    d->shareName = path;
+    d->shareName.remove(QStringLiteral("/"));
+    d->hostName = pUrl->host().toUpper();
+    d->hidden = path.endsWith(QStringLiteral("$"));
+    d->homes = path.endsWith(QStringLiteral("homes"));
+    d->displayString = i18n("%1 on %2", d->shareName, d->hostName);
+
+    if (d->homes) {
+        QString userName = pUrl->userName();
+        d->homesDisplayString = i18n("%1 on %2", userName.remove(QStringLiteral("/")), d->hostName);
+    } else {
+        d->homesDisplayString = d->displayString;
+    }
+
+    d->derivedValid = true;
 }
 
 Smb4KShare &Smb4KShare::operator=(const Smb4KShare &other)
 {
     *d = *other.d;
+    d->derivedValid = false;
     return *this;
 }
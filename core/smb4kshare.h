@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a share.
 
-    SPDX-FileCopyrightText: 2008-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2008-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -55,6 +55,14 @@ public:
      */
     ~Smb4KShare();
 
+    /**
+     * Returns the icon of the share. It is derived from the share type and
+     * the mount state each time it is requested.
+     *
+     * @returns the icon
+     */
+    QIcon icon() const override;
+
     /**
      * Sets the name of the share (*not* the UNC).
      *
@@ -210,13 +218,39 @@ public:
     /**
      * Returns the canonical path to the mounted share. In contrast to the path()
      * function it will return the absolute path without symlinks. However, should
-     * the share be inaccessible (i.e. the isInaccessible() returns TRUE), only
-     * the "normal" path is returned.
+     * the share be inaccessible (i.e. the isInaccessible() returns TRUE) or the
+     * canonical path not have been resolved yet, only the "normal" path is returned.
+     *
+     * This function does not access the file system. The canonical path is resolved
+     * by resolveCanonicalPath().
      *
      * @returns the canonical path to the mounted share.
      */
     QString canonicalPath() const;
 
+    /**
+     * Resolve the canonical path of the mount point and store it. This accesses
+     * the file system and might block if the server is not responding, so it
+     * should only be called once when the share was mounted or imported. Nothing
+     * is done if the share is inaccessible.
+     */
+    void resolveCanonicalPath();
+
+    /**
+     * Set the canonical path of the mount point, if it was resolved somewhere
+     * else, e.g. while the share was checked in a worker thread.
+     *
+     * @param path          The canonical path
+     */
+    void setCanonicalPath(const QString &path);
+
+    /**
+     * Returns TRUE if the canonical path was resolved.
+     *
+     * @returns TRUE if the canonical path is known.
+     */
+    bool hasCanonicalPath() const;
+
     /**
      * Set @p in to TRUE if the share cannot be accessed by the user. This may be
      * because if strict permissions or because the remote server went offline. By
@@ -257,6 +291,15 @@ public:
      */
     QString fileSystemString() const;
 
+    /**
+     * Sets the file system of the mounted share. If it is not set, it is
+     * looked up in the mount table the first time fileSystemString() is
+     * called.
+     *
+     * @param fileSystem      The file system
+     */
+    void setFileSystemString(const QString &fileSystem);
+
     /**
      * Sets the owner of this share.
      * @param user             The UID of the owner
@@ -462,13 +505,16 @@ public:
      */
     Smb4KShare &operator=(const Smb4KShare &other);
 
-private:
-    const QScopedPointer<Smb4KSharePrivate> d;
-
+protected:
     /**
-     * Set up the shares icon.
+     * Reimplemented from Smb4KBasicNetworkItem to drop the cached values
+     * that are derived from the URL.
      */
-    void setShareIcon();
+    void invalidateKey() const override;
+
+private:
+    void updateDerivedFields() const;
+    const QScopedPointer<Smb4KSharePrivate> d;
 };
 
 Q_DECLARE_METATYPE(Smb4KShare)
@@ -0,0 +1,466 @@
+/*
+    Check the mounted shares in worker threads
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4ksharechecker.h"
+#include "smb4khardwareinterface.h"
+#include "smb4kshare.h"
+
+// Qt includes
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QStorageInfo>
+#include <QThreadPool>
+#include <QTimer>
+
+// KDE includes
+#include <KUser>
+
+// std includes
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+#define MAX_PARALLEL_CHECKS 8
+#define CHECK_TIMEOUT 5000
+#define ACCESSIBLE_CHECK_INTERVAL 2500
+#define INACCESSIBLE_CHECK_INTERVAL 5000
+#define MAX_INACCESSIBLE_CHECK_INTERVAL 60000
+
+struct Smb4KShareCheckResult {
+    bool accessible = false;
+    QString canonicalPath;
+    qint64 freeDiskSpace = 0;
+    qint64 totalDiskSpace = 0;
+    bool hasOwner = false;
+    uint ownerId = 0;
+    uint groupId = 0;
+};
+
+struct Smb4KShareCheckState {
+    SharePtr share;
+    quint64 checkId = 0;
+    qint64 nextCheck = 0;
+    qint64 deadline = 0;
+    int failures = 0;
+    bool running = false;
+    bool timedOut = false;
+};
+
+//
+// The connection between the checks running in a thread pool and the
+// checker. It is cut when the pool is detached, so that checks that
+// return afterwards do not access the checker anymore.
+//
+struct Smb4KShareCheckerLink {
+    QMutex mutex;
+    Smb4KShareChecker *checker = nullptr;
+};
+
+class Smb4KShareCheckerPrivate
+{
+public:
+    QThreadPool *threadPool;
+    std::shared_ptr<Smb4KShareCheckerLink> link;
+    QTimer timer;
+    QElapsedTimer clock;
+    QHash<QString, Smb4KShareCheckState> states;
+    quint64 lastCheckId;
+    int runningChecks;
+    bool active;
+    bool saturationReported;
+};
+
+//
+// Access the file system. This function runs in a worker thread and
+// must not touch the share.
+//
+static Smb4KShareCheckResult checkPath(const QString &path, bool resolveCanonicalPath)
+{
+    Smb4KShareCheckResult result;
+    QStorageInfo storageInfo(path);
+
+    if (storageInfo.isValid() && storageInfo.isReady()) {
+        result.accessible = true;
+
+        if (resolveCanonicalPath) {
+            result.canonicalPath = QDir(path).canonicalPath();
+        }
+
+        // Bytes available to the user, might be less that bytesFree()
+        result.freeDiskSpace = storageInfo.bytesAvailable();
+        result.totalDiskSpace = storageInfo.bytesTotal();
+
+        QFileInfo fileInfo(path);
+        fileInfo.setCaching(false);
+
+        if (fileInfo.exists()) {
+            result.hasOwner = true;
+            result.ownerId = fileInfo.ownerId();
+            result.groupId = fileInfo.groupId();
+        }
+    }
+
+    return result;
+}
+
+//
+// Apply the result of a check to the share. Shares in the global list are
+// modified through the global list, so that the change is reported.
+//
+static void applyToShare(const SharePtr &share, const std::function<void(Smb4KShare *)> &apply)
+{
+    if (Smb4KGlobal::findShareByPath(share->path()) == share) {
+        Smb4KGlobal::modifyMountedShare(share, [&apply](Smb4KShare *mountedShare) {
+            apply(mountedShare);
+            return static_cast<int>(Smb4KGlobal::MountDataField);
+        });
+    } else {
+        apply(share.data());
+    }
+}
+
+Smb4KShareChecker::Smb4KShareChecker(QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KShareCheckerPrivate)
+{
+    d->threadPool = nullptr;
+    d->lastCheckId = 0;
+    d->runningChecks = 0;
+    d->active = false;
+    d->saturationReported = false;
+    d->timer.setSingleShot(true);
+    d->clock.start();
+
+    connect(&d->timer, &QTimer::timeout, this, &Smb4KShareChecker::slotTimeout);
+
+    createThreadPool();
+}
+
+Smb4KShareChecker::~Smb4KShareChecker()
+{
+    //
+    // Do not wait for checks that hang on a server that stopped responding
+    //
+    detachThreadPool();
+}
+
+void Smb4KShareChecker::createThreadPool()
+{
+    d->threadPool = new QThreadPool();
+    d->threadPool->setMaxThreadCount(MAX_PARALLEL_CHECKS);
+    d->link = std::make_shared<Smb4KShareCheckerLink>();
+    d->link->checker = this;
+    d->runningChecks = 0;
+}
+
+void Smb4KShareChecker::detachThreadPool()
+{
+    {
+        QMutexLocker locker(&d->link->mutex);
+        d->link->checker = nullptr;
+    }
+
+    d->threadPool->clear();
+
+    //
+    // A check might hang in the kernel for minutes, if the server stopped
+    // responding. Destroying the pool would wait for it, so the pool is
+    // left behind in this case. Its threads end when the checks returned.
+    //
+    if (d->threadPool->waitForDone(0)) {
+        delete d->threadPool;
+    }
+
+    d->threadPool = nullptr;
+    d->link.reset();
+}
+
+void Smb4KShareChecker::addShare(const SharePtr &share)
+{
+    Smb4KShareCheckState &state = d->states[share->path()];
+    state.share = share;
+    state.nextCheck = d->clock.elapsed();
+    state.failures = 0;
+
+    scheduleNext();
+}
+
+void Smb4KShareChecker::removeShare(const SharePtr &share)
+{
+    auto it = d->states.find(share->path());
+
+    if (it != d->states.end() && it->share == share) {
+        d->states.erase(it);
+        scheduleNext();
+    }
+}
+
+void Smb4KShareChecker::check(const SharePtr &share)
+{
+    auto it = d->states.find(share->path());
+
+    if (it != d->states.end() && !it->running) {
+        it->nextCheck = d->clock.elapsed();
+        scheduleNext();
+    }
+}
+
+void Smb4KShareChecker::start()
+{
+    d->active = true;
+    scheduleNext();
+}
+
+void Smb4KShareChecker::stop()
+{
+    d->active = false;
+    d->timer.stop();
+
+    for (Smb4KShareCheckState &state : d->states) {
+        state.running = false;
+        state.timedOut = false;
+    }
+
+    //
+    // The results of the running checks are discarded anyway, so do not
+    // keep them. Use a new pool for the checks after a restart.
+    //
+    if (d->runningChecks != 0) {
+        detachThreadPool();
+        createThreadPool();
+    }
+}
+
+void Smb4KShareChecker::scheduleNext()
+{
+    if (!d->active) {
+        return;
+    }
+
+    //
+    // Wake up for the next deadline or the next check, whatever comes first.
+    // While all threads are busy, no check can be started. The timer is
+    // armed again when a check returned.
+    //
+    qint64 next = -1;
+    bool threadAvailable = (d->runningChecks < MAX_PARALLEL_CHECKS);
+
+    for (const Smb4KShareCheckState &state : std::as_const(d->states)) {
+        qint64 due = -1;
+
+        if (state.running) {
+            if (!state.timedOut) {
+                due = state.deadline;
+            }
+        } else if (threadAvailable) {
+            due = state.nextCheck;
+        }
+
+        if (due != -1 && (next == -1 || due < next)) {
+            next = due;
+        }
+    }
+
+    if (next == -1) {
+        d->timer.stop();
+    } else {
+        d->timer.start(static_cast<int>(std::max<qint64>(0, next - d->clock.elapsed())));
+    }
+}
+
+void Smb4KShareChecker::startCheck(const QString &path)
+{
+    Smb4KShareCheckState &state = d->states[path];
+    state.checkId = ++d->lastCheckId;
+    state.deadline = d->clock.elapsed() + CHECK_TIMEOUT;
+    state.running = true;
+    state.timedOut = false;
+
+    quint64 checkId = state.checkId;
+    bool resolveCanonicalPath = !state.share->hasCanonicalPath();
+
+    //
+    // Checks are only started when a thread is available, so the deadline
+    // is not consumed while the check waits in the queue.
+    //
+    d->runningChecks++;
+
+    std::shared_ptr<Smb4KShareCheckerLink> link = d->link;
+
+    d->threadPool->start([link, path, checkId, resolveCanonicalPath]() {
+        Smb4KShareCheckResult result = checkPath(path, resolveCanonicalPath);
+
+        QMutexLocker locker(&link->mutex);
+
+        if (link->checker) {
+            Smb4KShareChecker *checker = link->checker;
+
+            QMetaObject::invokeMethod(
+                checker,
+                [checker, link, path, checkId, result]() {
+                    //
+                    // The pool might have been detached while this call was queued
+                    //
+                    if (checker->d->link != link) {
+                        return;
+                    }
+
+                    checker->d->runningChecks--;
+                    checker->d->saturationReported = false;
+                    checker->checkFinished(path, checkId, result);
+                },
+                Qt::QueuedConnection);
+        }
+    });
+}
+
+void Smb4KShareChecker::slotTimeout()
+{
+    if (!d->active) {
+        return;
+    }
+
+    qint64 now = d->clock.elapsed();
+    QList<SharePtr> timedOutShares;
+    QStringList dueShares;
+    int hungChecks = 0;
+
+    for (auto it = d->states.begin(); it != d->states.end(); ++it) {
+        if (it->running) {
+            //
+            // The server did not answer in time. Report the share as inaccessible,
+            // but do not start another check before this one returned.
+            //
+            if (!it->timedOut && it->deadline <= now) {
+                it->timedOut = true;
+                it->failures++;
+
+                applyToShare(it->share, [](Smb4KShare *share) {
+                    share->setInaccessible(true);
+                    share->setFreeDiskSpace(0);
+                    share->setTotalDiskSpace(0);
+                    share->setUser(KUser(KUser::UseRealUserID));
+                    share->setGroup(KUserGroup(KUser::UseRealUserID));
+                });
+
+                timedOutShares << it->share;
+            }
+
+            if (it->timedOut) {
+                hungChecks++;
+            }
+        } else if (it->nextCheck <= now) {
+            // Do not access the shares while the system is offline
+            if (Smb4KHardwareInterface::self()->isOnline()) {
+                dueShares << it.key();
+            } else {
+                it->nextCheck = now + ACCESSIBLE_CHECK_INTERVAL;
+            }
+        }
+    }
+
+    //
+    // All threads are blocked by checks that did not return. No other share
+    // is checked until one of them does.
+    //
+    if (hungChecks >= MAX_PARALLEL_CHECKS && !d->saturationReported) {
+        qWarning() << "Smb4KShareChecker: All" << MAX_PARALLEL_CHECKS << "checks are blocked. No share is checked until a server responds.";
+        d->saturationReported = true;
+    }
+
+    for (const QString &path : std::as_const(dueShares)) {
+        if (d->runningChecks >= MAX_PARALLEL_CHECKS) {
+            break;
+        }
+
+        startCheck(path);
+    }
+
+    scheduleNext();
+
+    for (const SharePtr &share : std::as_const(timedOutShares)) {
+        Q_EMIT checked(share);
+    }
+}
+
+void Smb4KShareChecker::checkFinished(const QString &path, quint64 checkId, const Smb4KShareCheckResult &result)
+{
+    auto it = d->states.find(path);
+
+    //
+    // Discard the results of shares that were removed in the meantime
+    //
+    if (it == d->states.end() || it->checkId != checkId || !it->running) {
+        scheduleNext();
+        return;
+    }
+
+    it->running = false;
+
+    SharePtr share = it->share;
+    bool timedOut = it->timedOut;
+
+    if (result.accessible) {
+        it->failures = 0;
+    } else if (!timedOut) {
+        it->failures++;
+    }
+
+    //
+    // Check accessible shares in a fixed interval. The interval of inaccessible
+    // shares is doubled with each failed check up to an upper bound.
+    //
+    if (it->failures == 0) {
+        it->nextCheck = d->clock.elapsed() + ACCESSIBLE_CHECK_INTERVAL;
+    } else {
+        qint64 interval = static_cast<qint64>(INACCESSIBLE_CHECK_INTERVAL) << std::min(it->failures - 1, 4);
+        it->nextCheck = d->clock.elapsed() + std::min<qint64>(interval, MAX_INACCESSIBLE_CHECK_INTERVAL);
+    }
+
+    scheduleNext();
+
+    //
+    // The share was already updated when the check timed out
+    //
+    if (timedOut && !result.accessible) {
+        return;
+    }
+
+    applyToShare(share, [&result](Smb4KShare *share) {
+        if (result.accessible) {
+            share->setInaccessible(false);
+
+            if (!result.canonicalPath.isEmpty() && !share->hasCanonicalPath()) {
+                share->setCanonicalPath(result.canonicalPath);
+            }
+
+            share->setFreeDiskSpace(result.freeDiskSpace);
+            share->setTotalDiskSpace(result.totalDiskSpace);
+
+            if (result.hasOwner) {
+                share->setUser(KUser(static_cast<K_UID>(result.ownerId)));
+                share->setGroup(KUserGroup(static_cast<K_GID>(result.groupId)));
+            } else {
+                share->setUser(KUser(KUser::UseRealUserID));
+                share->setGroup(KUserGroup(KUser::UseRealUserID));
+            }
+        } else {
+            share->setInaccessible(true);
+            share->setFreeDiskSpace(0);
+            share->setTotalDiskSpace(0);
+            share->setUser(KUser(KUser::UseRealUserID));
+            share->setGroup(KUserGroup(KUser::UseRealUserID));
+        }
+    });
+
+    Q_EMIT checked(share);
+}
@@ -0,0 +1,106 @@
+/*
+    Check the mounted shares in worker threads
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KSHARECHECKER_H
+#define SMB4KSHARECHECKER_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+#include "smb4kglobal.h"
+
+// Qt includes
+#include <QObject>
+#include <QScopedPointer>
+
+class Smb4KShareCheckerPrivate;
+struct Smb4KShareCheckResult;
+
+/**
+ * This class checks the accessibility, the disk usage and the owner of the
+ * mounted shares. The file system is accessed in a thread pool, so that a
+ * server that stopped responding cannot block the application. A check that
+ * does not finish within a fixed time marks the share inaccessible.
+ *
+ * Accessible shares are checked in a short interval. Inaccessible shares are
+ * checked less often the longer they stay inaccessible.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.0.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KShareChecker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The constructor
+     */
+    explicit Smb4KShareChecker(QObject *parent = nullptr);
+
+    /**
+     * The destructor
+     */
+    ~Smb4KShareChecker();
+
+    /**
+     * Add the share @p share to the shares that are checked periodically. The
+     * first check is scheduled right away.
+     *
+     * @param share         The mounted share
+     */
+    void addShare(const SharePtr &share);
+
+    /**
+     * Remove the share @p share from the shares that are checked. The result
+     * of a running check is discarded.
+     *
+     * @param share         The share
+     */
+    void removeShare(const SharePtr &share);
+
+    /**
+     * Check the share @p share as soon as possible. Nothing is done, if a check
+     * of the share is already running.
+     *
+     * @param share         The share
+     */
+    void check(const SharePtr &share);
+
+    /**
+     * Start the periodic checks.
+     */
+    void start();
+
+    /**
+     * Stop the periodic checks. Running checks are not interrupted, but their
+     * results are discarded.
+     */
+    void stop();
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when a share was checked or its check timed
+     * out. The share was updated before this signal was emitted.
+     *
+     * @param share         The share
+     */
+    void checked(const SharePtr &share);
+
+protected Q_SLOTS:
+    void slotTimeout();
+
+private:
+    void createThreadPool();
+    void detachThreadPool();
+    void scheduleNext();
+    void startCheck(const QString &path);
+    void checkFinished(const QString &path, quint64 checkId, const Smb4KShareCheckResult &result);
+    const QScopedPointer<Smb4KShareCheckerPrivate> d;
+};
+
+#endif
@@ -0,0 +1,186 @@
+/*
+    Wake-On-LAN support with reachability probing
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// application specific includes
+#include "smb4kwakeonlan.h"
+#include "smb4ksettings.h"
+
+// Qt includes
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+
+#define PROBE_INTERVAL 1000
+
+struct Smb4KWakeOnLanProbe {
+    QHostAddress address;
+    QDeadlineTimer deadline;
+    QList<QTcpSocket *> sockets;
+};
+
+class Smb4KWakeOnLanPrivate
+{
+public:
+    QHash<QString, Smb4KWakeOnLanProbe> probes;
+    QTimer *probeTimer;
+};
+
+class Smb4KWakeOnLanStatic
+{
+public:
+    Smb4KWakeOnLan instance;
+};
+
+Q_GLOBAL_STATIC(Smb4KWakeOnLanStatic, p);
+
+Smb4KWakeOnLan::Smb4KWakeOnLan(QObject *parent)
+    : QObject(parent)
+    , d(new Smb4KWakeOnLanPrivate)
+{
+    d->probeTimer = new QTimer(this);
+    d->probeTimer->setInterval(PROBE_INTERVAL);
+
+    connect(d->probeTimer, &QTimer::timeout, this, &Smb4KWakeOnLan::slotProbe);
+}
+
+Smb4KWakeOnLan::~Smb4KWakeOnLan()
+{
+}
+
+Smb4KWakeOnLan *Smb4KWakeOnLan::self()
+{
+    return &p->instance;
+}
+
+void Smb4KWakeOnLan::wakeUp(const QString &macAddress, const QHostAddress &address)
+{
+    //
+    // Construct the magic sequence: 6 times 0xFF followed by 16 times
+    // the MAC address
+    //
+    QByteArray mac = QByteArray::fromHex(macAddress.toLatin1().replace(':', QByteArray()));
+    QByteArray sequence(6, char(0xFF));
+
+    for (int i = 0; i < 16; ++i) {
+        sequence.append(mac);
+    }
+
+    //
+    // Send the packet. If the IP address is unknown, broadcast it.
+    //
+    QUdpSocket socket;
+    socket.writeDatagram(sequence, address.isNull() ? QHostAddress::Broadcast : address, 9);
+
+    //
+    // Start probing the host or extend the waiting time, if it is
+    // already being probed
+    //
+    QString key = wakeUpKey(macAddress, address);
+    Smb4KWakeOnLanProbe &probe = d->probes[key];
+    probe.address = address;
+    probe.deadline.setRemainingTime(1000 * Smb4KSettings::wakeOnLANWaitingTime());
+
+    if (!address.isNull() && probe.sockets.isEmpty()) {
+        QList<quint16> ports = {445, 139};
+
+        if (Smb4KSettings::useRemoteSmbPort() && !ports.contains(Smb4KSettings::remoteSmbPort())) {
+            ports << Smb4KSettings::remoteSmbPort();
+        }
+
+        for (quint16 port : std::as_const(ports)) {
+            QTcpSocket *probeSocket = new QTcpSocket(this);
+            probeSocket->setProperty("port", port);
+
+            connect(probeSocket, &QTcpSocket::connected, this, [this, key]() {
+                finishWakeUp(key, true);
+            });
+
+            //
+            // A host that is still booting refuses the connection. Try
+            // again with the next probe.
+            //
+            connect(probeSocket, &QTcpSocket::errorOccurred, probeSocket, &QTcpSocket::abort);
+
+            probe.sockets << probeSocket;
+        }
+    }
+
+    if (!d->probeTimer->isActive()) {
+        d->probeTimer->start();
+    }
+
+    //
+    // Probe right away, a host that was not sleeping answers immediately
+    //
+    slotProbe();
+}
+
+bool Smb4KWakeOnLan::isWakingUp(const QString &macAddress, const QHostAddress &address) const
+{
+    return d->probes.contains(wakeUpKey(macAddress, address));
+}
+
+QString Smb4KWakeOnLan::wakeUpKey(const QString &macAddress, const QHostAddress &address)
+{
+    QString mac = macAddress.toUpper();
+    mac.remove(QLatin1Char(':'));
+    mac.remove(QLatin1Char('-'));
+
+    return mac + QStringLiteral("@") + address.toString();
+}
+
+void Smb4KWakeOnLan::slotProbe()
+{
+    //
+    // Finish all wake-ups that ran out of time. This also finishes the
+    // broadcasts, since their hosts cannot be probed.
+    //
+    QStringList expired;
+
+    for (auto it = d->probes.cbegin(); it != d->probes.cend(); ++it) {
+        if (it->deadline.hasExpired()) {
+            expired << it.key();
+            continue;
+        }
+
+        for (QTcpSocket *socket : it->sockets) {
+            if (socket->state() == QAbstractSocket::UnconnectedState) {
+                socket->connectToHost(it->address, socket->property("port").toUInt());
+            }
+        }
+    }
+
+    for (const QString &key : std::as_const(expired)) {
+        finishWakeUp(key, false);
+    }
+}
+
+void Smb4KWakeOnLan::finishWakeUp(const QString &key, bool awake)
+{
+    auto it = d->probes.find(key);
+
+    if (it == d->probes.end()) {
+        return;
+    }
+
+    for (QTcpSocket *socket : std::as_const(it->sockets)) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+
+    d->probes.erase(it);
+
+    if (d->probes.isEmpty()) {
+        d->probeTimer->stop();
+    }
+
+    Q_EMIT hostWokenUp(key, awake);
+}
@@ -0,0 +1,103 @@
+/*
+    Wake-On-LAN support with reachability probing
+
+    SPDX-FileCopyrightText: 2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SMB4KWAKEONLAN_H
+#define SMB4KWAKEONLAN_H
+
+// application specific includes
+#include "smb4kcore_export.h"
+
+// Qt includes
+#include <QHostAddress>
+#include <QObject>
+#include <QScopedPointer>
+
+class Smb4KWakeOnLanPrivate;
+
+/**
+ * This class wakes up remote hosts by sending the magic Wake-On-LAN packet.
+ * After the packet was sent, the SMB ports of the host are probed until it
+ * answers. The waiting time defined in the settings is only used as an upper
+ * bound, so that scanning and mounting can proceed as soon as the host is up.
+ *
+ * @author Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+ * @since 4.0.0
+ */
+
+class SMB4KCORE_EXPORT Smb4KWakeOnLan : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * The constructor
+     */
+    explicit Smb4KWakeOnLan(QObject *parent = nullptr);
+
+    /**
+     * The destructor
+     */
+    ~Smb4KWakeOnLan();
+
+    /**
+     * The static pointer to this class.
+     * @returns a static pointer to this class
+     */
+    static Smb4KWakeOnLan *self();
+
+    /**
+     * Send the magic packet to the host with the MAC address @p macAddress
+     * and start probing it. If @p address is null, the packet is broadcasted
+     * and the host cannot be probed. In this case, the full waiting time
+     * passes before the hostWokenUp() signal is emitted.
+     *
+     * @param macAddress    The MAC address of the host
+     * @param address       The IP address of the host
+     */
+    void wakeUp(const QString &macAddress, const QHostAddress &address);
+
+    /**
+     * Returns TRUE if the host with the MAC address @p macAddress and the
+     * IP address @p address is currently being woken up.
+     *
+     * @param macAddress    The MAC address of the host
+     * @param address       The IP address of the host
+     *
+     * @returns TRUE if a wake-up is in progress.
+     */
+    bool isWakingUp(const QString &macAddress, const QHostAddress &address) const;
+
+    /**
+     * Returns the key that identifies the wake-up of the host with the MAC
+     * address @p macAddress and the IP address @p address. Hosts without an
+     * IP address are told apart by their MAC address.
+     *
+     * @param macAddress    The MAC address of the host
+     * @param address       The IP address of the host
+     *
+     * @returns the key of the wake-up
+     */
+    static QString wakeUpKey(const QString &macAddress, const QHostAddress &address);
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted when the wake-up of a host finished.
+     *
+     * @param key           The key of the wake-up (see wakeUpKey())
+     * @param awake         TRUE if the host answered in time
+     */
+    void hostWokenUp(const QString &key, bool awake);
+
+protected Q_SLOTS:
+    void slotProbe();
+
+private:
+    void finishWakeUp(const QString &key, bool awake);
+    const QScopedPointer<Smb4KWakeOnLanPrivate> d;
+};
+
+#endif
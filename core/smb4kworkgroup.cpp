@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a workgroup.
 
-    SPDX-FileCopyrightText: 2008-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2008-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -13,9 +13,6 @@
 #include <QAbstractSocket>
 #include <QUrl>
 
-// KDE includes
-#include <KIconLoader>
-
 using namespace Smb4KGlobal;
 
 class Smb4KWorkgroupPrivate
@@ -23,6 +20,8 @@ class Smb4KWorkgroupPrivate
 public:
     QUrl masterURL;
     QHostAddress masterIP;
+    mutable QString name;
+    mutable bool nameValid = false;
 };
 
 Smb4KWorkgroup::Smb4KWorkgroup(const QString &name)
@@ -34,11 +33,6 @@ Smb4KWorkgroup::Smb4KWorkgroup(const QString &name)
     //
     pUrl->setScheme(QStringLiteral("smb"));
     pUrl->setHost(name);
-
-    //
-    // Set the icon
-    //
-    *pIcon = KDE::icon(QStringLiteral("network-workgroup"));
 }
 
 Smb4KWorkgroup::Smb4KWorkgroup(const Smb4KWorkgroup &workgroup)
@@ -48,13 +42,6 @@ Smb4KWorkgroup::Smb4KWorkgroup(const Smb4KWorkgroup &workgroup)
     // Copy the private variables
     //
     *d = *workgroup.d;
-
-    //
-    // Set the icon if necessary
-    //
-    if (pIcon->isNull()) {
-        *pIcon = KDE::icon(QStringLiteral("network-workgroup"));
-    }
 }
 
 Smb4KWorkgroup::Smb4KWorkgroup()
@@ -65,26 +52,33 @@ Smb4KWorkgroup::Smb4KWorkgroup()
     // Set the URL
     //
     pUrl->setScheme(QStringLiteral("smb"));
-
-    //
-    // Set the icon
-    //
-    *pIcon = KDE::icon(QStringLiteral("network-workgroup"));
 }
 
 Smb4KWorkgroup::~Smb4KWorkgroup()
 {
 }
 
+QIcon Smb4KWorkgroup::icon() const
+{
+    QIcon icon = Smb4KBasicNetworkItem::icon();
+    return !icon.isNull() ? icon : cachedIcon(QStringLiteral("network-workgroup"));
+}
+
 void Smb4KWorkgroup::setWorkgroupName(const QString &name)
 {
     pUrl->setHost(name);
     pUrl->setScheme(QStringLiteral("smb"));
+    invalidateKey();
 }
 
 QString Smb4KWorkgroup::workgroupName() const
 {
-    return pUrl->host().toUpper();
+    if (!d->nameValid) {
+        d->name = pUrl->host().toUpper();
+        d->nameValid = true;
+    }
+
+    return d->name;
 }
 
 void Smb4KWorkgroup::setMasterBrowserName(const QString &name)
@@ -130,11 +124,19 @@ void Smb4KWorkgroup::update(Smb4KWorkgroup *workgroup)
     if (QString::compare(workgroupName(), workgroup->workgroupName()) == 0) {
         setMasterBrowserName(workgroup->masterBrowserName());
         setMasterBrowserIpAddress(workgroup->masterBrowserIpAddress());
+        setStale(workgroup->isStale());
     }
 }
 
+void Smb4KWorkgroup::invalidateKey() const
+{
+    Smb4KBasicNetworkItem::invalidateKey();
+    d->nameValid = false;
+}
+
 Smb4KWorkgroup &Smb4KWorkgroup::operator=(const Smb4KWorkgroup &other)
 {
     *d = *other.d;
+    d->nameValid = false;
     return *this;
 }
@@ -1,7 +1,7 @@
 /*
     Smb4K's container class for information about a workgroup.
 
-    SPDX-FileCopyrightText: 2008-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2008-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -61,6 +61,13 @@ public:
      */
     ~Smb4KWorkgroup();
 
+    /**
+     * Returns the icon of the workgroup. The icon is the same for all workgroups.
+     *
+     * @returns the icon
+     */
+    QIcon icon() const override;
+
     /**
      * Sets the name of the workgroup.
      *
@@ -143,6 +150,12 @@ public:
      */
     Smb4KWorkgroup &operator=(const Smb4KWorkgroup &other);
 
+protected:
+    /**
+     * Reimplemented from Smb4KBasicNetworkItem to drop the cached name.
+     */
+    void invalidateKey() const override;
+
 private:
     const QScopedPointer<Smb4KWorkgroupPrivate> d;
 };
@@ -1,7 +1,7 @@
 /*
     The helper that mounts and unmounts shares.
 
-    SPDX-FileCopyrightText: 2010-2022 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2010-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -11,8 +11,10 @@
 
 // Qt includes
 #include <QDebug>
+#include <QEventLoop>
 #include <QNetworkInterface>
 #include <QProcessEnvironment>
+#include <QTimer>
 #include <QUrl>
 
 // KDE includes
@@ -21,179 +23,387 @@
 #include <KMountPoint>
 #include <KProcess>
 
+// std includes
+#include <functional>
+
 using namespace Smb4KGlobal;
 
+//
+// The time after which a mount or unmount process is killed
+//
+#define PROCESS_TIMEOUT 30000
+
+//
+// The interval in which it is checked if the action was stopped
+//
+#define STOP_CHECK_INTERVAL 250
+
+//
+// The number of processes that run at the same time, if the client
+// did not pass it
+//
+#define DEFAULT_MAX_PROCESSES 4
+
 KAUTH_HELPER_MAIN("org.kde.smb4k.mounthelper", Smb4KMountHelper);
 
-KAuth::ActionReply Smb4KMountHelper::mount(const QVariantMap &args)
+struct Smb4KHelperProcess {
+    KProcess *process = nullptr;
+    QString password;
+    QByteArray standardError;
+    QVariantMap result;
+    bool finished = false;
+};
+
+//
+// Check if the system is online
+//
+static bool isOnline()
 {
-    //
-    // The action reply
-    //
-    ActionReply reply;
-
-    //
-    // Check if the system is online and return an error if it is not
-    //
-    bool online = false;
     QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
 
     for (const QNetworkInterface &interface : std::as_const(interfaces)) {
-        if (interface.isValid() && interface.type() != QNetworkInterface::Loopback && interface.flags() & QNetworkInterface::IsRunning && !online) {
-            online = true;
-            break;
+        if (interface.isValid() && interface.type() != QNetworkInterface::Loopback && interface.flags() & QNetworkInterface::IsRunning) {
+            return true;
         }
     }
 
-    if (!online) {
-        reply.setType(ActionReply::HelperErrorType);
-        return reply;
-    }
-
-    //
-    // Get the mount executable
-    //
-    const QString mount = findMountExecutable();
+    return false;
+}
 
-    //
-    // Check the mount executable
-    //
-    if (mount != args[QStringLiteral("mh_command")].toString()) {
-        // Something weird is going on, bail out.
-        reply.setType(ActionReply::HelperErrorType);
-        return reply;
+//
+// Check that the mountpoint is valid and the file system is correct
+//
+static bool isValidMountPoint(const KMountPoint::List &mountPoints, const QString &path)
+{
+    for (const QExplicitlySharedDataPointer<KMountPoint> &mountPoint : std::as_const(mountPoints)) {
+        if (path == mountPoint->mountPoint()
+            && (mountPoint->mountType() == QStringLiteral("cifs") || mountPoint->mountType() == QStringLiteral("smb3")
+                || mountPoint->mountType() == QStringLiteral("smbfs"))) {
+            return true;
+        }
     }
 
-    //
-    // Mount command
-    //
+    return false;
+}
+
+//
+// Create the mount process
+//
+static KProcess *createMountProcess(const QVariantMap &args)
+{
     QStringList command;
 #if defined(Q_OS_LINUX)
-    command << mount;
+    command << args[QStringLiteral("mh_command")].toString();
     command << args[QStringLiteral("mh_url")].toUrl().toString(QUrl::RemoveScheme | QUrl::RemoveUserInfo | QUrl::RemovePort);
     command << args[QStringLiteral("mh_mountpoint")].toString();
     command << args[QStringLiteral("mh_options")].toStringList();
 #elif defined(Q_OS_FREEBSD) || defined(Q_OS_NETBSD)
-    command << mount;
+    command << args[QStringLiteral("mh_command")].toString();
     command << args[QStringLiteral("mh_options")].toStringList();
     command << args[QStringLiteral("mh_url")].toUrl().toString(QUrl::RemoveScheme | QUrl::RemoveUserInfo | QUrl::RemovePort);
     command << args[QStringLiteral("mh_mountpoint")].toString();
 #endif
 
-    //
-    // The process
-    //
-    KProcess proc(this);
-    proc.setOutputChannelMode(KProcess::SeparateChannels);
-    proc.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
+    KProcess *proc = new KProcess();
+    proc->setOutputChannelMode(KProcess::SeparateChannels);
+    proc->setProcessEnvironment(QProcessEnvironment::systemEnvironment());
 #if defined(Q_OS_LINUX)
-    proc.setEnv(QStringLiteral("PASSWD"), args[QStringLiteral("mh_url")].toUrl().password(), true);
+    proc->setEnv(QStringLiteral("PASSWD"), args[QStringLiteral("mh_url")].toUrl().password(), true);
 #endif
     // We need this to avoid a translated password prompt.
-    proc.setEnv(QStringLiteral("LANG"), QStringLiteral("C"));
+    proc->setEnv(QStringLiteral("LANG"), QStringLiteral("C"));
     // If the location of a Kerberos ticket is passed, it needs to
     // be passed to the process environment here.
     if (args.contains(QStringLiteral("mh_krb5ticket"))) {
-        proc.setEnv(QStringLiteral("KRB5CCNAME"), args[QStringLiteral("mh_krb5ticket")].toString());
+        proc->setEnv(QStringLiteral("KRB5CCNAME"), args[QStringLiteral("mh_krb5ticket")].toString());
     }
 
-    proc.setProgram(command);
-    proc.start();
+    proc->setProgram(command);
+
+    return proc;
+}
+
+//
+// Create the unmount process
+//
+static KProcess *createUnmountProcess(const QVariantMap &args)
+{
+    QStringList command;
+    command << args[QStringLiteral("mh_command")].toString();
+    command << args[QStringLiteral("mh_options")].toStringList();
+    command << args[QStringLiteral("mh_mountpoint")].toString();
+
+    KProcess *proc = new KProcess();
+    proc->setOutputChannelMode(KProcess::SeparateChannels);
+    proc->setProcessEnvironment(QProcessEnvironment::systemEnvironment());
+    proc->setProgram(command);
+
+    return proc;
+}
+
+//
+// Run the processes, at most maxProcesses at the same time, and wait
+// until all of them finished. If streamResults is TRUE, the result of
+// each process is reported to the client as soon as it is available.
+//
+static void runProcesses(QList<Smb4KHelperProcess> &processes, int maxProcesses, bool streamResults)
+{
+    QEventLoop loop;
+    int next = 0;
+    int running = 0;
+    int finished = 0;
+
+    std::function<void()> startProcesses;
+
+    auto finishProcess = [&](int index) {
+        Smb4KHelperProcess &p = processes[index];
+
+        if (p.finished) {
+            return;
+        }
+
+        p.finished = true;
+
+        if (p.process) {
+            running--;
+
+            if (p.process->error() == QProcess::FailedToStart) {
+                p.result[QStringLiteral("mh_process_failed")] = true;
+            } else if (p.process->exitStatus() == KProcess::NormalExit) {
+                p.standardError += p.process->readAllStandardError();
+                p.result[QStringLiteral("mh_error_message")] = QString::fromUtf8(p.standardError).trimmed();
+            }
+        }
 
-    if (proc.waitForStarted(-1)) {
-        int timeout = 0;
+        finished++;
 
-        while (proc.state() != KProcess::NotRunning) {
-            // We want to be able to terminate the process from outside.
-            // Thus, we implement a loop that checks periodically, if we
-            // need to kill the process.
-            if (HelperSupport::isStopped() || timeout == 30000) {
-                proc.kill();
-                break;
+        if (streamResults) {
+            HelperSupport::progressStep(p.result);
+        }
+
+        startProcesses();
+    };
+
+    startProcesses = [&]() {
+        while (running < maxProcesses && next < processes.size()) {
+            int index = next++;
+            Smb4KHelperProcess &p = processes[index];
+
+            //
+            // Processes that were not created already have their result
+            //
+            if (!p.process) {
+                finishProcess(index);
+                continue;
             }
 
             // Check if there is a password prompt. If there is one, pass
             // the password to it.
-            QByteArray out = proc.readAllStandardError();
+            QObject::connect(p.process, &KProcess::readyReadStandardError, p.process, [&processes, index]() {
+                Smb4KHelperProcess &p = processes[index];
+                QByteArray out = p.process->readAllStandardError();
+
+                if (out.startsWith("Password")) {
+                    p.process->write(p.password.toUtf8().data());
+                    p.process->write("\r");
+                } else {
+                    p.standardError += out;
+                }
+            });
 
-            if (out.startsWith("Password")) {
-                proc.write(args[QStringLiteral("mh_url")].toUrl().password().toUtf8().data());
-                proc.write("\r");
-            }
+            QObject::connect(p.process, &KProcess::finished, p.process, [&finishProcess, index]() {
+                finishProcess(index);
+            });
 
-            timeout += 10;
+            QObject::connect(p.process, &KProcess::errorOccurred, p.process, [&finishProcess, index](QProcess::ProcessError error) {
+                if (error == QProcess::FailedToStart) {
+                    finishProcess(index);
+                }
+            });
+
+            QTimer::singleShot(PROCESS_TIMEOUT, p.process, &KProcess::kill);
 
-            wait(10);
+            running++;
+            p.process->start();
         }
 
-        if (proc.exitStatus() == KProcess::NormalExit) {
-            QString stdErr = QString::fromUtf8(proc.readAllStandardError());
-            reply.addData(QStringLiteral("mh_error_message"), stdErr.trimmed());
+        if (finished == processes.size()) {
+            loop.quit();
         }
-    } else {
-        reply.setType(ActionReply::HelperErrorType);
-        reply.setErrorDescription(i18n("The mount process could not be started."));
+    };
+
+    //
+    // We want to be able to terminate the processes from outside.
+    //
+    QTimer stopTimer;
+    stopTimer.setInterval(STOP_CHECK_INTERVAL);
+
+    QObject::connect(&stopTimer, &QTimer::timeout, &loop, [&]() {
+        if (HelperSupport::isStopped()) {
+            //
+            // Do not start the remaining processes
+            //
+            for (int i = next; i < processes.size(); i++) {
+                processes[i].finished = true;
+                finished++;
+            }
+
+            next = processes.size();
+
+            for (const Smb4KHelperProcess &p : std::as_const(processes)) {
+                if (p.process && !p.finished) {
+                    p.process->kill();
+                }
+            }
+
+            if (finished == processes.size()) {
+                loop.quit();
+            }
+        }
+    });
+
+    stopTimer.start();
+
+    startProcesses();
+
+    if (finished < processes.size()) {
+        loop.exec();
     }
 
-    return reply;
+    stopTimer.stop();
+
+    for (const Smb4KHelperProcess &p : std::as_const(processes)) {
+        if (p.process) {
+            p.process->disconnect();
+            delete p.process;
+        }
+    }
 }
 
-KAuth::ActionReply Smb4KMountHelper::unmount(const QVariantMap &args)
+KAuth::ActionReply Smb4KMountHelper::mount(const QVariantMap &args)
 {
+    //
+    // Mount a list of shares
+    //
+    if (args.contains(QStringLiteral("mh_shares"))) {
+        return mountShares(args);
+    }
+
+    //
+    // The action reply
+    //
     ActionReply reply;
 
     //
-    // Get the umount executable
+    // Check if the system is online and return an error if it is not
     //
-    const QString umount = findUmountExecutable();
+    if (!isOnline()) {
+        reply.setType(ActionReply::HelperErrorType);
+        return reply;
+    }
 
     //
     // Check the mount executable
     //
-    if (umount != args[QStringLiteral("mh_command")].toString()) {
+    if (findMountExecutable() != args[QStringLiteral("mh_command")].toString()) {
         // Something weird is going on, bail out.
         reply.setType(ActionReply::HelperErrorType);
         return reply;
     }
 
     //
-    // Check if the mountpoint is valid and the filesystem is correct.
+    // Mount the share
     //
-    bool mountPointOk = false;
-    KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::BasicInfoNeeded | KMountPoint::NeedMountOptions);
+    QList<Smb4KHelperProcess> processes(1);
+    processes[0].process = createMountProcess(args);
+    processes[0].password = args[QStringLiteral("mh_url")].toUrl().password();
 
-    for (const QExplicitlySharedDataPointer<KMountPoint> &mountPoint : std::as_const(mountPoints)) {
-        if (args[QStringLiteral("mh_mountpoint")].toString() == mountPoint->mountPoint()
-            && (mountPoint->mountType() == QStringLiteral("cifs") || mountPoint->mountType() == QStringLiteral("smb3")
-                || mountPoint->mountType() == QStringLiteral("smbfs"))) {
-            mountPointOk = true;
-            break;
-        }
+    runProcesses(processes, 1, false);
+
+    if (processes[0].result.value(QStringLiteral("mh_process_failed")).toBool()) {
+        reply.setType(ActionReply::HelperErrorType);
+        reply.setErrorDescription(i18n("The mount process could not be started."));
+    } else if (processes[0].result.contains(QStringLiteral("mh_error_message"))) {
+        reply.addData(QStringLiteral("mh_error_message"), processes[0].result.value(QStringLiteral("mh_error_message")));
     }
 
+    return reply;
+}
+
+KAuth::ActionReply Smb4KMountHelper::mountShares(const QVariantMap &args)
+{
+    ActionReply reply;
+
     //
-    // Stop here if the mountpoint is not valid
+    // Check if the system is online and return an error if it is not
     //
-    if (!mountPointOk) {
+    if (!isOnline()) {
         reply.setType(ActionReply::HelperErrorType);
-        reply.setErrorDescription(i18n("The mountpoint %1 is invalid.", args[QStringLiteral("mh_mountpoint")].toString()));
+        return reply;
     }
 
+    const QString mount = findMountExecutable();
+    const QVariantList sharesArgs = args[QStringLiteral("mh_shares")].toList();
+
     //
-    // The command
+    // Check the mount executable of all shares before anything is mounted
     //
-    QStringList command;
-    command << umount;
-    command << args[QStringLiteral("mh_options")].toStringList();
-    command << args[QStringLiteral("mh_mountpoint")].toString();
+    for (const QVariant &shareArgs : sharesArgs) {
+        if (mount != shareArgs.toMap().value(QStringLiteral("mh_command")).toString()) {
+            // Something weird is going on, bail out.
+            reply.setType(ActionReply::HelperErrorType);
+            return reply;
+        }
+    }
+
+    //
+    // Mount the shares
+    //
+    QList<Smb4KHelperProcess> processes(sharesArgs.size());
+
+    for (int i = 0; i < sharesArgs.size(); i++) {
+        QVariantMap shareArgs = sharesArgs.at(i).toMap();
 
+        processes[i].process = createMountProcess(shareArgs);
+        processes[i].password = shareArgs[QStringLiteral("mh_url")].toUrl().password();
+        processes[i].result[QStringLiteral("mh_index")] = i;
+    }
+
+    runProcesses(processes, qMax(1, args.value(QStringLiteral("mh_max_processes"), DEFAULT_MAX_PROCESSES).toInt()), true);
+
+    return reply;
+}
+
+KAuth::ActionReply Smb4KMountHelper::unmount(const QVariantMap &args)
+{
     //
-    // The process
+    // Unmount a list of shares
     //
-    KProcess proc(this);
-    proc.setOutputChannelMode(KProcess::SeparateChannels);
-    proc.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
-    proc.setProgram(command);
+    if (args.contains(QStringLiteral("mh_shares"))) {
+        return unmountShares(args);
+    }
+
+    ActionReply reply;
+
+    //
+    // Check the umount executable
+    //
+    if (findUmountExecutable() != args[QStringLiteral("mh_command")].toString()) {
+        // Something weird is going on, bail out.
+        reply.setType(ActionReply::HelperErrorType);
+        return reply;
+    }
+
+    //
+    // Stop here if the mountpoint is not valid
+    //
+    KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::BasicInfoNeeded | KMountPoint::NeedMountOptions);
+
+    if (!isValidMountPoint(mountPoints, args[QStringLiteral("mh_mountpoint")].toString())) {
+        reply.setType(ActionReply::HelperErrorType);
+        reply.setErrorDescription(i18n("The mountpoint %1 is invalid.", args[QStringLiteral("mh_mountpoint")].toString()));
+        return reply;
+    }
 
     //
     // Depending on the online state, use a different behavior for unmounting.
@@ -202,47 +412,81 @@ KAuth::ActionReply Smb4KMountHelper::unmount(const QVariantMap &args)
     // work properly when the process is not detached. Thus, detach it when
     // the system is offline.
     //
-    bool online = false;
-    QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
+    KProcess *proc = createUnmountProcess(args);
 
-    for (const QNetworkInterface &interface : std::as_const(interfaces)) {
-        if (interface.isValid() && interface.type() != QNetworkInterface::Loopback && interface.flags() & QNetworkInterface::IsRunning && !online) {
-            online = true;
-            break;
-        }
+    if (!isOnline()) {
+        proc->startDetached();
+        delete proc;
+        return reply;
     }
 
-    if (online) {
-        proc.start();
+    QList<Smb4KHelperProcess> processes(1);
+    processes[0].process = proc;
 
-        if (proc.waitForStarted(-1)) {
-            // We want to be able to terminate the process from outside.
-            // Thus, we implement a loop that checks periodically, if we
-            // need to kill the process.
-            int timeout = 0;
+    runProcesses(processes, 1, false);
 
-            while (proc.state() != KProcess::NotRunning) {
-                if (HelperSupport::isStopped() || timeout == 30000) {
-                    proc.kill();
-                    break;
-                }
+    if (processes[0].result.value(QStringLiteral("mh_process_failed")).toBool()) {
+        reply.setType(ActionReply::HelperErrorType);
+        reply.setErrorDescription(i18n("The unmount process could not be started."));
+    } else if (processes[0].result.contains(QStringLiteral("mh_error_message"))) {
+        reply.addData(QStringLiteral("mh_error_message"), processes[0].result.value(QStringLiteral("mh_error_message")));
+    }
 
-                timeout += 10;
+    return reply;
+}
 
-                wait(10);
-            }
+KAuth::ActionReply Smb4KMountHelper::unmountShares(const QVariantMap &args)
+{
+    ActionReply reply;
 
-            if (proc.exitStatus() == KProcess::NormalExit) {
-                QString stdErr = QString::fromUtf8(proc.readAllStandardError());
-                reply.addData(QStringLiteral("mh_error_message"), stdErr.trimmed());
-            }
-        } else {
+    const QString umount = findUmountExecutable();
+    const QVariantList sharesArgs = args[QStringLiteral("mh_shares")].toList();
+
+    //
+    // Check the umount executable of all shares before anything is unmounted
+    //
+    for (const QVariant &shareArgs : sharesArgs) {
+        if (umount != shareArgs.toMap().value(QStringLiteral("mh_command")).toString()) {
+            // Something weird is going on, bail out.
             reply.setType(ActionReply::HelperErrorType);
-            reply.setErrorDescription(i18n("The unmount process could not be started."));
+            return reply;
         }
-    } else {
-        proc.startDetached();
     }
 
+    //
+    // Read the mount table and check the online state only once for
+    // all shares
+    //
+    KMountPoint::List mountPoints = KMountPoint::currentMountPoints(KMountPoint::BasicInfoNeeded | KMountPoint::NeedMountOptions);
+    bool online = isOnline();
+
+    QList<Smb4KHelperProcess> processes(sharesArgs.size());
+
+    for (int i = 0; i < sharesArgs.size(); i++) {
+        QVariantMap shareArgs = sharesArgs.at(i).toMap();
+        QString mountpoint = shareArgs[QStringLiteral("mh_mountpoint")].toString();
+
+        processes[i].result[QStringLiteral("mh_index")] = i;
+
+        if (!isValidMountPoint(mountPoints, mountpoint)) {
+            processes[i].result[QStringLiteral("mh_error_message")] = i18n("The mountpoint %1 is invalid.", mountpoint);
+            continue;
+        }
+
+        //
+        // See unmount() for why the process is detached when offline
+        //
+        if (!online) {
+            KProcess *proc = createUnmountProcess(shareArgs);
+            proc->startDetached();
+            delete proc;
+            continue;
+        }
+
+        processes[i].process = createUnmountProcess(shareArgs);
+    }
+
+    runProcesses(processes, qMax(1, args.value(QStringLiteral("mh_max_processes"), DEFAULT_MAX_PROCESSES).toInt()), true);
+
     return reply;
 }
@@ -1,7 +1,7 @@
 /*
     The helper that mounts and unmounts shares.
 
-    SPDX-FileCopyrightText: 2010-2022 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2010-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -22,14 +22,30 @@ class Smb4KMountHelper : public QObject
 
 public Q_SLOTS:
     /**
-     * Mounts a CIFS/SMBFS share.
+     * Mounts a CIFS/SMBFS share. If the argument maps of several shares are
+     * passed in the "mh_shares" list, all of them are mounted.
      */
     KAuth::ActionReply mount(const QVariantMap &args);
 
     /**
-     * Unmounts a CIFS/SMBFS share.
+     * Unmounts a CIFS/SMBFS share. If the argument maps of several shares
+     * are passed in the "mh_shares" list, all of them are unmounted.
      */
     KAuth::ActionReply unmount(const QVariantMap &args);
+
+private:
+    /**
+     * Mounts a list of CIFS/SMBFS shares. Up to "mh_max_processes" shares
+     * are mounted at the same time. The result of each share is reported
+     * with its position in the list as "mh_index" via progress steps.
+     */
+    KAuth::ActionReply mountShares(const QVariantMap &args);
+
+    /**
+     * Unmounts a list of CIFS/SMBFS shares. The arguments and the reported
+     * results are the same as for mountShares().
+     */
+    KAuth::ActionReply unmountShares(const QVariantMap &args);
 };
 
 #endif
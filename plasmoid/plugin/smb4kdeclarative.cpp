@@ -1,7 +1,7 @@
 /*
     This class provides the interface for Plasma and QtQuick
 
-    SPDX-FileCopyrightText: 2013-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2013-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -10,6 +10,7 @@
 #include "core/smb4kbasicnetworkitem.h"
 #include "core/smb4kbookmark.h"
 #include "core/smb4kbookmarkhandler.h"
+#include "core/smb4kchangenotifier.h"
 #include "core/smb4kclient.h"
 #include "core/smb4khost.h"
 #include "core/smb4kmounter.h"
@@ -34,6 +35,7 @@
 //
 // Qt includes
 #include <QDebug>
+#include <QHash>
 #include <QPointer>
 
 // KDE includes
@@ -52,6 +54,8 @@ public:
     QList<Smb4KBookmarkObject *> bookmarkObjects;
     QList<Smb4KBookmarkObject *> bookmarkCategoryObjects;
     QList<Smb4KProfileObject *> profileObjects;
+    QHash<Smb4KBasicNetworkItem *, Smb4KNetworkObject *> networkObjectsIndex;
+    QHash<Smb4KBasicNetworkItem *, Smb4KNetworkObject *> mountedObjectsIndex;
     QList<NetworkItemPtr> requestQueue;
     QPointer<Smb4KPasswordDialog> passwordDialog;
     int timerId;
@@ -66,18 +70,21 @@ Smb4KDeclarative::Smb4KDeclarative(QObject *parent)
 
     Smb4KNotification::setComponentName(QStringLiteral("smb4k"));
 
-    connect(Smb4KClient::self(), &Smb4KClient::workgroups, this, &Smb4KDeclarative::slotWorkgroupsListChanged);
-    connect(Smb4KClient::self(), &Smb4KClient::hosts, this, &Smb4KDeclarative::slotHostsListChanged);
-    connect(Smb4KClient::self(), &Smb4KClient::shares, this, &Smb4KDeclarative::slotSharesListChanged);
     connect(Smb4KClient::self(), &Smb4KClient::aboutToStart, this, &Smb4KDeclarative::busy);
     connect(Smb4KClient::self(), &Smb4KClient::finished, this, &Smb4KDeclarative::idle);
     connect(Smb4KClient::self(), &Smb4KClient::requestCredentials, this, &Smb4KDeclarative::slotCredentialsRequested);
 
-    connect(Smb4KMounter::self(), &Smb4KMounter::mountedSharesListChanged, this, &Smb4KDeclarative::slotMountedSharesListChanged);
     connect(Smb4KMounter::self(), &Smb4KMounter::aboutToStart, this, &Smb4KDeclarative::busy);
     connect(Smb4KMounter::self(), &Smb4KMounter::finished, this, &Smb4KDeclarative::idle);
     connect(Smb4KMounter::self(), &Smb4KMounter::requestCredentials, this, &Smb4KDeclarative::slotCredentialsRequested);
 
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::itemsAdded, this, &Smb4KDeclarative::slotItemsAdded);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::itemsRemoved, this, &Smb4KDeclarative::slotItemsRemoved);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::itemsChanged, this, &Smb4KDeclarative::slotItemsChanged);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::mountedSharesAdded, this, &Smb4KDeclarative::slotMountedSharesAdded);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::mountedSharesRemoved, this, &Smb4KDeclarative::slotMountedSharesRemoved);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::mountedSharesChanged, this, &Smb4KDeclarative::slotMountedSharesChanged);
+
     connect(Smb4KBookmarkHandler::self(), &Smb4KBookmarkHandler::updated, this, &Smb4KDeclarative::slotBookmarksListChanged);
 
     connect(Smb4KProfileManager::self(), &Smb4KProfileManager::profilesListChanged, this, &Smb4KDeclarative::slotProfilesListChanged);
@@ -87,6 +94,28 @@ Smb4KDeclarative::Smb4KDeclarative(QObject *parent)
     //
     // Do the initial loading of items
     //
+    QList<NetworkItemPtr> networkItems;
+
+    const QList<WorkgroupPtr> workgroups = Smb4KGlobal::workgroupsList();
+
+    for (const WorkgroupPtr &workgroup : workgroups) {
+        networkItems << workgroup;
+    }
+
+    const QList<HostPtr> hosts = Smb4KGlobal::hostsList();
+
+    for (const HostPtr &host : hosts) {
+        networkItems << host;
+    }
+
+    const QList<SharePtr> shares = Smb4KGlobal::sharesList();
+
+    for (const SharePtr &share : shares) {
+        networkItems << share;
+    }
+
+    slotItemsAdded(networkItems);
+    slotMountedSharesAdded(Smb4KGlobal::mountedSharesList());
     slotBookmarksListChanged();
     slotProfilesListChanged(Smb4KProfileManager::self()->profilesList());
     slotActiveProfileChanged(Smb4KProfileManager::self()->activeProfile());
@@ -393,7 +422,9 @@ void Smb4KDeclarative::editBookmarks()
 void Smb4KDeclarative::synchronize(Smb4KNetworkObject *object)
 {
     if (object && object->type() == Smb4KNetworkObject::Share) {
-        for (const SharePtr &share : Smb4KGlobal::mountedSharesList()) {
+        const QList<SharePtr> mountedShares = Smb4KGlobal::mountedSharesList();
+
+        for (const SharePtr &share : mountedShares) {
             if (share->url() == object->url()) {
                 QPointer<Smb4KSynchronizationDialog> synchronizationDialog = new Smb4KSynchronizationDialog();
                 if (synchronizationDialog->setShare(share)) {
@@ -413,7 +444,9 @@ void Smb4KDeclarative::openCustomOptionsDialog(Smb4KNetworkObject *object)
 
         switch (object->type()) {
         case Smb4KNetworkObject::Host: {
-            for (const HostPtr &host : Smb4KGlobal::hostsList()) {
+            const QList<HostPtr> hosts = Smb4KGlobal::hostsList();
+
+            for (const HostPtr &host : hosts) {
                 if (host->url() == object->url()) {
                     networkItem = host;
                     break;
@@ -422,7 +455,9 @@ void Smb4KDeclarative::openCustomOptionsDialog(Smb4KNetworkObject *object)
             break;
         }
         case Smb4KNetworkObject::Share: {
-            for (const SharePtr &share : Smb4KGlobal::sharesList()) {
+            const QList<SharePtr> shares = Smb4KGlobal::sharesList();
+
+            for (const SharePtr &share : shares) {
                 if (share->url() == object->url()) {
                     networkItem = share;
                     break;
@@ -553,49 +588,178 @@ void Smb4KDeclarative::timerEvent(QTimerEvent *event)
     }
 }
 
-void Smb4KDeclarative::slotWorkgroupsListChanged()
+void Smb4KDeclarative::slotItemsAdded(const QList<NetworkItemPtr> &items)
 {
-    qDeleteAll(d->workgroupObjects);
-    d->workgroupObjects.clear();
+    bool workgroupsChanged = false, hostsChanged = false, sharesChanged = false;
+
+    for (const NetworkItemPtr &item : items) {
+        if (d->networkObjectsIndex.contains(item.data())) {
+            continue;
+        }
+
+        Smb4KNetworkObject *object = new Smb4KNetworkObject(item.data());
+
+        switch (item->type()) {
+        case Smb4KGlobal::Workgroup: {
+            d->workgroupObjects << object;
+            workgroupsChanged = true;
+            break;
+        }
+        case Smb4KGlobal::Host: {
+            d->hostObjects << object;
+            hostsChanged = true;
+            break;
+        }
+        case Smb4KGlobal::Share: {
+            d->shareObjects << object;
+            sharesChanged = true;
+            break;
+        }
+        default: {
+            delete object;
+            object = nullptr;
+            break;
+        }
+        }
+
+        if (object) {
+            d->networkObjectsIndex.insert(item.data(), object);
+        }
+    }
 
-    for (const WorkgroupPtr &workgroup : Smb4KGlobal::workgroupsList()) {
-        d->workgroupObjects << new Smb4KNetworkObject(workgroup.data());
+    if (workgroupsChanged) {
+        Q_EMIT workgroupsListChanged();
     }
 
-    Q_EMIT workgroupsListChanged();
+    if (hostsChanged) {
+        Q_EMIT hostsListChanged();
+    }
+
+    if (sharesChanged) {
+        Q_EMIT sharesListChanged();
+    }
 }
 
-void Smb4KDeclarative::slotHostsListChanged()
+void Smb4KDeclarative::slotItemsRemoved(const QList<NetworkItemPtr> &items)
 {
-    qDeleteAll(d->hostObjects);
-    d->hostObjects.clear();
+    bool workgroupsChanged = false, hostsChanged = false, sharesChanged = false;
+
+    for (const NetworkItemPtr &item : items) {
+        Smb4KNetworkObject *object = d->networkObjectsIndex.take(item.data());
 
-    for (const HostPtr &host : Smb4KGlobal::hostsList()) {
-        d->hostObjects << new Smb4KNetworkObject(host.data());
+        if (!object) {
+            continue;
+        }
+
+        switch (item->type()) {
+        case Smb4KGlobal::Workgroup: {
+            d->workgroupObjects.removeOne(object);
+            workgroupsChanged = true;
+            break;
+        }
+        case Smb4KGlobal::Host: {
+            d->hostObjects.removeOne(object);
+            hostsChanged = true;
+            break;
+        }
+        case Smb4KGlobal::Share: {
+            d->shareObjects.removeOne(object);
+            sharesChanged = true;
+            break;
+        }
+        default: {
+            break;
+        }
+        }
+
+        delete object;
+    }
+
+    if (workgroupsChanged) {
+        Q_EMIT workgroupsListChanged();
+    }
+
+    if (hostsChanged) {
+        Q_EMIT hostsListChanged();
     }
 
-    Q_EMIT hostsListChanged();
+    if (sharesChanged) {
+        Q_EMIT sharesListChanged();
+    }
 }
 
-void Smb4KDeclarative::slotSharesListChanged()
+void Smb4KDeclarative::slotItemsChanged(const QList<NetworkItemPtr> &items, int fields)
 {
-    qDeleteAll(d->shareObjects);
-    d->shareObjects.clear();
+    Q_UNUSED(fields);
+
+    bool workgroupsChanged = false, hostsChanged = false, sharesChanged = false;
+
+    for (const NetworkItemPtr &item : items) {
+        Smb4KNetworkObject *object = d->networkObjectsIndex.value(item.data());
+
+        if (!object) {
+            continue;
+        }
+
+        object->update(item.data());
+
+        workgroupsChanged |= (item->type() == Smb4KGlobal::Workgroup);
+        hostsChanged |= (item->type() == Smb4KGlobal::Host);
+        sharesChanged |= (item->type() == Smb4KGlobal::Share);
+    }
 
-    for (const SharePtr &share : Smb4KGlobal::sharesList()) {
-        d->shareObjects << new Smb4KNetworkObject(share.data());
+    if (workgroupsChanged) {
+        Q_EMIT workgroupsListChanged();
     }
 
-    Q_EMIT sharesListChanged();
+    if (hostsChanged) {
+        Q_EMIT hostsListChanged();
+    }
+
+    if (sharesChanged) {
+        Q_EMIT sharesListChanged();
+    }
 }
 
-void Smb4KDeclarative::slotMountedSharesListChanged()
+void Smb4KDeclarative::slotMountedSharesAdded(const QList<SharePtr> &shares)
 {
-    qDeleteAll(d->mountedObjects);
-    d->mountedObjects.clear();
+    for (const SharePtr &share : shares) {
+        if (!d->mountedObjectsIndex.contains(share.data())) {
+            Smb4KNetworkObject *object = new Smb4KNetworkObject(share.data());
+            d->mountedObjects << object;
+            d->mountedObjectsIndex.insert(share.data(), object);
+        }
+    }
+
+    if (!shares.isEmpty()) {
+        Q_EMIT mountedSharesListChanged();
+    }
+}
+
+void Smb4KDeclarative::slotMountedSharesRemoved(const QList<SharePtr> &shares)
+{
+    for (const SharePtr &share : shares) {
+        Smb4KNetworkObject *object = d->mountedObjectsIndex.take(share.data());
+
+        if (object) {
+            d->mountedObjects.removeOne(object);
+            delete object;
+        }
+    }
 
-    for (const SharePtr &mountedShare : Smb4KGlobal::mountedSharesList()) {
-        d->mountedObjects << new Smb4KNetworkObject(mountedShare.data());
+    Q_EMIT mountedSharesListChanged();
+}
+
+void Smb4KDeclarative::slotMountedSharesChanged(const QList<SharePtr> &shares, int fields)
+{
+    Q_UNUSED(fields);
+
+    for (const SharePtr &share : shares) {
+        Smb4KNetworkObject *object = d->mountedObjectsIndex.value(share.data());
+
+        if (object) {
+            object->update(share.data());
+        }
     }
 
     Q_EMIT mountedSharesListChanged();
@@ -355,32 +355,42 @@ Q_SIGNALS:
 
 protected Q_SLOTS:
     /**
-     * This slot is invoked, when the list of workgroups was changed by
-     * the scanner. It rebuilds the workgroups() list and emits the
-     * worgroupsListChanged() signal.
+     * This slot is invoked, when workgroups, hosts or shares were added to
+     * the network neighborhood. It adds them to the workgroups(), hosts() and
+     * shares() lists and emits the respective signals.
      */
-    void slotWorkgroupsListChanged();
+    void slotItemsAdded(const QList<NetworkItemPtr> &items);
 
     /**
-     * This slot is invoked, when the list of hosts was changed by the
-     * scanner. It rebuilds the hosts() list and emits the hostsListChanged()
-     * signal.
+     * This slot is invoked, when workgroups, hosts or shares were removed
+     * from the network neighborhood. It removes them from the workgroups(),
+     * hosts() and shares() lists and emits the respective signals.
      */
-    void slotHostsListChanged();
+    void slotItemsRemoved(const QList<NetworkItemPtr> &items);
 
     /**
-     * This slot is invoked, when the list of shares was changed by the
-     * scanner. It rebuilds the shares() list and emits the sharesListChanged()
-     * signal.
+     * This slot is invoked, when workgroups, hosts or shares changed. It
+     * updates the respective objects and emits the respective signals.
+     */
+    void slotItemsChanged(const QList<NetworkItemPtr> &items, int fields);
+
+    /**
+     * This slot is invoked, when shares were mounted. It adds them to the
+     * mountedShares() list and emits the mountedSharesListChanged() signal.
+     */
+    void slotMountedSharesAdded(const QList<SharePtr> &shares);
+
+    /**
+     * This slot is invoked, when shares were unmounted. It removes them from
+     * the mountedShares() list and emits the mountedSharesListChanged() signal.
      */
-    void slotSharesListChanged();
+    void slotMountedSharesRemoved(const QList<SharePtr> &shares);
 
     /**
-     * This slot is invoked, when the list of mounted shares was changed
-     * by the mounter. It rebuilds the mountedShares() list and emits the
-     * mountedSharesListChanged() signal.
+     * This slot is invoked, when mounted shares changed. It updates the
+     * respective objects and emits the mountedSharesListChanged() signal.
      */
-    void slotMountedSharesListChanged();
+    void slotMountedSharesChanged(const QList<SharePtr> &shares, int fields);
 
     /**
      * This slot is invoked when the list of bookmarks was changed. It
@@ -1,7 +1,7 @@
 /*
     The configuration page for the mount options
 
-    SPDX-FileCopyrightText: 2015-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2015-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -144,12 +144,25 @@ void Smb4KConfigPageMounting::setupWidget()
     QCheckBox *detectAllShares = new QCheckBox(Smb4KMountSettings::self()->detectAllSharesItem()->label(), behaviorBox);
     detectAllShares->setObjectName(QStringLiteral("kcfg_DetectAllShares"));
 
+    QWidget *concurrentMountsWidget = new QWidget(behaviorBox);
+    QGridLayout *concurrentMountsWidgetLayout = new QGridLayout(concurrentMountsWidget);
+    concurrentMountsWidgetLayout->setContentsMargins(0, 0, 0, 0);
+
+    QLabel *concurrentMountsLabel = new QLabel(Smb4KMountSettings::self()->maximumConcurrentMountsItem()->label(), concurrentMountsWidget);
+    QSpinBox *concurrentMounts = new QSpinBox(concurrentMountsWidget);
+    concurrentMounts->setObjectName(QStringLiteral("kcfg_MaximumConcurrentMounts"));
+    concurrentMountsLabel->setBuddy(concurrentMounts);
+
+    concurrentMountsWidgetLayout->addWidget(concurrentMountsLabel, 0, 0);
+    concurrentMountsWidgetLayout->addWidget(concurrentMounts, 0, 1);
+
     behaviorBoxLayout->addWidget(remountShares);
     behaviorBoxLayout->addWidget(m_remountSettingsWidget);
     behaviorBoxLayout->addWidget(unmountAllShares);
     behaviorBoxLayout->addWidget(unmountInaccessibleShares);
     behaviorBoxLayout->addWidget(unmountForeignShares);
     behaviorBoxLayout->addWidget(detectAllShares);
+    behaviorBoxLayout->addWidget(concurrentMountsWidget);
 
     basicTabLayout->addWidget(behaviorBox, 0);
     basicTabLayout->addStretch(100);
@@ -551,11 +564,24 @@ void Smb4KConfigPageMounting::setupWidget()
     QCheckBox *detectAllShares = new QCheckBox(Smb4KMountSettings::self()->detectAllSharesItem()->label(), behaviorBox);
     detectAllShares->setObjectName(QStringLiteral("kcfg_DetectAllShares"));
 
+    QWidget *concurrentMountsWidget = new QWidget(behaviorBox);
+    QGridLayout *concurrentMountsWidgetLayout = new QGridLayout(concurrentMountsWidget);
+    concurrentMountsWidgetLayout->setContentsMargins(0, 0, 0, 0);
+
+    QLabel *concurrentMountsLabel = new QLabel(Smb4KMountSettings::self()->maximumConcurrentMountsItem()->label(), concurrentMountsWidget);
+    QSpinBox *concurrentMounts = new QSpinBox(concurrentMountsWidget);
+    concurrentMounts->setObjectName(QStringLiteral("kcfg_MaximumConcurrentMounts"));
+    concurrentMountsLabel->setBuddy(concurrentMounts);
+
+    concurrentMountsWidgetLayout->addWidget(concurrentMountsLabel, 0, 0);
+    concurrentMountsWidgetLayout->addWidget(concurrentMounts, 0, 1);
+
     behaviorBoxLayout->addWidget(remountShares);
     behaviorBoxLayout->addWidget(m_remountSettingsWidget);
     behaviorBoxLayout->addWidget(unmountAllShares);
     behaviorBoxLayout->addWidget(unmountForeignShares);
     behaviorBoxLayout->addWidget(detectAllShares);
+    behaviorBoxLayout->addWidget(concurrentMountsWidget);
 
     basicTabLayout->addWidget(behaviorBox, 0);
     basicTabLayout->addStretch(100);
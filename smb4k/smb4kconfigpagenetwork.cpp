@@ -120,6 +120,20 @@ Smb4KConfigPageNetwork::Smb4KConfigPageNetwork(QWidget *parent)
 
     behaviorBoxLayout->addWidget(previewHiddenItems, 1, 0);
 
+    QCheckBox *useBrowseCache = new QCheckBox(Smb4KSettings::self()->useBrowseCacheItem()->label(), behaviorBox);
+    useBrowseCache->setObjectName(QStringLiteral("kcfg_UseBrowseCache"));
+
+    behaviorBoxLayout->addWidget(useBrowseCache, 1, 1);
+
+    QLabel *browseCacheMaximumAgeLabel = new QLabel(Smb4KSettings::self()->browseCacheMaximumAgeItem()->label(), behaviorBox);
+    QSpinBox *browseCacheMaximumAge = new QSpinBox(behaviorBox);
+    browseCacheMaximumAge->setObjectName(QStringLiteral("kcfg_BrowseCacheMaximumAge"));
+    browseCacheMaximumAge->setSuffix(i18n(" h"));
+    browseCacheMaximumAgeLabel->setBuddy(browseCacheMaximumAge);
+
+    behaviorBoxLayout->addWidget(browseCacheMaximumAgeLabel, 2, 0);
+    behaviorBoxLayout->addWidget(browseCacheMaximumAge, 2, 1);
+
     basicTabLayout->addWidget(behaviorBox);
     basicTabLayout->addStretch(100);
 
@@ -184,6 +198,14 @@ Smb4KConfigPageNetwork::Smb4KConfigPageNetwork(QWidget *parent)
 
     sambaBoxLayout->addWidget(useCCache, 5, 0, 1, 2);
 
+    QLabel *maximumParallelLookupsLabel = new QLabel(Smb4KSettings::self()->maximumParallelLookupsItem()->label(), sambaBox);
+    QSpinBox *maximumParallelLookups = new QSpinBox(sambaBox);
+    maximumParallelLookups->setObjectName(QStringLiteral("kcfg_MaximumParallelLookups"));
+    maximumParallelLookupsLabel->setBuddy(maximumParallelLookups);
+
+    sambaBoxLayout->addWidget(maximumParallelLookupsLabel, 6, 0);
+    sambaBoxLayout->addWidget(maximumParallelLookups, 6, 1);
+
     advancedTabLayout->addWidget(sambaBox);
 
     QGroupBox *wakeOnLanBox = new QGroupBox(i18n("Wake-On-LAN"), advancedTab);
@@ -506,7 +506,9 @@ void Smb4KMainWindow::slotClientAboutToStart(const NetworkItemPtr &item, int pro
         case FileOrDirectory: {
             FilePtr file = item.staticCast<Smb4KFile>();
 
-            for (const SharePtr &share : sharesList()) {
+            const QList<SharePtr> shares = sharesList();
+
+            for (const SharePtr &share : shares) {
                 // FIXME: Use QUrl::matches() here. Additionally, we do not really need the workgroup.
                 if (share->workgroupName() == file->workgroupName() && share->hostName() == file->hostName() && share->shareName() == file->shareName()) {
                     message = i18n("Looking for files and directories in %1...", share->displayString());
@@ -7,6 +7,7 @@
 
 // application specific includes
 #include "smb4knetworkbrowserdockwidget.h"
+#include "core/smb4kchangenotifier.h"
 #include "core/smb4kclient.h"
 #include "core/smb4khost.h"
 #include "core/smb4kmounter.h"
@@ -28,6 +29,7 @@
 // Qt includes
 #include <QApplication>
 #include <QHeaderView>
+#include <QItemSelectionModel>
 #include <QMenu>
 #include <QPointer>
 #include <QTreeWidgetItemIterator>
@@ -76,13 +78,14 @@ Smb4KNetworkBrowserDockWidget::Smb4KNetworkBrowserDockWidget(const QString &titl
 
     connect(Smb4KClient::self(), &Smb4KClient::aboutToStart, this, &Smb4KNetworkBrowserDockWidget::slotClientAboutToStart);
     connect(Smb4KClient::self(), &Smb4KClient::finished, this, &Smb4KNetworkBrowserDockWidget::slotClientFinished);
-    connect(Smb4KClient::self(), &Smb4KClient::workgroups, this, &Smb4KNetworkBrowserDockWidget::slotWorkgroups);
     connect(Smb4KClient::self(), &Smb4KClient::hosts, this, &Smb4KNetworkBrowserDockWidget::slotWorkgroupMembers);
     connect(Smb4KClient::self(), &Smb4KClient::shares, this, &Smb4KNetworkBrowserDockWidget::slotShares);
     connect(Smb4KClient::self(), &Smb4KClient::searchResults, this, &Smb4KNetworkBrowserDockWidget::slotSearchResults);
 
-    connect(Smb4KMounter::self(), &Smb4KMounter::mounted, this, &Smb4KNetworkBrowserDockWidget::slotShareMounted);
-    connect(Smb4KMounter::self(), &Smb4KMounter::unmounted, this, &Smb4KNetworkBrowserDockWidget::slotShareUnmounted);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::itemsAdded, this, &Smb4KNetworkBrowserDockWidget::slotItemsAdded);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::itemsRemoved, this, &Smb4KNetworkBrowserDockWidget::slotItemsRemoved);
+    connect(Smb4KChangeNotifier::self(), &Smb4KChangeNotifier::itemsChanged, this, &Smb4KNetworkBrowserDockWidget::slotItemsChanged);
+
     connect(Smb4KMounter::self(), &Smb4KMounter::aboutToStart, this, &Smb4KNetworkBrowserDockWidget::slotMounterAboutToStart);
     connect(Smb4KMounter::self(), &Smb4KMounter::finished, this, &Smb4KNetworkBrowserDockWidget::slotMounterFinished);
 }
@@ -274,11 +277,10 @@ void Smb4KNetworkBrowserDockWidget::loadSettings()
     //
     // Does anything has to be changed with the marked shares?
     //
-    for (const SharePtr &share : mountedSharesList()) {
-        // We do not need to use slotShareUnmounted() here, too,
-        // because slotShareMounted() will take care of everything
-        // we need here.
-        slotShareMounted(share);
+    for (Smb4KNetworkBrowserItem *item : std::as_const(m_items)) {
+        if (item->type() == Share) {
+            item->update();
+        }
     }
 
     //
@@ -483,232 +485,224 @@ void Smb4KNetworkBrowserDockWidget::slotClientFinished(const NetworkItemPtr &ite
 
     if (process == NetworkSearch) {
         m_searchToolBar->setActiveState(false);
+        m_searchRunning = false;
     }
 }
 
-void Smb4KNetworkBrowserDockWidget::slotWorkgroups()
+QString Smb4KNetworkBrowserDockWidget::itemKey(const NetworkItemPtr &item)
 {
-    if (!workgroupsList().isEmpty()) {
-        //
-        // Remove obsolete workgroups and update existing ones
-        //
-        QTreeWidgetItemIterator itemIt(m_networkBrowser, QTreeWidgetItemIterator::All);
-
-        while (*itemIt) {
-            Smb4KNetworkBrowserItem *networkItem = static_cast<Smb4KNetworkBrowserItem *>(*itemIt);
+    //
+    // A workgroup and a host might have the same name, so the type is
+    // part of the key. Hosts with the same name might exist in different
+    // workgroups, so the workgroup is part of the key of hosts and shares.
+    //
+    QString workgroup;
 
-            if (networkItem->type() == Workgroup) {
-                WorkgroupPtr workgroup = findWorkgroup(networkItem->workgroupItem()->workgroupName());
+    switch (item->type()) {
+    case Host: {
+        workgroup = item.staticCast<Smb4KHost>()->workgroupName().toCaseFolded();
+        break;
+    }
+    case Share: {
+        workgroup = item.staticCast<Smb4KShare>()->workgroupName().toCaseFolded();
+        break;
+    }
+    default: {
+        break;
+    }
+    }
 
-                if (workgroup) {
-                    networkItem->update();
+    return QString::number(item->type()) + QStringLiteral(":") + workgroup + QStringLiteral(":") + item->key();
+}
 
-                    // Update the master browser
-                    for (int i = 0; i < networkItem->childCount(); ++i) {
-                        Smb4KNetworkBrowserItem *host = static_cast<Smb4KNetworkBrowserItem *>(networkItem->child(i));
-                        host->update();
-                    }
-                } else {
-                    delete networkItem;
-                }
-            }
+Smb4KNetworkBrowserItem *Smb4KNetworkBrowserDockWidget::addItem(const NetworkItemPtr &item)
+{
+    Smb4KNetworkBrowserItem *browserItem = m_items.value(itemKey(item));
 
-            ++itemIt;
-        }
+    if (browserItem) {
+        return browserItem;
+    }
 
-        //
-        // Add new workgroups to the tree widget
-        //
-        for (const WorkgroupPtr &workgroup : workgroupsList()) {
-            QList<QTreeWidgetItem *> items = m_networkBrowser->findItems(workgroup->workgroupName(), Qt::MatchFixedString, Smb4KNetworkBrowser::Network);
+    //
+    // Find the parent item. It is created, if it was removed from the
+    // view before (e.g. because the workgroup was empty).
+    //
+    switch (item->type()) {
+    case Workgroup: {
+        browserItem = new Smb4KNetworkBrowserItem(m_networkBrowser, item);
+        break;
+    }
+    case Host: {
+        HostPtr host = item.staticCast<Smb4KHost>();
+        WorkgroupPtr workgroup = findWorkgroup(host->workgroupName());
 
-            if (items.isEmpty()) {
-                (void)new Smb4KNetworkBrowserItem(m_networkBrowser, workgroup);
-            }
+        if (workgroup) {
+            browserItem = new Smb4KNetworkBrowserItem(addItem(workgroup), item);
         }
 
-        //
-        // Sort the items
-        //
-        m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
-    } else {
-        //
-        // Clear the tree widget
-        //
-        m_networkBrowser->clear();
+        break;
     }
-}
+    case Share: {
+        SharePtr share = item.staticCast<Smb4KShare>();
+        HostPtr host = findHost(share->hostName(), share->workgroupName());
 
-void Smb4KNetworkBrowserDockWidget::slotWorkgroupMembers(const WorkgroupPtr &workgroup)
-{
-    if (workgroup) {
-        //
-        // Find the right workgroup
-        //
-        QList<QTreeWidgetItem *> workgroups =
-            m_networkBrowser->findItems(workgroup->workgroupName(), Qt::MatchFixedString | Qt::MatchRecursive, Smb4KNetworkBrowser::Network);
-        Smb4KNetworkBrowserItem *workgroupItem = nullptr;
-
-        for (QTreeWidgetItem *item : std::as_const(workgroups)) {
-            Smb4KNetworkBrowserItem *tempWorkgroup = static_cast<Smb4KNetworkBrowserItem *>(item);
+        if (host) {
+            Smb4KNetworkBrowserItem *hostItem = addItem(host);
 
-            if (tempWorkgroup->type() == Workgroup && tempWorkgroup->workgroupItem()->workgroupName() == workgroup->workgroupName()) {
-                workgroupItem = tempWorkgroup;
-                break;
+            if (hostItem) {
+                browserItem = new Smb4KNetworkBrowserItem(hostItem, item);
             }
         }
 
-        //
-        // Process the hosts
-        //
-        if (workgroupItem) {
-            //
-            // Remove obsolete hosts and update existing ones
-            //
-            QTreeWidgetItemIterator hostIt(workgroupItem);
+        break;
+    }
+    default: {
+        break;
+    }
+    }
 
-            while (*hostIt) {
-                Smb4KNetworkBrowserItem *hostItem = static_cast<Smb4KNetworkBrowserItem *>(*hostIt);
+    if (browserItem) {
+        QString key = itemKey(item);
+        m_items.insert(key, browserItem);
+        m_itemKeys.insert(item.data(), key);
+    }
 
-                if (hostItem->type() == Host) {
-                    HostPtr host = findHost(hostItem->hostItem()->hostName(), hostItem->hostItem()->workgroupName());
+    return browserItem;
+}
 
-                    if (host) {
-                        hostItem->update();
-                    } else {
-                        delete hostItem;
-                    }
-                }
+void Smb4KNetworkBrowserDockWidget::removeItem(Smb4KNetworkBrowserItem *browserItem)
+{
+    //
+    // Forget about the children, they are deleted together with the item.
+    // Use the keys the items were filed under, because the URL of an item
+    // might have changed in the meantime.
+    //
+    for (int i = 0; i < browserItem->childCount(); ++i) {
+        Smb4KNetworkBrowserItem *child = static_cast<Smb4KNetworkBrowserItem *>(browserItem->child(i));
 
-                ++hostIt;
-            }
+        for (int j = 0; j < child->childCount(); ++j) {
+            m_items.remove(m_itemKeys.take(static_cast<Smb4KNetworkBrowserItem *>(child->child(j))->networkItem().data()));
+        }
 
-            //
-            // Add new hosts to the workgroup item and remove obsolete workgroups if
-            // necessary. Honor the auto-expand feature.
-            //
-            QList<HostPtr> members = workgroupMembers(workgroup);
+        m_items.remove(m_itemKeys.take(child->networkItem().data()));
+    }
 
-            if (!members.isEmpty()) {
-                for (const HostPtr &host : std::as_const(members)) {
-                    bool foundHost = false;
+    m_items.remove(m_itemKeys.take(browserItem->networkItem().data()));
 
-                    for (int i = 0; i < workgroupItem->childCount(); ++i) {
-                        Smb4KNetworkBrowserItem *hostItem = static_cast<Smb4KNetworkBrowserItem *>(workgroupItem->child(i));
+    delete browserItem;
+}
 
-                        if (hostItem->hostItem()->hostName() == host->hostName()) {
-                            foundHost = true;
-                            break;
-                        }
-                    }
+void Smb4KNetworkBrowserDockWidget::slotItemsAdded(const QList<NetworkItemPtr> &items)
+{
+    //
+    // The workgroups come before their members and the hosts before
+    // their shares, so the parent items are usually already there.
+    //
+    for (const NetworkItemPtr &item : items) {
+        (void)addItem(item);
+    }
 
-                    if (!foundHost) {
-                        (void)new Smb4KNetworkBrowserItem(workgroupItem, host);
-                    }
-                }
+    //
+    // Sort the items
+    //
+    m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
+}
 
-                //
-                // Auto-expand the workgroup item, if applicable
-                //
-                if (Smb4KSettings::autoExpandNetworkItems() && !workgroupItem->isExpanded() && !m_searchRunning) {
-                    m_networkBrowser->expandItem(workgroupItem);
-                }
-            } else {
-                //
-                // Remove empty workgroup.
-                //
-                delete workgroupItem;
-            }
+void Smb4KNetworkBrowserDockWidget::slotItemsRemoved(const QList<NetworkItemPtr> &items)
+{
+    for (const NetworkItemPtr &item : items) {
+        //
+        // Use the key the item was filed under, because its URL might
+        // have changed since
+        //
+        Smb4KNetworkBrowserItem *browserItem = m_items.value(m_itemKeys.value(item.data(), itemKey(item)));
 
-            //
-            // Sort the items
-            //
-            m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
+        if (browserItem) {
+            removeItem(browserItem);
         }
     }
 }
 
-void Smb4KNetworkBrowserDockWidget::slotShares(const HostPtr &host)
+void Smb4KNetworkBrowserDockWidget::slotItemsChanged(const QList<NetworkItemPtr> &items, int fields)
 {
-    if (host) {
+    for (const NetworkItemPtr &item : items) {
+        QString key = itemKey(item);
+        Smb4KNetworkBrowserItem *browserItem = m_items.value(key);
+
         //
-        // Find the right host
+        // The item is still filed under its old key, if its URL changed
+        // (e.g. the URL of a homes share was rewritten). File it under the
+        // new one.
         //
-        QList<QTreeWidgetItem *> hosts = m_networkBrowser->findItems(host->hostName(), Qt::MatchFixedString | Qt::MatchRecursive, Smb4KNetworkBrowser::Network);
-        Smb4KNetworkBrowserItem *hostItem = nullptr;
+        if (!browserItem && (fields & UrlField)) {
+            auto it = m_itemKeys.find(item.data());
 
-        for (QTreeWidgetItem *item : std::as_const(hosts)) {
-            Smb4KNetworkBrowserItem *tempHost = static_cast<Smb4KNetworkBrowserItem *>(item);
+            if (it != m_itemKeys.end()) {
+                browserItem = m_items.take(it.value());
 
-            if (tempHost->type() == Host && tempHost->hostItem()->workgroupName() == host->workgroupName()) {
-                hostItem = tempHost;
-                break;
+                if (browserItem) {
+                    m_items.insert(key, browserItem);
+                    it.value() = key;
+                }
             }
         }
 
-        //
-        // Process the shares
-        //
-        if (hostItem) {
-            //
-            // Remove obsolete shares and update existing ones
-            //
-            QTreeWidgetItemIterator shareIt(hostItem);
+        if (browserItem) {
+            browserItem->update();
+        }
+    }
 
-            while (*shareIt) {
-                Smb4KNetworkBrowserItem *shareItem = static_cast<Smb4KNetworkBrowserItem *>(*shareIt);
+    //
+    // Adjust the actions, if a selected share was mounted or unmounted
+    //
+    if (fields & MountDataField) {
+        slotItemSelectionChanged();
+    }
+}
 
-                if (shareItem->type() == Share) {
-                    SharePtr share = findShare(shareItem->shareItem()->url(), shareItem->shareItem()->workgroupName());
+void Smb4KNetworkBrowserDockWidget::slotWorkgroupMembers(const WorkgroupPtr &workgroup)
+{
+    //
+    // Apply the pending changes to the lists to the view first
+    //
+    Smb4KChangeNotifier::self()->flush();
 
-                    if (share) {
-                        shareItem->update();
-                    } else {
-                        delete shareItem;
-                    }
-                }
+    Smb4KNetworkBrowserItem *workgroupItem = m_items.value(itemKey(workgroup));
 
-                ++shareIt;
+    if (workgroupItem) {
+        if (workgroupItem->childCount() != 0) {
+            //
+            // Auto-expand the workgroup item, if applicable
+            //
+            if (Smb4KSettings::autoExpandNetworkItems() && !workgroupItem->isExpanded() && !m_searchRunning) {
+                m_networkBrowser->expandItem(workgroupItem);
             }
-
+        } else {
             //
-            // Add new shares to the host item. The host will not be removed from the
-            // view when it has no shares. Honor the auto-expand feature.
+            // Remove empty workgroup.
             //
-            QList<SharePtr> shares = sharedResources(host);
-
-            if (!shares.isEmpty()) {
-                for (const SharePtr &share : std::as_const(shares)) {
-                    bool foundShare = false;
-
-                    for (int i = 0; i < hostItem->childCount(); ++i) {
-                        Smb4KNetworkBrowserItem *shareItem = static_cast<Smb4KNetworkBrowserItem *>(hostItem->child(i));
+            removeItem(workgroupItem);
+        }
+    }
+}
 
-                        if (shareItem->shareItem()->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort)
-                            == share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort)) {
-                            foundShare = true;
-                            break;
-                        }
-                    }
+void Smb4KNetworkBrowserDockWidget::slotShares(const HostPtr &host)
+{
+    //
+    // Apply the pending changes to the lists to the view first. The host
+    // will not be removed from the view when it has no shares.
+    //
+    Smb4KChangeNotifier::self()->flush();
 
-                    if (!foundShare) {
-                        (void)new Smb4KNetworkBrowserItem(hostItem, share);
-                    }
-                }
+    Smb4KNetworkBrowserItem *hostItem = m_items.value(itemKey(host));
 
-                //
-                // Auto-expand the host item, if applicable
-                //
-                if (Smb4KSettings::autoExpandNetworkItems() && !hostItem->isExpanded() && !m_searchRunning) {
-                    m_networkBrowser->expandItem(hostItem);
-                }
-            }
+    //
+    // Auto-expand the host item, if applicable
+    //
+    if (hostItem && hostItem->childCount() != 0) {
+        if (Smb4KSettings::autoExpandNetworkItems() && !hostItem->isExpanded() && !m_searchRunning) {
+            m_networkBrowser->expandItem(hostItem);
         }
-
-        //
-        // Sort the items
-        //
-        m_networkBrowser->sortItems(Smb4KNetworkBrowser::Network, Qt::AscendingOrder);
     }
 }
 
@@ -950,48 +944,6 @@ void Smb4KNetworkBrowserDockWidget::slotMountActionChanged(bool active)
     }
 }
 
-void Smb4KNetworkBrowserDockWidget::slotShareMounted(const SharePtr &share)
-{
-    QTreeWidgetItemIterator it(m_networkBrowser);
-
-    while (*it) {
-        Smb4KNetworkBrowserItem *item = static_cast<Smb4KNetworkBrowserItem *>(*it);
-
-        if (item->type() == Share) {
-            if (QString::compare(item->shareItem()->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                == 0) {
-                item->update();
-                break;
-            }
-        }
-
-        ++it;
-    }
-}
-
-void Smb4KNetworkBrowserDockWidget::slotShareUnmounted(const SharePtr &share)
-{
-    QTreeWidgetItemIterator it(m_networkBrowser);
-
-    while (*it) {
-        Smb4KNetworkBrowserItem *item = static_cast<Smb4KNetworkBrowserItem *>(*it);
-
-        if (item->type() == Share) {
-            if (QString::compare(item->shareItem()->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 share->url().toString(QUrl::RemoveUserInfo | QUrl::RemovePort),
-                                 Qt::CaseInsensitive)
-                == 0) {
-                item->update();
-                break;
-            }
-        }
-
-        ++it;
-    }
-}
-
 void Smb4KNetworkBrowserDockWidget::slotMounterAboutToStart(int process)
 {
     Q_UNUSED(process);
@@ -1083,33 +1035,36 @@ void Smb4KNetworkBrowserDockWidget::slotStopSearch()
 
 void Smb4KNetworkBrowserDockWidget::slotSearchResults(const QList<SharePtr> &shares)
 {
-    m_searchRunning = false;
-    QTreeWidgetItemIterator it(m_networkBrowser);
+    //
+    // The results arrive in portions while the search is running.
+    // Only scroll to the first one.
+    //
+    bool firstResults = !m_networkBrowser->selectionModel()->hasSelection();
+    Smb4KNetworkBrowserItem *firstItem = nullptr;
 
-    while (*it) {
-        Smb4KNetworkBrowserItem *networkItem = static_cast<Smb4KNetworkBrowserItem *>(*it);
+    for (const SharePtr &share : shares) {
+        Smb4KNetworkBrowserItem *shareItem = m_items.value(m_itemKeys.value(share.data(), itemKey(share)));
 
-        if (networkItem->type() == Share) {
-            for (const SharePtr &share : shares) {
-                if (networkItem->shareItem() == share) {
-                    networkItem->setSelected(true);
+        if (shareItem && shareItem->shareItem() == share) {
+            shareItem->setSelected(true);
 
-                    if (!networkItem->parent()->isExpanded()) {
-                        m_networkBrowser->expandItem(networkItem->parent());
-                    }
+            if (!shareItem->parent()->isExpanded()) {
+                m_networkBrowser->expandItem(shareItem->parent());
+            }
 
-                    if (!networkItem->parent()->parent()->isExpanded()) {
-                        m_networkBrowser->expandItem(networkItem->parent()->parent());
-                    }
-                }
+            if (!shareItem->parent()->parent()->isExpanded()) {
+                m_networkBrowser->expandItem(shareItem->parent()->parent());
             }
-        }
 
-        it++;
+            if (!firstItem) {
+                firstItem = shareItem;
+            }
+        }
     }
 
-    QTreeWidgetItem *firstItem = m_networkBrowser->selectedItems().first();
-    m_networkBrowser->scrollToItem(firstItem, QTreeWidget::PositionAtCenter);
+    if (firstResults && firstItem) {
+        m_networkBrowser->scrollToItem(firstItem, QTreeWidget::PositionAtCenter);
+    }
 
     m_searchToolBar->setSearchResults(shares);
 }
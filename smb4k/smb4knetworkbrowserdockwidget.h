@@ -1,7 +1,7 @@
 /*
     The network neighborhood browser dock widget
 
-    SPDX-FileCopyrightText: 2018-2023 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
+    SPDX-FileCopyrightText: 2018-2024 Alexander Reinholdt <alexander.reinholdt@kdemail.net>
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
@@ -13,6 +13,7 @@
 
 // Qt includes
 #include <QDockWidget>
+#include <QHash>
 #include <QPointer>
 #include <QTreeWidgetItem>
 
@@ -24,6 +25,7 @@ using namespace Smb4KGlobal;
 
 // Forward declarations
 class Smb4KNetworkBrowser;
+class Smb4KNetworkBrowserItem;
 class Smb4KNetworkSearchToolBar;
 class Smb4KPasswordDialog;
 
@@ -99,9 +101,23 @@ protected Q_SLOTS:
     void slotClientFinished(const NetworkItemPtr &item, int process);
 
     /**
-     * This slot is called when workgroups/domains were discovered
+     * This slot is connected to the Smb4KChangeNotifier::itemsAdded() signal.
+     * @param items               The network items that were added
      */
-    void slotWorkgroups();
+    void slotItemsAdded(const QList<NetworkItemPtr> &items);
+
+    /**
+     * This slot is connected to the Smb4KChangeNotifier::itemsRemoved() signal.
+     * @param items               The network items that were removed
+     */
+    void slotItemsRemoved(const QList<NetworkItemPtr> &items);
+
+    /**
+     * This slot is connected to the Smb4KChangeNotifier::itemsChanged() signal.
+     * @param items               The network items that changed
+     * @param fields              The changed properties
+     */
+    void slotItemsChanged(const QList<NetworkItemPtr> &items, int fields);
 
     /**
      * This slot is called when the list of servers of workgroup/domain
@@ -178,20 +194,6 @@ protected Q_SLOTS:
      */
     void slotMountActionChanged(bool active);
 
-    /**
-     * This slot is called whenever a share has been mounted. It marks the
-     * respective share in the tree widget as mounted.
-     * @param share               The Smb4KShare object
-     */
-    void slotShareMounted(const SharePtr &share);
-
-    /**
-     * This slot is called whenever a share has been unmounted. It marks the
-     * respective share in the tree widget as not mounted.
-     * @param share               The Smb4KShare object
-     */
-    void slotShareUnmounted(const SharePtr &share);
-
     /**
      * This slot is connected to the Smb4KMounter::aboutToStart() signal.
      * @param process             The process
@@ -250,11 +252,16 @@ protected Q_SLOTS:
 
 private:
     void setupActions();
+    Smb4KNetworkBrowserItem *addItem(const NetworkItemPtr &item);
+    void removeItem(Smb4KNetworkBrowserItem *browserItem);
+    static QString itemKey(const NetworkItemPtr &item);
     Smb4KNetworkBrowser *m_networkBrowser;
     KActionCollection *m_actionCollection;
     KActionMenu *m_contextMenu;
     Smb4KNetworkSearchToolBar *m_searchToolBar;
     bool m_searchRunning;
+    QHash<QString, Smb4KNetworkBrowserItem *> m_items;
+    QHash<const Smb4KBasicNetworkItem *, QString> m_itemKeys;
 };
 
 #endif
@@ -67,6 +67,8 @@ Smb4KNetworkBrowserItem::Smb4KNetworkBrowserItem(QTreeWidget *parent, const Netw
         break;
     }
     }
+
+    updateStaleState();
 }
 
 Smb4KNetworkBrowserItem::Smb4KNetworkBrowserItem(QTreeWidgetItem *parent, const NetworkItemPtr &item)
@@ -117,6 +119,8 @@ Smb4KNetworkBrowserItem::Smb4KNetworkBrowserItem(QTreeWidgetItem *parent, const
         break;
     }
     }
+
+    updateStaleState();
 }
 
 Smb4KNetworkBrowserItem::~Smb4KNetworkBrowserItem()
@@ -203,4 +207,20 @@ void Smb4KNetworkBrowserItem::update()
         break;
     }
     }
+
+    updateStaleState();
+}
+
+void Smb4KNetworkBrowserItem::updateStaleState()
+{
+    if (m_item->isStale()) {
+        for (int i = 0; i < columnCount(); ++i) {
+            setForeground(i, QApplication::palette().brush(QPalette::Disabled, QPalette::Text));
+        }
+    } else if (m_item->type() != Host) {
+        // The color of hosts is set according to their master browser state
+        for (int i = 0; i < columnCount(); ++i) {
+            setForeground(i, QApplication::palette().text());
+        }
+    }
 }
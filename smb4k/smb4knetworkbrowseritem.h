@@ -97,6 +97,12 @@ public:
     void update();
 
 private:
+    /**
+     * Grey out the item if it was loaded from the browse cache and was not
+     * confirmed by a scan yet. Otherwise restore the text color.
+     */
+    void updateStaleState();
+
     /**
      * The network item
      */
@@ -48,7 +48,8 @@ public:
     void setActiveState(bool active);
 
     /**
-     * Set the search result
+     * Add search results. This function might be called several times
+     * while the search is running.
      *
      * @param list            The list of search results
      */
@@ -13,11 +13,12 @@
 
 // Qt includes
 #include <QDialogButtonBox>
-#include <QMap>
+#include <QLocale>
 #include <QVBoxLayout>
 
 // KDE includes
 #include <KConfigGroup>
+#include <KIO/Global>
 #include <KLocalizedString>
 #include <KWindowConfig>
 #include <QToolBar>
@@ -149,6 +150,12 @@ void Smb4KPreviewDialog::loadPreview(const NetworkItemPtr &networkItem)
 
     m_currentItem = networkItem;
 
+    //
+    // The results arrive in portions, so clear the list beforehand
+    //
+    m_listWidget->clear();
+    m_upAction->setEnabled(!m_currentItem->url().matches(m_share->url(), QUrl::StripTrailingSlash));
+
     Smb4KClient::self()->lookupFiles(networkItem);
 }
 
@@ -175,41 +182,52 @@ void Smb4KPreviewDialog::slotItemActivated(QListWidgetItem *item)
     }
 }
 
-void Smb4KPreviewDialog::slotPreviewResults(const QList<FilePtr> &files)
+void Smb4KPreviewDialog::slotPreviewResults(const NetworkItemPtr &item, const QList<FilePtr> &files)
 {
-    if (!files.first()->url().toString().startsWith(m_share->url().toString())) {
+    if (!m_currentItem || !item->url().matches(m_currentItem->url(), QUrl::RemoveUserInfo | QUrl::StripTrailingSlash)) {
         return;
     }
 
-    if (m_listWidget->count() != 0) {
-        m_listWidget->clear();
-    }
-
-    QMap<QString, QListWidgetItem *> sortingMap;
-
+    //
+    // Insert the items at their sorted position, directories first. The
+    // sorting key is stored with the item, since the list is filled in
+    // several portions.
+    //
     for (const FilePtr &file : files) {
         QVariant variant = QVariant::fromValue(*file.data());
+        QString sortingKey = (file->isDirectory() ? QStringLiteral("00_") : QStringLiteral("01_")) + file->name();
+
+        QListWidgetItem *listItem = new QListWidgetItem();
+        listItem->setText(file->name());
+        listItem->setIcon(file->icon());
+        listItem->setData(Qt::UserRole, variant);
+        listItem->setData(Qt::UserRole + 1, sortingKey);
+
+        if (file->lastModified().isValid()) {
+            if (file->isDirectory()) {
+                listItem->setToolTip(i18n("Modified: %1", QLocale().toString(file->lastModified(), QLocale::ShortFormat)));
+            } else {
+                listItem->setToolTip(i18n("Size: %1\nModified: %2",
+                                          KIO::convertSize(file->size()),
+                                          QLocale().toString(file->lastModified(), QLocale::ShortFormat)));
+            }
+        }
 
-        QListWidgetItem *item = new QListWidgetItem();
-        item->setText(file->name());
-        item->setIcon(file->icon());
-        item->setData(Qt::UserRole, variant);
+        int first = 0;
+        int last = m_listWidget->count();
 
-        if (file->isDirectory()) {
-            sortingMap[QStringLiteral("00_") + file->name()] = item;
-        } else {
-            sortingMap[QStringLiteral("01_") + file->name()] = item;
-        }
-    }
+        while (first < last) {
+            int middle = (first + last) / 2;
 
-    QMapIterator<QString, QListWidgetItem *> it(sortingMap);
+            if (m_listWidget->item(middle)->data(Qt::UserRole + 1).toString() < sortingKey) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
 
-    while (it.hasNext()) {
-        it.next();
-        m_listWidget->addItem(it.value());
+        m_listWidget->insertItem(first, listItem);
     }
-
-    m_upAction->setEnabled(!m_currentItem->url().matches(m_share->url(), QUrl::StripTrailingSlash));
 }
 
 void Smb4KPreviewDialog::slotReloadActionTriggered(bool checked)
@@ -52,7 +52,7 @@ public Q_SLOTS:
 protected Q_SLOTS:
     void slotCloseButtonClicked();
     void slotItemActivated(QListWidgetItem *item);
-    void slotPreviewResults(const QList<FilePtr> &files);
+    void slotPreviewResults(const NetworkItemPtr &item, const QList<FilePtr> &files);
     void slotReloadActionTriggered(bool checked);
     void slotUpActionTriggered();
     void slotUrlActivated(const QUrl &url);
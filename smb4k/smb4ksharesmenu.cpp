@@ -83,7 +83,9 @@ void Smb4KSharesMenu::refreshMenu()
     // Add share menus, if necessary
     //
     if (!mountedSharesList().isEmpty()) {
-        for (const SharePtr &share : std::as_const(mountedSharesList())) {
+        const QList<SharePtr> mountedShares = mountedSharesList();
+
+        for (const SharePtr &share : mountedShares) {
             addShareToMenu(share);
         }
     }